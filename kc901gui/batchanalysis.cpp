@@ -0,0 +1,294 @@
+#include "batchanalysis.h"
+#include "sweeparchive.h"
+#include <QFile>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <qnumeric.h>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+static const qreal NaN = std::numeric_limits<qreal>::quiet_NaN();
+static const char *DefaultKpis = "resonance\nbandwidth 10\nmaxvswr\n";
+
+class BatchAnalysis::Worker : public QRunnable
+{
+public:
+    explicit Worker(BatchAnalysis *analysis) : analysis(analysis) {}
+    void run() { analysis->work(); }
+
+private:
+    BatchAnalysis *analysis;
+};
+
+BatchAnalysis::BatchAnalysis() :
+    archive(0),
+    rowOut(0),
+    valueOut(0),
+    m_bins(20),
+    m_threads(0),
+    m_elapsed(0)
+{
+}
+
+bool BatchAnalysis::run(const Options &options, QString *error)
+{
+    if(!options.limits.isEmpty() && !mask.load(options.limits, error)) return false;
+    QString text = DefaultKpis;
+    if(!options.kpis.isEmpty())
+    {
+        QFile file(options.kpis);
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            if(error) *error = file.errorString();
+            return false;
+        }
+        text = QString::fromUtf8(file.readAll());
+    }
+    if(!kpis.parse(text, error)) return false;
+    names = kpis.names();
+    m_bins = qMax(1, options.bins);
+
+    SweepArchive reader;
+    if(!reader.open(options.archive, error)) return false;
+    if(!reader.map())
+    {
+        if(error) *error = QString("cannot map %1").arg(options.archive);
+        return false;
+    }
+    Row untested = { 0, -1, 0, NaN };
+    rows.fill(untested, reader.count());
+    values.fill(NaN, reader.count() * names.size());
+    //the workers write through these, the vectors are not touched until they are done
+    archive = &reader;
+    rowOut = rows.data();
+    valueOut = values.data();
+    nextBlock.store(0);
+    badBlocks.store(0);
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    if(options.threads > 0)
+        pool->setMaxThreadCount(options.threads);
+    m_threads = pool->maxThreadCount();
+    QElapsedTimer timer;
+    timer.start();
+    for(int t = 0; t < m_threads; t++)
+        pool->start(new Worker(this));
+    pool->waitForDone();
+    m_elapsed = timer.elapsed();
+    archive = 0;
+    rowOut = 0;
+    valueOut = 0;
+    return true;
+}
+
+void BatchAnalysis::work()
+//one pool thread, takes blocks until none are left
+{
+    LimitMask localMask(mask);
+    KpiExtractor localKpis(kpis);
+    int columns = names.size();
+    //decoded into the buffers of this worker, nothing shared per sweep
+    QVector<Sweep> sweeps;
+    QVector<qint64> times;
+    QVector<qreal> samples;
+    for(;;)
+    {
+        int b = nextBlock.fetchAndAddRelaxed(1);
+        if(b >= archive->blockCount()) break;
+        if(!archive->readBlock(b, &sweeps, &times, &samples))
+        {
+            badBlocks.ref();
+            continue;
+        }
+        int first = archive->blockFirst(b);
+        for(int s = 0; s < sweeps.size(); s++)
+        {
+            const Sweep &sweep = sweeps[s];
+            Row &row = rowOut[first + s];
+            row.time = times[s];
+            if(!localMask.isEmpty())
+            {
+                //the column of the mask unit, the verdict of the gui for the same trace
+                const QVector<qreal> *trace = localMask.column(sweep);
+                if(trace)
+                {
+                    LimitMask::Result result = localMask.test(sweep.freq(), *trace);
+                    row.pass = result.pass ? 1 : 0;
+                    row.failPoints = result.failPoints;
+                    row.margin = result.worstMargin;
+                }
+                else
+                    row.pass = -2;
+            }
+            //the kpis are s11 figures, s21 sweeps are only tested
+            if(sweep.kind() == Sweep::S21) continue;
+            const QVector<qreal> &kpi = localKpis.extract(sweep);
+            for(int k = 0; k < columns; k++)
+                valueOut[(first + s) * columns + k] = kpi[k];
+        }
+    }
+}
+
+void BatchAnalysis::report(QTextStream &out) const
+{
+    int n = rows.size();
+    int columns = names.size();
+    out << QString("%1 sweeps, %2 threads, %3 ms, %4 sweeps/s\n")
+           .arg(n).arg(m_threads).arg(m_elapsed).arg(m_elapsed > 0 ? qint64(n) * 1000 / m_elapsed : n);
+    if(badBlocks.load() > 0)
+        out << QString("%1 damaged blocks skipped\n").arg(badBlocks.load());
+
+    if(!mask.isEmpty())
+    {
+        int tested = 0, passed = 0, other = 0;
+        qreal worst = NaN;
+        for(int i = 0; i < n; i++)
+        {
+            if(rows[i].pass == -2) other++;
+            if(rows[i].pass < 0) continue;
+            tested++;
+            passed += rows[i].pass;
+            if(qIsNaN(worst) || rows[i].margin < worst) worst = rows[i].margin;
+        }
+        out << QString("yield %1 / %2 = %3 %, worst margin %4 dB\n")
+               .arg(passed).arg(tested).arg(tested > 0 ? 100.0 * passed / tested : 0.0, 0, 'f', 2)
+               .arg(worst, 0, 'g', 4);
+        if(other > 0)
+            out << QString("%1 sweeps not tested, the mask is in %2\n").arg(other)
+                   .arg(LimitMask::unitName(mask.unit()));
+    }
+
+    //one sorted column per kpi, NaN left out
+    QVector<QVector<qreal> > sorted(columns);
+    for(int k = 0; k < columns; k++)
+    {
+        sorted[k].reserve(n);
+        for(int i = 0; i < n; i++)
+        {
+            qreal v = values[i * columns + k];
+            if(!qIsNaN(v)) sorted[k].append(v);
+        }
+        std::sort(sorted[k].begin(), sorted[k].end());
+    }
+
+    out << QString("\n%1 %2 %3 %4 %5 %6 %7\n").arg("kpi", -24).arg("count", 8).arg("mean", 12)
+           .arg("std", 12).arg("min", 12).arg("median", 12).arg("max", 12);
+    for(int k = 0; k < columns; k++)
+    {
+        const QVector<qreal> &v = sorted[k];
+        out << QString("%1 %2").arg(names[k], -24).arg(v.size(), 8);
+        if(v.isEmpty())
+        {
+            out << "\n";
+            continue;
+        }
+        qreal sum = 0, squares = 0;
+        for(int i = 0; i < v.size(); i++)
+            sum += v[i];
+        qreal mean = sum / v.size();
+        for(int i = 0; i < v.size(); i++)
+            squares += (v[i] - mean) * (v[i] - mean);
+        qreal deviation = v.size() > 1 ? sqrt(squares / (v.size() - 1)) : 0;
+        out << QString(" %1 %2 %3 %4 %5\n").arg(mean, 12, 'g', 6).arg(deviation, 12, 'g', 6)
+               .arg(v.first(), 12, 'g', 6).arg(v[v.size() / 2], 12, 'g', 6).arg(v.last(), 12, 'g', 6);
+    }
+
+    for(int k = 0; k < columns; k++)
+    {
+        const QVector<qreal> &v = sorted[k];
+        if(v.isEmpty()) continue;
+        qreal low = v.first(), high = v.last();
+        int bins = high > low ? m_bins : 1;
+        QVector<int> counts(bins, 0);
+        for(int i = 0; i < v.size(); i++)
+            counts[qMin(bins - 1, int((v[i] - low) / (high - low) * bins))]++;
+        int largest = *std::max_element(counts.constBegin(), counts.constEnd());
+        out << "\n" << names[k] << "\n";
+        for(int b = 0; b < bins; b++)
+        {
+            qreal from = low + (high - low) * b / bins, to = low + (high - low) * (b + 1) / bins;
+            out << QString("%1 .. %2 %3 %4\n").arg(from, 12, 'g', 6).arg(to, -12, 'g', 6).arg(counts[b], 8)
+                   .arg(QString(counts[b] * 50 / largest, '#'));
+        }
+    }
+    out.flush();
+}
+
+bool BatchAnalysis::writeCsv(const QString &fileName, QString *error) const
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        if(error) *error = file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    int columns = names.size();
+    out << "sweep,time,result,fail points,margin";
+    for(int k = 0; k < columns; k++)
+        out << ',' << names[k];
+    out << '\n';
+    for(int i = 0; i < rows.size(); i++)
+    {
+        const Row &row = rows[i];
+        out << i << ',' << QDateTime::fromMSecsSinceEpoch(row.time).toString("yyyy-MM-dd hh:mm:ss.zzz") << ','
+            << (row.pass == -2 ? "UNIT" : row.pass < 0 ? "" : row.pass ? "PASS" : "FAIL") << ',' << row.failPoints << ',';
+        if(!qIsNaN(row.margin)) out << row.margin;
+        for(int k = 0; k < columns; k++)
+        {
+            qreal v = values[i * columns + k];
+            out << ',';
+            if(!qIsNaN(v)) out << v;
+        }
+        out << '\n';
+    }
+    return true;
+}
+
+int BatchAnalysis::main(const QStringList &arguments)
+{
+    Options options;
+    options.threads = 0;
+    options.bins = 20;
+    QTextStream err(stderr);
+    bool ok = true;
+    for(int i = 1; ok && i < arguments.size(); i += 2)
+    {
+        const QString &option = arguments[i];
+        QString value = arguments.value(i + 1);
+        ok = !value.isEmpty();
+        if(option == "--batch") options.archive = value;
+        else if(option == "--limits") options.limits = value;
+        else if(option == "--kpis") options.kpis = value;
+        else if(option == "--csv") options.csv = value;
+        else if(option == "--threads") options.threads = value.toInt(&ok);
+        else if(option == "--bins") options.bins = value.toInt(&ok);
+        else ok = false;
+    }
+    if(!ok || options.archive.isEmpty())
+    {
+        err << "usage: kc901 --batch <archive> [--limits <mask>] [--kpis <file>]"
+               " [--csv <file>] [--threads <n>] [--bins <n>]\n";
+        return 2;
+    }
+
+    BatchAnalysis analysis;
+    QString error;
+    if(!analysis.run(options, &error))
+    {
+        err << error << "\n";
+        return 1;
+    }
+    QTextStream out(stdout);
+    analysis.report(out);
+    if(!options.csv.isEmpty() && !analysis.writeCsv(options.csv, &error))
+    {
+        err << error << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef BATCHANALYSIS_H
+#define BATCHANALYSIS_H
+
+#include <QVector>
+#include <QStringList>
+#include <QAtomicInt>
+#include "limitmask.h"
+#include "kpiextractor.h"
+
+class SweepArchive;
+class QTextStream;
+
+/// Offline analysis of a recorded sweep archive on all cores
+/**
+    kc901 --batch <archive> [--limits <mask>] [--kpis <file>]
+          [--csv <file>] [--threads <n>] [--bins <n>]
+
+Every sweep of the archive is one DUT. It is tested against the limit
+mask if it carries the unit of the mask (vswr, db or s21, not the view
+processed phase and delay), and its KPIs are extracted, KpiExtractor
+syntax, resonance, bandwidth 10 and maxvswr without --kpis. The report
+is the yield, a table of the KPIs over all DUTs and a text histogram per
+KPI; --csv adds one line per DUT.
+
+The archive is memory mapped and decoded a block at a time. Blocks are
+handed out from an atomic counter to one worker per pool thread, a
+worker that is done takes the next one. Workers own their mask and
+extractor and write only the rows of their blocks, so the report does
+not depend on the thread count. A worker decodes into sweeps and a
+sample buffer of its own that are refilled block after block, the only
+shared state per block is the counter. tests/batchscaling prints the
+sweeps/s and speedup at 1, 2, 4... threads on a generated archive.
+*/
+class BatchAnalysis
+{
+public:
+    struct Options {
+        QString archive;
+        QString limits;
+        QString kpis;
+        QString csv;
+        int threads;        // 0 for the pool default
+        int bins;
+    };
+
+    struct Row {
+        qint64 time;
+        int pass;           // 1 pass, 0 fail, -1 without a mask, -2 mask of another unit
+        int failPoints;
+        qreal margin;
+    };
+
+    BatchAnalysis();
+
+    bool run(const Options &options, QString *error);
+    void report(QTextStream &out) const;
+    bool writeCsv(const QString &fileName, QString *error) const;
+
+    /// Entry point of --batch, returns the exit code
+    static int main(const QStringList &arguments);
+
+private:
+    class Worker;
+
+    void work();
+
+    // valid while run() waits for the workers
+    const SweepArchive *archive;
+    Row *rowOut;
+    qreal *valueOut;
+    LimitMask mask;
+    KpiExtractor kpis;
+    QStringList names;
+    int m_bins;
+    int m_threads;
+    qint64 m_elapsed;
+
+    QAtomicInt nextBlock;
+    QAtomicInt badBlocks;
+    // one row per sweep, kpi values row major
+    QVector<Row> rows;
+    QVector<qreal> values;
+};
+
+#endif // BATCHANALYSIS_H
@@ -0,0 +1,52 @@
+#include "cachedplotgrid.h"
+#include "qwt_plot.h"
+#include <QPainter>
+
+static bool sameMap(const QwtScaleMap &a, const QwtScaleMap &b)
+{
+    return a.s1() == b.s1() && a.s2() == b.s2() && a.p1() == b.p1() && a.p2() == b.p2();
+}
+
+CachedPlotGrid::CachedPlotGrid() :
+    QwtPlotGrid(),
+    cacheValid(false)
+{
+}
+
+void CachedPlotGrid::itemChanged()
+{
+    //pens or grid divisions changed
+    cacheValid = false;
+    QwtPlotGrid::itemChanged();
+}
+
+void CachedPlotGrid::draw(QPainter *painter,
+    const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+    const QRectF &canvasRect) const
+{
+    //a scaled painter (printing, export) gets the vector grid
+    if(!plot() || painter->transform().isScaling())
+    {
+        QwtPlotGrid::draw(painter, xMap, yMap, canvasRect);
+        return;
+    }
+
+    QSize size = canvasRect.toAlignedRect().size();
+    if(!cacheValid || cache.size() != size || cacheRect != canvasRect
+            || !sameMap(xMap, cacheXMap) || !sameMap(yMap, cacheYMap))
+    {
+        cache = QPixmap(size);
+        cache.fill(Qt::transparent);
+        QPainter p(&cache);
+        p.translate(-canvasRect.topLeft());
+        p.setRenderHints(painter->renderHints());
+        QwtPlotGrid::draw(&p, xMap, yMap, canvasRect);
+        p.end();
+
+        cacheXMap = xMap;
+        cacheYMap = yMap;
+        cacheRect = canvasRect;
+        cacheValid = true;
+    }
+    painter->drawPixmap(canvasRect.toAlignedRect().topLeft(), cache);
+}
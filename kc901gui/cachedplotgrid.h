@@ -0,0 +1,33 @@
+#ifndef CACHEDPLOTGRID_H
+#define CACHEDPLOTGRID_H
+
+#include <QPixmap>
+#include "qwt_plot_grid.h"
+#include "qwt_scale_map.h"
+
+/// Grid that is rendered once into a pixmap
+/**
+The pixmap holds the grid lines on a transparent background. It is
+rebuilt only when the scales, the canvas size or the grid
+itself change, so a replot driven by new sweep data costs one blit for
+the grid instead of redrawing every major / minor line.
+*/
+class CachedPlotGrid : public QwtPlotGrid
+{
+public:
+    CachedPlotGrid();
+
+    virtual void draw(QPainter *painter,
+        const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+        const QRectF &canvasRect) const;
+
+    virtual void itemChanged();
+
+private:
+    mutable QPixmap cache;
+    mutable QwtScaleMap cacheXMap, cacheYMap;
+    mutable QRectF cacheRect;
+    mutable bool cacheValid;
+};
+
+#endif // CACHEDPLOTGRID_H
@@ -0,0 +1,83 @@
+#include "fastplotcurve.h"
+#include "qwt_scale_map.h"
+#include <QPainter>
+#include <math.h>
+
+FastPlotCurve::FastPlotCurve(const QString &title) :
+    QwtPlotCurve(title),
+    m_fast(false)
+{
+}
+
+void FastPlotCurve::setFastMode(bool on)
+{
+    m_fast = on;
+    setCurveAttribute(QwtPlotCurve::Fitted, false);
+    setRenderHint(QwtPlotItem::RenderAntialiased, !on);
+}
+
+void FastPlotCurve::drawLines(QPainter *painter,
+    const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+    const QRectF &canvasRect, int from, int to) const
+{
+    if(!m_fast || testCurveAttribute(QwtPlotCurve::Fitted))
+    {
+        QwtPlotCurve::drawLines(painter, xMap, yMap, canvasRect, from, to);
+        return;
+    }
+
+    //keep far off values (vswr near infinity) inside what the rasterizer handles
+    const qreal yLow = canvasRect.top() - canvasRect.height();
+    const qreal yHigh = canvasRect.bottom() + canvasRect.height();
+
+    polygon.resize(0);
+    int column = 0;
+    int count = 0;
+    qreal first = 0, last = 0, min = 0, max = 0;
+    int minAt = 0, maxAt = 0;
+    const QwtSeriesData<QPointF> *series = data();
+    for(int i = from; i <= to + 1; i++)
+    {
+        int c = column;
+        qreal y = 0;
+        if(i <= to)
+        {
+            const QPointF sample = series->sample(i);
+            qreal x = xMap.transform(sample.x());
+            y = yMap.transform(sample.y());
+            if(isnan(x) || isnan(y)) continue;
+            y = qBound(yLow, y, yHigh);
+            c = int(floor(x));
+            if(count > 0 && c == column)
+            {
+                if(y < min) { min = y; minAt = count; }
+                if(y > max) { max = y; maxAt = count; }
+                last = y;
+                count++;
+                continue;
+            }
+        }
+
+        //flush the column, min and max in the order they were reached
+        if(count > 0)
+        {
+            polygon.append(QPointF(column, first));
+            if(count > 1)
+            {
+                polygon.append(QPointF(column, minAt < maxAt ? min : max));
+                polygon.append(QPointF(column, minAt < maxAt ? max : min));
+                polygon.append(QPointF(column, last));
+            }
+        }
+        column = c;
+        first = last = min = max = y;
+        minAt = maxAt = 0;
+        count = 1;
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(pen());
+    painter->drawPolyline(polygon);
+    painter->restore();
+}
@@ -0,0 +1,32 @@
+#ifndef FASTPLOTCURVE_H
+#define FASTPLOTCURVE_H
+
+#include <QPolygonF>
+#include "qwt_plot_curve.h"
+
+/// Curve with a decimating, non antialiased line renderer
+/**
+In fast mode every pixel column of the canvas gets at most four
+vertices (first, min, max, last sample in that column), so the polyline
+handed to the raster engine is bounded by the canvas width instead of
+the number of sweep points. The vertex buffer is reused between frames.
+*/
+class FastPlotCurve : public QwtPlotCurve
+{
+public:
+    explicit FastPlotCurve(const QString &title = QString());
+
+    void setFastMode(bool on);
+    bool fastMode() const { return m_fast; }
+
+protected:
+    virtual void drawLines(QPainter *painter,
+        const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+        const QRectF &canvasRect, int from, int to) const;
+
+private:
+    bool m_fast;
+    mutable QPolygonF polygon;
+};
+
+#endif // FASTPLOTCURVE_H
@@ -0,0 +1,334 @@
+#include "goldenscore.h"
+#include <QRegExp>
+#include <QStringList>
+#include <qnumeric.h>
+#include <limits>
+#include <math.h>
+
+static const qreal NaN = std::numeric_limits<qreal>::quiet_NaN();
+
+static void fft(qreal *re, qreal *im, int n, bool inverse)
+//in place, radix 2, n a power of two, not scaled
+{
+    for(int i = 1, j = 0; i < n; i++)
+    {
+        int bit = n >> 1;
+        for(; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if(i < j)
+        {
+            qSwap(re[i], re[j]);
+            qSwap(im[i], im[j]);
+        }
+    }
+    for(int len = 2; len <= n; len <<= 1)
+    {
+        qreal angle = (inverse ? 2 : -2) * M_PI / len;
+        qreal wr = cos(angle), wi = sin(angle);
+        int half = len / 2;
+        for(int i = 0; i < n; i += len)
+        {
+            qreal ur = 1, ui = 0;
+            for(int k = i; k < i + half; k++)
+            {
+                qreal tr = re[k + half] * ur - im[k + half] * ui;
+                qreal ti = re[k + half] * ui + im[k + half] * ur;
+                re[k + half] = re[k] - tr;
+                im[k + half] = im[k] - ti;
+                re[k] += tr;
+                im[k] += ti;
+                qreal t = ur * wr - ui * wi;
+                ui = ur * wi + ui * wr;
+                ur = t;
+            }
+        }
+    }
+}
+
+GoldenScore::GoldenScore() :
+    m_dirty(true),
+    m_serial(0),
+    m_points(0),
+    m_fstart(0),
+    m_fstop(0),
+    m_distance(NaN)
+{
+}
+
+bool GoldenScore::parseBands(const QString &text, QString *error)
+{
+    QVector<Band> parsed;
+    QStringList lines = text.split('\n');
+    for(int lineNumber = 1; lineNumber <= lines.size(); lineNumber++)
+    {
+        QString line = lines[lineNumber-1].trimmed();
+        if(line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList fields = line.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+        Band band;
+        bool startOk, stopOk, weightOk = true;
+        //separators only leave no fields, value() turns that into a bad start
+        band.start = fields.value(0).toDouble(&startOk) * 1e6;
+        band.stop = fields.value(1).toDouble(&stopOk) * 1e6;
+        band.weight = fields.size() > 2 ? fields[2].toDouble(&weightOk) : 1.0;
+        if(!startOk || !stopOk || !weightOk || fields.size() > 3
+                || band.stop <= band.start || band.weight <= 0)
+        {
+            if(error) *error = QString("line %1: %2").arg(lineNumber).arg(line);
+            return false;
+        }
+        parsed.append(band);
+    }
+
+    m_bands = parsed;
+    m_dirty = true;
+    return true;
+}
+
+void GoldenScore::setGolden(const Sweep &sweep)
+{
+    m_golden = sweep;
+    m_dirty = true;
+}
+
+void GoldenScore::clear()
+{
+    m_golden = Sweep();
+    m_dirty = true;
+    m_distance = NaN;
+    results.clear();
+    resampler.clear();
+}
+
+void GoldenScore::prepare(const QVector<qreal> &freq)
+{
+    int n = freq.size();
+    if(!m_dirty && m_serial == m_golden.serial() && n == m_points
+            && freq.first() == m_fstart && freq.last() == m_fstop)
+        return;
+
+    if(m_golden.kind() == Sweep::Ri)
+    {
+        goldRi = resampler.resample(m_golden.freq(), m_golden.ri(), freq);
+        goldDb.resize(n);
+        for(int i = 0; i < n; i++)
+            goldDb[i] = 10*log10(qMax(goldRi[i].x()*goldRi[i].x() + goldRi[i].y()*goldRi[i].y(), 1e-30));
+    }
+    else
+    {
+        goldRi.clear();
+        goldDb = resampler.resample(m_golden.freq(), m_golden.db(), freq);
+    }
+
+    //points outside all bands do not count, overlapping bands take the larger weight
+    int bands = qMax(m_bands.size(), 1);
+    weight.fill(m_bands.isEmpty() ? 1.0 : 0.0, n);
+    first.fill(0, bands);
+    last.fill(-1, bands);
+    for(int b = 0; b < bands; b++)
+    {
+        if(m_bands.isEmpty())
+        {
+            last[b] = n - 1;
+        }
+        else
+        {
+            const Band &band = m_bands[b];
+            int i = 0;
+            while(i < n && freq[i] < band.start) i++;
+            first[b] = i;
+            while(i < n && freq[i] <= band.stop)
+            {
+                weight[i] = qMax(weight[i], band.weight);
+                i++;
+            }
+            last[b] = i - 1;
+        }
+    }
+    goldSum.resize(n + 1);
+    goldSquares.resize(n + 1);
+    goldSum[0] = goldSquares[0] = 0;
+    for(int i = 0; i < n; i++)
+    {
+        goldSum[i+1] = goldSum[i] + goldDb[i];
+        goldSquares[i+1] = goldSquares[i] + goldDb[i] * goldDb[i];
+    }
+
+    //the lags of a band and the spectrum of its golden window without the mean, fixed for the grid
+    searches.resize(bands);
+    int spectrum = 0, maxSize = 0;
+    for(int b = 0; b < bands; b++)
+    {
+        Search &s = searches[b];
+        s.size = 0;
+        int lo = first[b], count = last[b] - lo + 1;
+        //a band at the end of the sweep is trimmed to leave room for the lags
+        int reach = qMin(MaxLag, count / 4);
+        int from = qMax(lo, reach), to = qMin(lo + count, n - reach);
+        int window = to - from;
+        if(reach < 1 || window < 3) continue;
+        qreal goldMean = (goldSum[to] - goldSum[from]) / window;
+        qreal goldVar = goldSquares[to] - goldSquares[from] - goldMean * goldMean * window;
+        if(goldVar <= 1e-12 * window) continue;
+        s.from = from;
+        s.window = window;
+        s.lagMin = qMax(-reach, -from);
+        s.lags = qMin(reach, n - to) - s.lagMin + 1;
+        s.goldVar = goldVar;
+        //long enough for the segment the window slides over, so no lag wraps around
+        s.size = 1;
+        while(s.size < s.lags + window - 1)
+            s.size <<= 1;
+        s.spectrum = spectrum;
+        spectrum += s.size;
+        maxSize = qMax(maxSize, s.size);
+    }
+    goldRe.resize(spectrum);
+    goldIm.resize(spectrum);
+    for(int b = 0; b < bands; b++)
+    {
+        const Search &s = searches[b];
+        if(s.size == 0) continue;
+        qreal *gr = goldRe.data() + s.spectrum, *gi = goldIm.data() + s.spectrum;
+        qreal goldMean = (goldSum[s.from + s.window] - goldSum[s.from]) / s.window;
+        for(int k = 0; k < s.size; k++)
+        {
+            gr[k] = k < s.window ? goldDb[s.from + k] - goldMean : 0;
+            gi[k] = 0;
+        }
+        fft(gr, gi, s.size, false);
+        for(int k = 0; k < s.size; k++)
+            gi[k] = -gi[k];
+    }
+    segRe.resize(maxSize);
+    segIm.resize(maxSize);
+
+    errSum.resize(n + 1);
+    dbSum.resize(n + 1);
+    dbSquares.resize(n + 1);
+    results.resize(bands);
+    m_dirty = false;
+    m_serial = m_golden.serial();
+    m_points = n;
+    m_fstart = freq.first();
+    m_fstop = freq.last();
+}
+
+bool GoldenScore::compare(const Sweep &sweep)
+{
+    m_distance = NaN;
+    if(m_golden.isNull() || sweep.kind() != m_golden.kind() || sweep.size() < 2) return false;
+
+    const QVector<qreal> &freq = sweep.freq();
+    int n = freq.size();
+    prepare(freq);
+
+    //the single pass: weighted error, running sums of the error and the trace
+    bool complex = sweep.kind() == Sweep::Ri;
+    const QPointF *ri = complex ? sweep.ri().constData() : 0;
+    const QPointF *gri = goldRi.constData();
+    const qreal *db = sweep.db().constData();
+    const qreal *gdb = goldDb.constData();
+    const qreal *w = weight.constData();
+    qreal *es = errSum.data(), *ds = dbSum.data(), *dss = dbSquares.data();
+    qreal total = 0, totalWeight = 0;
+    es[0] = ds[0] = dss[0] = 0;
+    for(int i = 0; i < n; i++)
+    {
+        qreal e2;
+        if(complex)
+        {
+            qreal er = ri[i].x() - gri[i].x(), ei = ri[i].y() - gri[i].y();
+            e2 = er*er + ei*ei;
+        }
+        else
+            e2 = (db[i] - gdb[i]) * (db[i] - gdb[i]);
+        total += w[i] * e2;
+        totalWeight += w[i];
+        es[i+1] = es[i] + e2;
+        ds[i+1] = ds[i] + db[i];
+        dss[i+1] = dss[i] + db[i] * db[i];
+    }
+    //rms of the error vector in dB, of the dB error as is
+    qreal scale = complex ? 10 : 1;
+    if(totalWeight > 0)
+        m_distance = complex ? scale * log10(qMax(total / totalWeight, 1e-30)) : sqrt(total / totalWeight);
+
+    for(int b = 0; b < results.size(); b++)
+    {
+        BandResult &r = results[b];
+        r.rms = r.shift = r.correlation = NaN;
+        r.atLimit = false;
+        int lo = first[b], count = last[b] - lo + 1;
+        if(count <= 0) continue;
+        qreal ms = (es[lo + count] - es[lo]) / count;
+        r.rms = complex ? scale * log10(qMax(ms, 1e-30)) : sqrt(ms);
+
+        const Search &s = searches[b];
+        if(s.size == 0) continue;
+        //the segment the golden window slides over, zero padded, times the golden spectrum:
+        //the dot products of all lags in one pass
+        const qreal *seg = db + s.from + s.lagMin;
+        int length = s.lags + s.window - 1;
+        qreal *sr = segRe.data(), *si = segIm.data();
+        for(int k = 0; k < s.size; k++)
+        {
+            sr[k] = k < length ? seg[k] : 0;
+            si[k] = 0;
+        }
+        fft(sr, si, s.size, false);
+        const qreal *gr = goldRe.constData() + s.spectrum, *gi = goldIm.constData() + s.spectrum;
+        for(int k = 0; k < s.size; k++)
+        {
+            qreal re = sr[k] * gr[k] - si[k] * gi[k];
+            si[k] = sr[k] * gi[k] + si[k] * gr[k];
+            sr[k] = re;
+        }
+        fft(sr, si, s.size, true);
+
+        //normalized by the running sums of the trace under the window
+        corr.resize(s.lags);
+        int best = 0;
+        for(int j = 0; j < s.lags; j++)
+        {
+            int at = s.from + s.lagMin + j;
+            qreal sum = ds[at + s.window] - ds[at];
+            qreal var = dss[at + s.window] - dss[at] - sum * sum / s.window;
+            corr[j] = var > 0 ? sr[j] / s.size / sqrt(var * s.goldVar) : -1;
+            if(corr[j] > corr[best]) best = j;
+        }
+        qreal offset = 0;
+        if(best > 0 && best < s.lags - 1)
+        {
+            qreal cm = corr[best - 1], c0 = corr[best], cp = corr[best + 1];
+            qreal curvature = cm - 2 * c0 + cp;
+            if(curvature < 0) offset = 0.5 * (cm - cp) / curvature;
+        }
+        else
+            r.atLimit = true;
+        qreal step = (freq[s.from + s.window - 1] - freq[s.from]) / (s.window - 1);
+        r.shift = (s.lagMin + best + offset) * step;
+        r.correlation = corr[best];
+    }
+    return true;
+}
+
+QString GoldenScore::summary() const
+{
+    QString text;
+    for(int b = 0; b < results.size(); b++)
+    {
+        const BandResult &r = results[b];
+        if(m_bands.isEmpty())
+            text += QString("%1").arg("sweep", -15);
+        else
+            text += QString("%1-%2").arg(m_bands[b].start / 1e6, 7, 'f', 1).arg(m_bands[b].stop / 1e6, -7, 'f', 1);
+        text += QString(" %1 dB").arg(r.rms, 7, 'f', 2);
+        if(!qIsNaN(r.shift))
+            text += QString(" %1%2%3 MHz").arg(r.atLimit ? ">" : " ").arg(r.shift >= 0 ? "+" : "")
+                    .arg(r.shift / 1e6, 0, 'f', 3);
+        text += "\n";
+    }
+    return text;
+}
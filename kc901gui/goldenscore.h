@@ -0,0 +1,116 @@
+#ifndef GOLDENSCORE_H
+#define GOLDENSCORE_H
+
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include "sweep.h"
+#include "traceresampler.h"
+
+/// Distance of every sweep to a golden unit, for tuning by hand
+/**
+The golden sweep is resampled onto the live grid once per grid. Bands
+are given one per line, in MHz, with an optional weight:
+
+    # f1 f2 [weight]
+    890 915
+    935 960 2
+
+Without bands the whole sweep is one band of weight one, with bands the
+points outside of them do not count.
+
+The error is the complex difference to the golden reflection for RI
+sweeps and the dB difference for scalar ones. The score is its weighted
+rms, in dB of the error vector for RI and in dB for scalar sweeps, and
+the same per band. Error and the running sums of the trace in dB are
+taken in one pass over the points, the per band figures are differences
+of the running sums.
+
+The shift of a band is where the dB trace correlates best with the
+golden band: the normalized correlation over lags of up to a quarter
+of the band, at most MaxLag points, refined between points with a
+parabola. The dot products of all lags come out of one FFT
+cross-correlation of the trace with the golden window, whose spectrum
+is kept per grid, and the running sums normalize them. Bands at the
+ends of the sweep are trimmed by the lags. A positive shift means the
+feature sits above the golden one. Level and scale differences of the
+dB trace do not move it, the correlation is taken without the mean.
+*/
+class GoldenScore
+{
+public:
+    struct Band {
+        qreal start, stop;
+        qreal weight;
+    };
+
+    struct BandResult {
+        qreal rms;          // dB, NaN without points
+        qreal shift;        // Hz, NaN for a flat band
+        qreal correlation;  // at the shift
+        bool atLimit;       // best match at the end of the searched lags
+    };
+
+    GoldenScore();
+
+    bool parseBands(const QString &text, QString *error);
+    const QVector<Band> &bands() const { return m_bands; }
+
+    void setGolden(const Sweep &sweep);
+    void clear();
+    const Sweep &golden() const { return m_golden; }
+
+    /// Scores sweep, false without golden or for another kind of sweep
+    bool compare(const Sweep &sweep);
+    /// Score of the last compared sweep, dB
+    qreal distance() const { return m_distance; }
+    bool isComplex() const { return m_golden.kind() == Sweep::Ri; }
+    /// One per band, one for the whole sweep without bands
+    const QVector<BandResult> &bandResults() const { return results; }
+
+    /// Band table for display
+    QString summary() const;
+
+private:
+    void prepare(const QVector<qreal> &freq);
+
+    static const int MaxLag = 200;
+
+    QVector<Band> m_bands;
+    Sweep m_golden;
+    TraceResampler resampler;
+
+    // golden and weights on the grid of the last sweep
+    bool m_dirty;
+    quint64 m_serial;
+    int m_points;
+    qreal m_fstart, m_fstop;
+    QVector<QPointF> goldRi;
+    QVector<qreal> goldDb;
+    QVector<qreal> weight;
+    // first and last point per band, running sums of the golden dB
+    QVector<int> first, last;
+    QVector<qreal> goldSum, goldSquares;
+
+    // lag search of a band on the grid
+    struct Search {
+        int from, window;   // golden window
+        int lagMin, lags;
+        int size;           // fft points, 0 for a band without a shift
+        int spectrum;       // offset of its conjugate golden spectrum
+        qreal goldVar;
+    };
+    QVector<Search> searches;
+    QVector<qreal> goldRe, goldIm;
+    // spectrum of the trace, then the correlation, reused
+    QVector<qreal> segRe, segIm;
+
+    // running sums of the error and the dB trace, reused
+    QVector<qreal> errSum, dbSum, dbSquares;
+    QVector<qreal> corr;
+
+    qreal m_distance;
+    QVector<BandResult> results;
+};
+
+#endif // GOLDENSCORE_H
@@ -0,0 +1,66 @@
+#include "impedancecalculator.h"
+#include <math.h>
+
+ImpedanceCalculator::ImpedanceCalculator() :
+    m_z0(50.0)
+{
+}
+
+void ImpedanceCalculator::compute(const QVector<qreal> &freq, const QVector<QPointF> &z, int mask)
+{
+    int n = qMin(freq.size(), z.size());
+    qreal *out[QuantityCount];
+    for(int q = 0; q < QuantityCount; q++)
+    {
+        buffers[q].resize(mask & (1 << q) ? n : 0);
+        //data() of an empty vector is not null, the mask decides what is written
+        out[q] = mask & (1 << q) ? buffers[q].data() : 0;
+    }
+
+    const qreal *f = freq.constData();
+    const QPointF *zn = z.constData();
+    for(int i = 0; i < n; i++)
+    {
+        qreal r = zn[i].x() * m_z0;
+        qreal x = zn[i].y() * m_z0;
+        qreal mag2 = r*r + x*x;
+        qreal w = 2 * M_PI * f[i];
+        if(out[Resistance]) out[Resistance][i] = r;
+        if(out[Reactance]) out[Reactance][i] = x;
+        if(out[Magnitude]) out[Magnitude][i] = sqrt(mag2);
+        //y = 1 / z = (r - jx) / |z|^2
+        if(out[Conductance]) out[Conductance][i] = mag2 > 0 ? 1e3 * r / mag2 : 0;
+        if(out[Susceptance]) out[Susceptance][i] = mag2 > 0 ? -1e3 * x / mag2 : 0;
+        if(out[SeriesL]) out[SeriesL][i] = w > 0 ? 1e9 * x / w : 0;
+        if(out[SeriesC]) out[SeriesC][i] = w > 0 && x != 0 ? -1e12 / (w * x) : 0;
+    }
+}
+
+void ImpedanceCalculator::computeFromReflection(const QVector<qreal> &freq, const QVector<QPointF> &ri, int mask)
+{
+    int n = ri.size();
+    zbuffer.resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        //z = (1 + G) / (1 - G)
+        qreal a = 1 - ri[i].x();
+        qreal b = -ri[i].y();
+        qreal den = a*a + b*b;
+        qreal re = 1 + ri[i].x();
+        qreal im = ri[i].y();
+        zbuffer[i] = QPointF((re*a + im*b) / den, (im*a - re*b) / den);
+    }
+    compute(freq, zbuffer, mask);
+}
+
+const char *ImpedanceCalculator::name(Quantity q)
+{
+    static const char *names[QuantityCount] = { "R", "X", "|Z|", "G", "B", "Ls", "Cs" };
+    return names[q];
+}
+
+const char *ImpedanceCalculator::unit(Quantity q)
+{
+    static const char *units[QuantityCount] = { "Ohm", "Ohm", "Ohm", "mS", "mS", "nH", "pF" };
+    return units[q];
+}
@@ -0,0 +1,53 @@
+#ifndef IMPEDANCECALCULATOR_H
+#define IMPEDANCECALCULATOR_H
+
+#include <QVector>
+#include <QPointF>
+
+/// Impedance and admittance traces from reflection data
+/**
+Turns normalized impedance (Sweep::z()) or a reflection coefficient into
+the requested quantities in one pass over the sweep, with the reference
+impedance applied. Only the quantities in the mask are written, into
+buffers that are kept between sweeps.
+
+Units: R, X, |Z| in ohm, G, B in mS, the series equivalent inductance
+Ls = X / w in nH and capacitance Cs = -1 / (w X) in pF. Ls is negative
+for a capacitive load and Cs for an inductive one.
+*/
+class ImpedanceCalculator
+{
+public:
+    enum Quantity {
+        Resistance = 0,
+        Reactance,
+        Magnitude,
+        Conductance,
+        Susceptance,
+        SeriesL,
+        SeriesC,
+        QuantityCount
+    };
+
+    ImpedanceCalculator();
+
+    void setReference(qreal z0) { m_z0 = z0; }
+    qreal reference() const { return m_z0; }
+
+    /// From normalized impedance, mask is an or of (1 << Quantity)
+    void compute(const QVector<qreal> &freq, const QVector<QPointF> &z, int mask);
+    /// From reflection coefficients, for traces that are not a sweep
+    void computeFromReflection(const QVector<qreal> &freq, const QVector<QPointF> &ri, int mask);
+
+    const QVector<qreal> &values(Quantity q) const { return buffers[q]; }
+
+    static const char *name(Quantity q);
+    static const char *unit(Quantity q);
+
+private:
+    qreal m_z0;
+    QVector<qreal> buffers[QuantityCount];
+    QVector<QPointF> zbuffer;
+};
+
+#endif // IMPEDANCECALCULATOR_H
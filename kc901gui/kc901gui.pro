@@ -9,12 +9,16 @@ QT       += network
 
 QMAKE_CXXFLAGS += -std=gnu++11
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 unix {
     include (/usr/local/qwt-6.1.3/features/qwt.prf)
 }
 
+linux {
+    LIBS += -lrt
+}
+
 win32 {
     include (C:/qwt-6.1.3/features/qwt.prf)
 }
@@ -26,11 +30,70 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp \
     kcscalewidget.cpp \
-    smithchart.cpp
+    smithchart.cpp \
+    traceprocessor.cpp \
+    phaseprocessor.cpp \
+    limitmask.cpp \
+    peaksearch.cpp \
+    resonancetracker.cpp \
+    fastplotcurve.cpp \
+    cachedplotgrid.cpp \
+    waterfallwidget.cpp \
+    sweep.cpp \
+    sweepseriesdata.cpp \
+    measurementsequencer.cpp \
+    profiler.cpp \
+    sweepparser.cpp \
+    impedancecalculator.cpp \
+    networkchain.cpp \
+    portextension.cpp \
+    streamserver.cpp \
+    ringpublisher.cpp \
+    wirecapture.cpp \
+    sweeparchive.cpp \
+    kpiextractor.cpp \
+    trendstore.cpp \
+    modelfitter.cpp \
+    batchanalysis.cpp \
+    tdigest.cpp \
+    productionstats.cpp \
+    traceresampler.cpp \
+    tracemath.cpp \
+    goldenscore.cpp
 
 HEADERS  += mainwindow.h \
     kcscalewidget.h \
-    smithchart.h
+    smithchart.h \
+    traceprocessor.h \
+    phaseprocessor.h \
+    limitmask.h \
+    peaksearch.h \
+    resonancetracker.h \
+    fastplotcurve.h \
+    cachedplotgrid.h \
+    waterfallwidget.h \
+    sweep.h \
+    sweepseriesdata.h \
+    measurementsequencer.h \
+    profiler.h \
+    sweepparser.h \
+    impedancecalculator.h \
+    networkchain.h \
+    portextension.h \
+    streamserver.h \
+    ringpublisher.h \
+    sweepring.h \
+    wirecapture.h \
+    sweeparchive.h \
+    kpiextractor.h \
+    trendstore.h \
+    modelfitter.h \
+    batchanalysis.h \
+    tdigest.h \
+    productionstats.h \
+    traceresampler.h \
+    tracemath.h \
+    goldenscore.h
 
 FORMS    += mainwindow.ui
 
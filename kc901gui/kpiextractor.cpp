@@ -0,0 +1,138 @@
+#include "kpiextractor.h"
+#include <QRegExp>
+#include <algorithm>
+#include <limits>
+
+static const qreal NaN = std::numeric_limits<qreal>::quiet_NaN();
+
+KpiExtractor::KpiExtractor()
+{
+}
+
+bool KpiExtractor::parse(const QString &text, QString *error)
+{
+    QVector<Kpi> parsed;
+    QStringList lines = text.split('\n');
+    for(int lineNumber = 1; lineNumber <= lines.size(); lineNumber++)
+    {
+        QString line = lines[lineNumber-1].trimmed();
+        if(line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList fields = line.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+        //a line of separators only has no kind and is reported below
+        QString kind = fields.isEmpty() ? QString() : fields.takeFirst().toLower();
+        Kpi kpi;
+        kpi.level = 0;
+        kpi.low = kpi.high = 0;
+        kpi.name = fields.isEmpty() ? kind : kind + " " + fields.join(" ");
+        bool ok = true;
+        if(kind == "resonance") kpi.type = Resonance;
+        else if(kind == "minvswr") kpi.type = MinVswr;
+        else if(kind == "maxvswr") kpi.type = MaxVswr;
+        else if(kind == "bandwidth" && !fields.isEmpty())
+        {
+            kpi.type = Bandwidth;
+            kpi.level = fields.takeFirst().toDouble(&ok);
+            ok = ok && kpi.level > 0;
+        }
+        else if(kind == "meanrl" && fields.size() == 2) kpi.type = MeanRl;
+        else ok = false;
+
+        if(ok && fields.size() == 2)
+        {
+            bool lowOk, highOk;
+            kpi.low = fields[0].toDouble(&lowOk) * 1e6;
+            kpi.high = fields[1].toDouble(&highOk) * 1e6;
+            ok = lowOk && highOk && kpi.high > kpi.low;
+        }
+        else if(!fields.isEmpty())
+            ok = false;
+
+        if(!ok)
+        {
+            if(error) *error = QString("line %1: %2").arg(lineNumber).arg(line);
+            return false;
+        }
+        parsed.append(kpi);
+    }
+
+    kpis = parsed;
+    values.resize(kpis.size());
+    return true;
+}
+
+QStringList KpiExtractor::names() const
+{
+    QStringList list;
+    for(int k = 0; k < kpis.size(); k++)
+        list.append(kpis[k].name);
+    return list;
+}
+
+void KpiExtractor::band(const QVector<qreal> &freq, const Kpi &kpi, int *from, int *to) const
+//samples inside the band, an empty range when it misses the sweep
+{
+    *from = 0;
+    *to = freq.size();
+    if(kpi.high <= kpi.low) return;
+    *from = std::lower_bound(freq.constBegin(), freq.constEnd(), kpi.low) - freq.constBegin();
+    *to = std::upper_bound(freq.constBegin(), freq.constEnd(), kpi.high) - freq.constBegin();
+}
+
+const QVector<qreal> &KpiExtractor::extract(const Sweep &sweep)
+{
+    const QVector<qreal> &freq = sweep.freq();
+    for(int k = 0; k < kpis.size(); k++)
+    {
+        const Kpi &kpi = kpis[k];
+        int from, to;
+        band(freq, kpi, &from, &to);
+        values[k] = NaN;
+        if(from >= to) continue;
+
+        if(kpi.type == MinVswr || kpi.type == MaxVswr)
+        {
+            const QVector<qreal> &vswr = sweep.vswr();
+            qreal best = vswr[from];
+            for(int i = from + 1; i < to; i++)
+                best = kpi.type == MinVswr ? qMin(best, vswr[i]) : qMax(best, vswr[i]);
+            values[k] = best;
+            continue;
+        }
+
+        //|s11| in dB, return loss is its negative
+        const QVector<qreal> &db = sweep.db();
+        if(kpi.type == MeanRl)
+        {
+            qreal sum = 0;
+            for(int i = from; i < to; i++)
+                sum -= db[i];
+            values[k] = sum / (to - from);
+            continue;
+        }
+
+        int best = from;
+        for(int i = from + 1; i < to; i++)
+            if(db[i] < db[best]) best = i;
+        if(kpi.type == Resonance)
+        {
+            values[k] = freq[best] / 1e6;
+            continue;
+        }
+
+        //walk out of the resonance until the return loss drops below the level
+        qreal level = -kpi.level;
+        if(db[best] > level) continue;
+        int lo = best, hi = best;
+        while(lo > from && db[lo - 1] <= level) lo--;
+        while(hi < to - 1 && db[hi + 1] <= level) hi++;
+        //the band ends at the sweep edge when the trace never comes back up
+        qreal fl = freq[lo], fh = freq[hi];
+        if(lo > from)
+            fl = freq[lo - 1] + (level - db[lo - 1]) / (db[lo] - db[lo - 1]) * (freq[lo] - freq[lo - 1]);
+        if(hi < to - 1)
+            fh = freq[hi] + (level - db[hi]) / (db[hi + 1] - db[hi]) * (freq[hi + 1] - freq[hi]);
+        values[k] = (fh - fl) / 1e6;
+    }
+    return values;
+}
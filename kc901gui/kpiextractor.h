@@ -0,0 +1,59 @@
+#ifndef KPIEXTRACTOR_H
+#define KPIEXTRACTOR_H
+
+#include <QVector>
+#include <QStringList>
+#include "sweep.h"
+
+/// Scalar health figures of an S11 sweep
+/**
+One KPI per line, bands in MHz, the whole sweep without one:
+
+    # antenna health
+    resonance [f1 f2]          frequency of the lowest |S11|, MHz
+    minvswr [f1 f2]            lowest VSWR
+    maxvswr [f1 f2]            highest VSWR, the worst match in the band
+    bandwidth rl [f1 f2]       width around the resonance with return
+                               loss of at least rl dB, MHz
+    meanrl f1 f2               mean return loss, dB
+
+A KPI that cannot be computed on a sweep (band outside the sweep, no
+crossing of the level) is NaN, the trend store skips it.
+*/
+class KpiExtractor
+{
+public:
+    enum Type {
+        Resonance = 0,
+        MinVswr,
+        MaxVswr,
+        Bandwidth,
+        MeanRl
+    };
+
+    struct Kpi {
+        Type type;
+        qreal level;        // return loss of Bandwidth, dB
+        qreal low, high;    // band in Hz, 0 0 for the whole sweep
+        QString name;
+    };
+
+    KpiExtractor();
+
+    bool parse(const QString &text, QString *error);
+    bool isEmpty() const { return kpis.isEmpty(); }
+    int size() const { return kpis.size(); }
+    /// Names as written in the text, stable ids for the trend store
+    QStringList names() const;
+
+    /// One value per KPI, into a buffer kept between sweeps
+    const QVector<qreal> &extract(const Sweep &sweep);
+
+private:
+    void band(const QVector<qreal> &freq, const Kpi &kpi, int *from, int *to) const;
+
+    QVector<Kpi> kpis;
+    QVector<qreal> values;
+};
+
+#endif // KPIEXTRACTOR_H
@@ -0,0 +1,214 @@
+#include "limitmask.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+#include <QtNumeric>
+#include <algorithm>
+
+static const char *UnitNames[] = { "", "vswr", "db", "s21", "phase", "delay" };
+
+static bool segmentLess(const LimitMask::Segment &a, const LimitMask::Segment &b)
+{
+    return a.f1 < b.f1;
+}
+
+LimitMask::LimitMask() :
+    m_unit(NoUnit),
+    m_points(0),
+    m_fstart(0),
+    m_fstop(0)
+{
+}
+
+bool LimitMask::load(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        if(error) *error = file.errorString();
+        return false;
+    }
+
+    QVector<Segment> upper, lower;
+    Unit unit = NoUnit;
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while(!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        lineNumber++;
+        if(line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList fields = line.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+        //separators only leave no fields, value() makes that a segment line and an error
+        if(fields.value(0).toLower() == "unit")
+        {
+            unit = NoUnit;
+            for(int u = Vswr; u <= Delay; u++)
+                if(fields.size() == 2 && fields[1].toLower() == UnitNames[u]) unit = Unit(u);
+            if(unit == NoUnit)
+            {
+                if(error) *error = QString("line %1: %2").arg(lineNumber).arg(line);
+                return false;
+            }
+            continue;
+        }
+        bool ok = fields.size() == 5;
+        Segment seg;
+        if(ok) seg.f1 = fields[1].toDouble(&ok);
+        if(ok) seg.v1 = fields[2].toDouble(&ok);
+        if(ok) seg.f2 = fields[3].toDouble(&ok);
+        if(ok) seg.v2 = fields[4].toDouble(&ok);
+        QString kind = fields.isEmpty() ? QString() : fields[0].toLower();
+        if(!ok || (kind != "upper" && kind != "lower"))
+        {
+            if(error) *error = QString("line %1: %2").arg(lineNumber).arg(line);
+            return false;
+        }
+        if(seg.f2 < seg.f1)
+        {
+            std::swap(seg.f1, seg.f2);
+            std::swap(seg.v1, seg.v2);
+        }
+        if(kind == "upper")
+            upper.append(seg);
+        else
+            lower.append(seg);
+    }
+
+    //the same numbers mean different things in another unit
+    if(unit == NoUnit)
+    {
+        if(error) *error = QString("no unit line, one of vswr db s21 phase delay");
+        return false;
+    }
+
+    std::sort(upper.begin(), upper.end(), segmentLess);
+    std::sort(lower.begin(), lower.end(), segmentLess);
+    upperSegments = upper;
+    lowerSegments = lower;
+    m_fileName = fileName;
+    m_unit = unit;
+    m_points = 0; //rebuild tables on the next test
+    return true;
+}
+
+void LimitMask::clear()
+{
+    upperSegments.clear();
+    lowerSegments.clear();
+    m_fileName.clear();
+    m_unit = NoUnit;
+    m_points = 0;
+}
+
+bool LimitMask::isEmpty() const
+{
+    return upperSegments.isEmpty() && lowerSegments.isEmpty();
+}
+
+QString LimitMask::unitName(Unit unit)
+{
+    return UnitNames[unit];
+}
+
+const QVector<qreal> *LimitMask::column(const Sweep &sweep) const
+{
+    bool s21 = sweep.kind() == Sweep::S21;
+    switch(m_unit)
+    {
+    case Vswr:
+        return s21 ? 0 : &sweep.vswr();
+    case Db:
+        return s21 ? 0 : &sweep.db();
+    case S21:
+        return s21 ? &sweep.db() : 0;
+    default:
+        return 0;
+    }
+}
+
+QVector<QPointF> LimitMask::outline(bool upper) const
+{
+    const QVector<Segment> &segments = upper ? upperSegments : lowerSegments;
+    QVector<QPointF> points;
+    points.reserve(segments.size() * 2);
+    for(int i = 0; i < segments.size(); i++)
+    {
+        points.append(QPointF(segments[i].f1, segments[i].v1));
+        points.append(QPointF(segments[i].f2, segments[i].v2));
+    }
+    return points;
+}
+
+void LimitMask::tabulate(const QVector<Segment> &segments, const QVector<qreal> &freq,
+                         QVector<qreal> &table, bool upper)
+{
+    int n = freq.size();
+    table.resize(n);
+    table.fill(upper ? qInf() : -qInf());
+    for(int s = 0; s < segments.size(); s++)
+    {
+        const Segment &seg = segments[s];
+        const qreal *begin = freq.constData();
+        int first = std::lower_bound(begin, begin + n, seg.f1) - begin;
+        int last = std::upper_bound(begin, begin + n, seg.f2) - begin;
+        qreal slope = seg.f2 > seg.f1 ? (seg.v2 - seg.v1) / (seg.f2 - seg.f1) : 0;
+        for(int i = first; i < last; i++)
+        {
+            qreal limit = seg.v1 + slope * (freq[i] - seg.f1);
+            table[i] = upper ? qMin(table[i], limit) : qMax(table[i], limit);
+        }
+    }
+}
+
+void LimitMask::prepare(const QVector<qreal> &freq)
+{
+    int n = freq.size();
+    if(n == m_points && n > 0 && freq.first() == m_fstart && freq.last() == m_fstop)
+        return;
+
+    tabulate(upperSegments, freq, upperTable, true);
+    tabulate(lowerSegments, freq, lowerTable, false);
+    m_points = n;
+    m_fstart = n > 0 ? freq.first() : 0;
+    m_fstop = n > 0 ? freq.last() : 0;
+    m_failFreq.reserve(n);
+    m_failValue.reserve(n);
+}
+
+LimitMask::Result LimitMask::test(const QVector<qreal> &freq, const QVector<qreal> &values)
+{
+    Result result;
+    result.pass = true;
+    result.failPoints = 0;
+    result.worstMargin = qInf();
+    result.worstFreq = 0;
+    m_failFreq.resize(0);
+    m_failValue.resize(0);
+    if(isEmpty()) return result;
+
+    prepare(freq);
+    int n = qMin(freq.size(), values.size());
+    const qreal *up = upperTable.constData();
+    const qreal *lo = lowerTable.constData();
+    const qreal *v = values.constData();
+    for(int i = 0; i < n; i++)
+    {
+        qreal margin = qMin(up[i] - v[i], v[i] - lo[i]);
+        if(margin < result.worstMargin)
+        {
+            result.worstMargin = margin;
+            result.worstFreq = freq[i];
+        }
+        if(margin < 0)
+        {
+            m_failFreq.append(freq[i]);
+            m_failValue.append(v[i]);
+        }
+    }
+    result.failPoints = m_failFreq.size();
+    result.pass = result.failPoints == 0;
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef LIMITMASK_H
+#define LIMITMASK_H
+
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include "sweep.h"
+
+/// Piecewise linear upper / lower limit mask
+/**
+The mask file is plain text, the unit of the limits and one segment per
+line:
+    unit vswr | db | s21 | phase | delay
+    upper <f1> <v1> <f2> <v2>
+    lower <f1> <v1> <f2> <v2>
+Lines starting with # are comments. db is |S11| in dB, s21 |S21| in dB,
+phase is the unwrapped phase in degrees and delay the group delay. Only
+traces in the unit of the mask are tested, the caller checks the unit.
+Where segments overlap the tighter limit wins. The limits are tabulated
+once per sweep grid, a test is then a single compare pass over the trace.
+*/
+class LimitMask
+{
+public:
+    enum Unit {
+        NoUnit = 0,
+        Vswr,
+        Db,
+        S21,
+        Phase,
+        Delay
+    };
+
+    struct Segment {
+        qreal f1, v1, f2, v2;
+    };
+
+    struct Result {
+        bool pass;
+        int failPoints;
+        /// smallest distance to a limit, negative when failing
+        qreal worstMargin;
+        qreal worstFreq;
+    };
+
+    LimitMask();
+
+    bool load(const QString &fileName, QString *error = 0);
+    void clear();
+    bool isEmpty() const;
+    QString fileName() const { return m_fileName; }
+    Unit unit() const { return m_unit; }
+    static QString unitName(Unit unit);
+
+    /// Column of sweep in the mask unit, 0 if the sweep does not carry it
+    /**
+    Only the raw columns, phase and delay traces are made by the view
+    processing and are not available here.
+    */
+    const QVector<qreal> *column(const Sweep &sweep) const;
+
+    /// Limit line for drawing, in frequency order
+    QVector<QPointF> outline(bool upper) const;
+
+    Result test(const QVector<qreal> &freq, const QVector<qreal> &values);
+
+    /// Failing samples of the last test
+    const QVector<qreal> &failFreq() const { return m_failFreq; }
+    const QVector<qreal> &failValue() const { return m_failValue; }
+
+private:
+    void prepare(const QVector<qreal> &freq);
+    static void tabulate(const QVector<Segment> &segments, const QVector<qreal> &freq,
+                         QVector<qreal> &table, bool upper);
+
+    QString m_fileName;
+    Unit m_unit;
+    QVector<Segment> upperSegments;
+    QVector<Segment> lowerSegments;
+
+    // grid the tables were built for
+    int m_points;
+    qreal m_fstart, m_fstop;
+    QVector<qreal> upperTable;
+    QVector<qreal> lowerTable;
+
+    QVector<qreal> m_failFreq;
+    QVector<qreal> m_failValue;
+};
+
+#endif // LIMITMASK_H
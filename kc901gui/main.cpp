@@ -1,9 +1,17 @@
 #include "mainwindow.h"
+#include "batchanalysis.h"
 #include <QApplication>
 
 
 int main(int argc, char *argv[])
 {
+    //kc901 --batch <archive> ... analyses a recording without a window
+    if(argc > 1 && QString(argv[1]) == "--batch")
+    {
+        QCoreApplication a(argc, argv);
+        return BatchAnalysis::main(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -20,12 +20,49 @@
 #include "kcscalewidget.h"
 #include "qwt_picker_machine.h"
 #include "smithchart.h"
+#include "traceprocessor.h"
+#include "phaseprocessor.h"
+#include "limitmask.h"
+#include "qwt_plot_textlabel.h"
+#include "qwt_plot_marker.h"
+#include "peaksearch.h"
+#include "resonancetracker.h"
+#include "fastplotcurve.h"
+#include "cachedplotgrid.h"
+#include "sweepseriesdata.h"
+#include "measurementsequencer.h"
+#include "profiler.h"
+#include "sweepparser.h"
+#include "impedancecalculator.h"
+#include "networkchain.h"
+#include "portextension.h"
+#include "streamserver.h"
+#include "ringpublisher.h"
+#include "wirecapture.h"
+#include "sweeparchive.h"
+#include "kpiextractor.h"
+#include "trendstore.h"
+#include "modelfitter.h"
+#include "productionstats.h"
+#include "tracemath.h"
+#include "goldenscore.h"
+#include "qwt_plot_intervalcurve.h"
+#include "qwt_date_scale_draw.h"
+#include "qwt_date_scale_engine.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTextStream>
+#include <QDir>
 #include "cmath"
 
 #define DARKSTYLE
 //#define BRIGHTSTYLE
 #define KC901V_FIX
 
+static const int GoldenHistory = 300;
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
@@ -49,22 +86,203 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->PointlineEdit->setText(cfg->value("s11/pts", QString("%1").arg(pts)).toString());
 
     receiveTimer = new QTimer();
+    //one timeout per request, the handler decides what comes next
+    receiveTimer->setSingleShot(true);
+    receiveTimeouts = 0;
     connect(receiveTimer, SIGNAL(timeout()), this, SLOT(receiveTimeout()));
 
     receiveElapsed = new QElapsedTimer();
+    receivedata.reserve(64 * 1024);
+
+    //frame rate cap for the sweep driven replots
+    replotTimer = new QTimer(this);
+    replotTimer->setSingleShot(true);
+    connect(replotTimer, SIGNAL(timeout()), this, SLOT(replotNow()));
+    replotElapsed = new QElapsedTimer();
+    replotElapsed->start();
+    replotInterval = 1000 / qMax(1, cfg->value("plot/maxfps", 30).toInt());
+
+    //status and readout text a few times a second, the sweeps only keep numbers
+    readoutTimer = new QTimer(this);
+    readoutTimer->setSingleShot(true);
+    connect(readoutTimer, SIGNAL(timeout()), this, SLOT(readoutNow()));
+    readoutReply = 0;
+    readoutPoints = 0;
+    readoutMs = 0;
+    readoutInterval = qMax(20, cfg->value("display/readoutms", 250).toInt());
+    sweepcmd.reserve(128);
 
     _pSocket = new QTcpSocket( this );
 
     //replace xbottom scale widget
     bottomScaleWidget = new KCScaleWidget(QwtScaleDraw::BottomScale, ui->plot);
 
-    s11curve = new QwtPlotCurve(trUtf8("S11"));
-    s21curve = new QwtPlotCurve(trUtf8("S21"));
+    s11curve = new FastPlotCurve(trUtf8("S11"));
+    s21curve = new FastPlotCurve(trUtf8("S21"));
     s11curve->setVisible(false);
     s21curve->setVisible(false);
     s11curve->attach(ui->plot);
     s21curve->attach(ui->plot);
 
+    //averaged / held trace, drawn alongside the live one
+    proccurve = new FastPlotCurve(trUtf8("Processed"));
+    proccurve->setVisible(false);
+    proccurve->attach(ui->plot);
+    //fitted model, dashed over the live trace
+    fitcurve = new FastPlotCurve(trUtf8("Fit"));
+    fitcurve->setPen(QPen(QColor(cfg->value("fit/linecolor", QColor(255,0,255).rgb()).toUInt()), 1.0, Qt::DashLine));
+    fitcurve->setVisible(false);
+    fitcurve->attach(ui->plot);
+    //second impedance trace on the left axis and the right axis trace
+    zcurve = new FastPlotCurve(trUtf8("Z2"));
+    zcurve->setVisible(false);
+    zcurve->attach(ui->plot);
+    rightcurve = new FastPlotCurve(trUtf8("Right"));
+    rightcurve->setYAxis(QwtPlot::yRight);
+    rightcurve->setVisible(false);
+    rightcurve->attach(ui->plot);
+    s11proc = new TraceProcessor();
+    scalarproc = new TraceProcessor();
+    phaseproc = new PhaseProcessor();
+
+    //limit mask lines, failing samples and the pass / fail verdict
+    limitmask = new LimitMask();
+    upperlimitcurve = new QwtPlotCurve(trUtf8("Upper limit"));
+    lowerlimitcurve = new QwtPlotCurve(trUtf8("Lower limit"));
+    failcurve = new QwtPlotCurve(trUtf8("Fail"));
+    upperlimitcurve->setPen(QPen(Qt::red, 1.0, Qt::DashLine));
+    lowerlimitcurve->setPen(QPen(Qt::red, 1.0, Qt::DashLine));
+    failcurve->setPen(QPen(Qt::red, 4.0));
+    failcurve->setStyle(QwtPlotCurve::Dots);
+    upperlimitcurve->setVisible(false);
+    lowerlimitcurve->setVisible(false);
+    failcurve->setVisible(false);
+    upperlimitcurve->attach(ui->plot);
+    lowerlimitcurve->attach(ui->plot);
+    failcurve->attach(ui->plot);
+    limitlabel = new QwtPlotTextLabel();
+    limitlabel->setVisible(false);
+    limitlabel->attach(ui->plot);
+    limitlog = new QFile(cfg->value("limit/log", "limit_log.csv").toString(), this);
+    limitPass = 0;
+    limitFail = 0;
+    limitVerdict = -1;
+    limitShown = -1;
+    limitTraceUnit = 0;
+    limitMargin = 0;
+    limitMarginFreq = 0;
+
+    //peak search markers: resonance with readout, 3 dB band edges, notches
+    peaksearch = new PeakSearch();
+    resmarker = new QwtPlotMarker();
+    resmarker->setLineStyle(QwtPlotMarker::VLine);
+    resmarker->setLinePen(QPen(Qt::green, 1.0));
+    resmarker->setLabelAlignment(Qt::AlignRight | Qt::AlignTop);
+    resmarker->attach(ui->plot);
+    for(int i = 0; i < 2; i++)
+    {
+        bwmarkers[i] = new QwtPlotMarker();
+        bwmarkers[i]->setLineStyle(QwtPlotMarker::VLine);
+        bwmarkers[i]->setLinePen(QPen(Qt::green, 1.0, Qt::DotLine));
+        bwmarkers[i]->attach(ui->plot);
+    }
+    for(int i = 0; i < 16; i++)
+    {
+        QwtPlotMarker *marker = new QwtPlotMarker();
+        marker->setLineStyle(QwtPlotMarker::VLine);
+        marker->setLinePen(QPen(Qt::magenta, 1.0, Qt::DashLine));
+        marker->setLabelAlignment(Qt::AlignRight | Qt::AlignBottom);
+        marker->attach(ui->plot);
+        notchmarkers.append(marker);
+    }
+    hidePeakMarkers();
+    tracker = new ResonanceTracker();
+    lastSweepType = NoSweep;
+    lastCent = lastSpan = 0;
+    lastPts = 0;
+    sequencer = new MeasurementSequencer();
+    sequenceElapsed = new QElapsedTimer();
+    profiler = new Profiler();
+    zcalc = new ImpedanceCalculator();
+    zcalcproc = new ImpedanceCalculator();
+    zcalc->setReference(cfg->value("z/ref", 50.0).toDouble());
+    zcalcproc->setReference(zcalc->reference());
+    network = new NetworkChain();
+    portext = new PortExtension();
+    server = new StreamServer();
+    remoteInFlight = false;
+    guiSweepType = NoSweep;
+    guiCent = guiSpan = 0;
+    guiPts = guiMesmode = 0;
+    ring = new RingPublisher();
+    capture = new WireCapture();
+    replay = new WireReplay();
+    connect(replay, SIGNAL(received(QByteArray)), this, SLOT(replayChunk(QByteArray)));
+    connect(replay, SIGNAL(finished(int,qint64)), this, SLOT(replayFinished(int,qint64)));
+    recorder = new SweepArchive();
+    archive = new SweepArchive();
+    archiveTimer = new QTimer();
+    connect(archiveTimer, SIGNAL(timeout()), this, SLOT(archiveStep()));
+    kpis = new KpiExtractor();
+    trend = new TrendStore();
+    trendTimer = new QTimer();
+    connect(trendTimer, SIGNAL(timeout()), this, SLOT(refreshTrend()));
+    //kpi history: mean line inside the min / max band of each bucket
+    trendband = new QwtPlotIntervalCurve(trUtf8("Min / max"));
+    trendband->setPen(QPen(Qt::NoPen));
+    trendband->setBrush(QBrush(QColor(80, 140, 255, 80)));
+    trendband->attach(ui->trendplot);
+    trendcurve = new QwtPlotCurve(trUtf8("Mean"));
+    trendcurve->setPen(QPen(QColor(40, 90, 220), 1.0));
+    trendcurve->attach(ui->trendplot);
+    ui->trendplot->setCanvasBackground(QBrush(Qt::white));
+    ui->trendplot->setAxisScaleDraw(QwtPlot::xBottom, new QwtDateScaleDraw(Qt::LocalTime));
+    ui->trendplot->setAxisScaleEngine(QwtPlot::xBottom, new QwtDateScaleEngine(Qt::LocalTime));
+    ui->KpiplainTextEdit->setFont(QFont("Monospace"));
+    fitter = new ModelFitter();
+    ui->FitResultlabel->setFont(QFont("Monospace"));
+    spc = new ProductionStats();
+    spcTimer = new QTimer();
+    connect(spcTimer, SIGNAL(timeout()), this, SLOT(refreshSpc()));
+    //percentile envelope of all units so far, behind the live trace
+    spcband = new QwtPlotIntervalCurve(trUtf8("p1 / p99"));
+    spcband->setPen(QPen(Qt::NoPen));
+    spcband->setBrush(QBrush(QColor(cfg->value("spc/color", QColor(128,128,128,70).rgba()).toUInt())));
+    spcband->setVisible(false);
+    spcband->attach(ui->plot);
+    spcmedian = new QwtPlotCurve(trUtf8("p50"));
+    spcmedian->setPen(QPen(QColor(128,128,128), 1.0, Qt::DotLine));
+    spcmedian->setZ(spcband->z());
+    spcmedian->setVisible(false);
+    spcmedian->attach(ui->plot);
+    ui->SpcTextlabel->setFont(QFont("Monospace"));
+    tracemath = new TraceMath();
+    memoryCoverage = 1;
+    memoryRejected = 0;
+    golden = new GoldenScore();
+    goldenSweeps = 0;
+    goldenScored = false;
+    //sparkline of the last scores, no axes
+    goldencurve = new QwtPlotCurve(trUtf8("Score"));
+    goldencurve->setPen(QPen(QColor(40, 90, 220), 1.0));
+    goldencurve->attach(ui->goldenplot);
+    ui->goldenplot->enableAxis(QwtPlot::xBottom, false);
+    ui->goldenplot->enableAxis(QwtPlot::yLeft, false);
+    ui->goldenplot->setCanvasBackground(QBrush(Qt::white));
+    ui->goldenplot->setFixedHeight(80);
+    ui->GoldenScorelabel->setFont(QFont("consolas", 28, QFont::Bold));
+    ui->GoldenBandsplainTextEdit->setFont(QFont("Monospace"));
+    ui->GoldenBandslabel->setFont(QFont("Monospace"));
+    connect(server, SIGNAL(requestQueued()), this, SLOT(serveRequest()));
+    connect(server, SIGNAL(clientsChanged(int)), this, SLOT(updateStreamStatus()));
+    network->setReference(zcalc->reference());
+    ui->ChainplainTextEdit->setFont(QFont("Monospace"));
+    impedanceShown = false;
+    zcurve->setPen(QPen(QColor(cfg->value("z/linecolor", QColor(255,80,80).rgb()).toUInt()), 1.0));
+    rightcurve->setPen(QPen(QColor(cfg->value("z/rightcolor", QColor(120,220,60).rgb()).toUInt()), 1.0));
+    ui->ProfileTextlabel->setFont(QFont("Monospace"));
+    ui->ProfileTextlabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
     ui->plot->setCanvasBackground(QBrush(Qt::white));
     ui->plot->axisScaleEngine(QwtPlot::xBottom)->setMargins(0.0,0.0);
     ui->plot->setAxisMaxMajor(QwtPlot::xBottom, 10);
@@ -78,7 +296,7 @@ MainWindow::MainWindow(QWidget *parent) :
     s11curve->setCurveFitter(myCurveFitter);
     s11curve->setRenderHint(QwtPlotItem::RenderAntialiased, true);
 
-    QwtPlotGrid *grid = new QwtPlotGrid();
+    QwtPlotGrid *grid = new CachedPlotGrid();
 #ifdef BRIGHTSTYLE
     ui->plot->setStyleSheet("background: white;"
                             "color: black;");
@@ -86,6 +304,10 @@ MainWindow::MainWindow(QWidget *parent) :
         QColor(cfg->value("s11/linecolor",QColor(Qt::blue).rgb()).toUInt()),
         cfg->value("s11/linewidth",1.0).toFloat()
     ));
+    proccurve->setPen( QPen(
+        QColor(cfg->value("proc/linecolor",QColor(Qt::darkRed).rgb()).toUInt()),
+        cfg->value("proc/linewidth",1.0).toFloat()
+    ));
     grid->setMajorPen( QPen(
         QColor(cfg->value("background/majorcolor",QColor(255,183,84).rgb()).toUInt()),
         cfg->value("background/majorwidth", 1.0).toFloat()
@@ -106,6 +328,10 @@ MainWindow::MainWindow(QWidget *parent) :
         QColor(cfg->value("s21/linecolor",QColor(0,255,230).rgb()).toUInt()),
         cfg->value("s21/linewidth",1.0).toFloat()
     ));
+    proccurve->setPen( QPen(
+        QColor(cfg->value("proc/linecolor",QColor(255,200,0).rgb()).toUInt()),
+        cfg->value("proc/linewidth",1.0).toFloat()
+    ));
     grid->setMajorPen( QPen(
         QColor(cfg->value("background/majorcolor",QColor(40,40,40).rgb()).toUInt()),
         cfg->value("background/majorwidth", 1.0).toFloat()
@@ -171,6 +397,64 @@ MainWindow::MainWindow(QWidget *parent) :
 
     autoRefineEnable = true;
     autoscaleAndZoomReset = true;
+
+    ui->AvgCountspinBox->setValue(cfg->value("trace/count", 16).toInt());
+    ui->TraceModecomboBox->setCurrentIndex(cfg->value("trace/mode", 0).toInt());
+    ui->AperturespinBox->setValue(cfg->value("trace/aperture", 2).toInt());
+    ui->SmoothspinBox->setValue(cfg->value("trace/smooth", 1).toInt());
+    if(cfg->contains("limit/file"))
+        loadLimitMask(cfg->value("limit/file").toString());
+    ui->LimitcheckBox->setChecked(cfg->value("limit/enable", false).toBool());
+    ui->LimitLogcheckBox->setChecked(cfg->value("limit/logenable", false).toBool());
+    ui->NotchCountspinBox->setValue(cfg->value("peak/notches", 1).toInt());
+    centerSpanFactor = cfg->value("peak/spanfactor", 4.0).toDouble();
+    ui->PeakcheckBox->setChecked(cfg->value("peak/enable", false).toBool());
+    ui->FastcheckBox->setChecked(cfg->value("plot/fast", false).toBool());
+    ui->waterfall->setRows(cfg->value("waterfall/rows", 500).toInt());
+    ui->WfMindoubleSpinBox->setValue(cfg->value("waterfall/min", -40.0).toDouble());
+    ui->WfMaxdoubleSpinBox->setValue(cfg->value("waterfall/max", 0.0).toDouble());
+    ui->WaterfallcheckBox->setChecked(cfg->value("waterfall/enable", false).toBool());
+    ui->SeqReordercheckBox->setChecked(cfg->value("sequence/reorder", true).toBool());
+    ui->ZLeftcomboBox->setCurrentIndex(cfg->value("z/left", 0).toInt());
+    ui->ZRightcomboBox->setCurrentIndex(cfg->value("z/right", 0).toInt());
+    ui->DelaydoubleSpinBox->setValue(cfg->value("port/delay", 0.0).toDouble());
+    ui->LossdoubleSpinBox->setValue(cfg->value("port/loss", 0.0).toDouble());
+    ui->AutoDelaycheckBox->setChecked(cfg->value("port/autodelay", false).toBool());
+    ui->AutoLosscheckBox->setChecked(cfg->value("port/autoloss", false).toBool());
+    ui->PortExtcheckBox->setChecked(cfg->value("port/enable", false).toBool());
+    ui->ChainplainTextEdit->setPlainText(cfg->value("network/chain").toString());
+    ui->StreamPortspinBox->setValue(cfg->value("stream/port", 9901).toInt());
+    ui->StreamcheckBox->setChecked(cfg->value("stream/enable", false).toBool());
+    ui->ShmcheckBox->setChecked(cfg->value("shm/enable", false).toBool());
+    ui->KpiplainTextEdit->setPlainText(cfg->value("trend/kpis", "resonance\nminvswr\nbandwidth 10\n").toString());
+    ui->TrendRangecomboBox->setCurrentIndex(cfg->value("trend/range", 1).toInt());
+    if(compileKpis() && cfg->value("trend/enable", false).toBool() && cfg->contains("trend/dir"))
+    {
+        //reopen the store silently, the toggle slot would ask for a directory
+        QString error;
+        if(trend->open(cfg->value("trend/dir").toString(), kpis->names(), &error))
+        {
+            ui->TrendcheckBox->blockSignals(true);
+            ui->TrendcheckBox->setChecked(true);
+            ui->TrendcheckBox->blockSignals(false);
+            trendTimer->start(10000);
+        }
+        else
+            ui->TrendStatuslabel->setText(error);
+    }
+    ui->FitModelcomboBox->setCurrentIndex(cfg->value("fit/model", 0).toInt());
+    ui->FitPolesspinBox->setValue(cfg->value("fit/poles", 4).toInt());
+    ui->FitPolesspinBox->setEnabled(ui->FitModelcomboBox->currentIndex() == ModelFitter::Rational);
+    ui->FitContinuouscheckBox->setChecked(cfg->value("fit/continuous", false).toBool());
+    ui->SpcEnvelopecheckBox->setChecked(cfg->value("spc/envelope", true).toBool());
+    ui->SpccheckBox->setChecked(cfg->value("spc/enable", false).toBool());
+    ui->TraceMathcomboBox->setCurrentIndex(cfg->value("memory/math", 0).toInt());
+    ui->GoldenBandsplainTextEdit->setPlainText(cfg->value("golden/bands").toString());
+    compileBands();
+    if(compileNetwork())
+        ui->NetworkcheckBox->setChecked(cfg->value("network/enable", false).toBool());
+    if(cfg->contains("sequence/file"))
+        loadSequence(cfg->value("sequence/file").toString());
 }
 
 MainWindow::~MainWindow()
@@ -178,7 +462,37 @@ MainWindow::~MainWindow()
     delete ui;
     delete receiveTimer;
     delete receiveElapsed;
+    delete replotElapsed;
     delete cfg;
+    delete s11proc;
+    delete scalarproc;
+    delete phaseproc;
+    delete limitmask;
+    delete peaksearch;
+    delete tracker;
+    delete sequencer;
+    delete sequenceElapsed;
+    delete profiler;
+    delete zcalc;
+    delete zcalcproc;
+    delete network;
+    delete portext;
+    delete server;
+    delete ring;
+    delete capture;
+    delete replay;
+    //closing the recorder writes the index
+    delete recorder;
+    delete archive;
+    delete archiveTimer;
+    delete kpis;
+    delete trend;
+    delete trendTimer;
+    delete fitter;
+    delete spc;
+    delete spcTimer;
+    delete tracemath;
+    delete golden;
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -189,6 +503,41 @@ void MainWindow::closeEvent(QCloseEvent *event)
     cfg->setValue("s11/cent", ui->CentlineEdit->text());
     cfg->setValue("s11/span", ui->SpanlineEdit->text());
     cfg->setValue("s11/pts", ui->PointlineEdit->text());
+    cfg->setValue("trace/mode", ui->TraceModecomboBox->currentIndex());
+    cfg->setValue("trace/count", ui->AvgCountspinBox->value());
+    cfg->setValue("trace/aperture", ui->AperturespinBox->value());
+    cfg->setValue("trace/smooth", ui->SmoothspinBox->value());
+    cfg->setValue("limit/enable", ui->LimitcheckBox->isChecked());
+    cfg->setValue("limit/logenable", ui->LimitLogcheckBox->isChecked());
+    cfg->setValue("peak/notches", ui->NotchCountspinBox->value());
+    cfg->setValue("peak/enable", ui->PeakcheckBox->isChecked());
+    cfg->setValue("plot/fast", ui->FastcheckBox->isChecked());
+    cfg->setValue("waterfall/min", ui->WfMindoubleSpinBox->value());
+    cfg->setValue("waterfall/max", ui->WfMaxdoubleSpinBox->value());
+    cfg->setValue("waterfall/enable", ui->WaterfallcheckBox->isChecked());
+    cfg->setValue("sequence/reorder", ui->SeqReordercheckBox->isChecked());
+    cfg->setValue("z/left", ui->ZLeftcomboBox->currentIndex());
+    cfg->setValue("z/right", ui->ZRightcomboBox->currentIndex());
+    cfg->setValue("port/delay", ui->DelaydoubleSpinBox->value());
+    cfg->setValue("port/loss", ui->LossdoubleSpinBox->value());
+    cfg->setValue("port/autodelay", ui->AutoDelaycheckBox->isChecked());
+    cfg->setValue("port/autoloss", ui->AutoLosscheckBox->isChecked());
+    cfg->setValue("port/enable", ui->PortExtcheckBox->isChecked());
+    cfg->setValue("network/chain", ui->ChainplainTextEdit->toPlainText());
+    cfg->setValue("stream/port", ui->StreamPortspinBox->value());
+    cfg->setValue("stream/enable", ui->StreamcheckBox->isChecked());
+    cfg->setValue("shm/enable", ui->ShmcheckBox->isChecked());
+    cfg->setValue("trend/kpis", ui->KpiplainTextEdit->toPlainText());
+    cfg->setValue("trend/range", ui->TrendRangecomboBox->currentIndex());
+    cfg->setValue("trend/enable", ui->TrendcheckBox->isChecked());
+    cfg->setValue("fit/model", ui->FitModelcomboBox->currentIndex());
+    cfg->setValue("fit/poles", ui->FitPolesspinBox->value());
+    cfg->setValue("fit/continuous", ui->FitContinuouscheckBox->isChecked());
+    cfg->setValue("spc/enable", ui->SpccheckBox->isChecked());
+    cfg->setValue("spc/envelope", ui->SpcEnvelopecheckBox->isChecked());
+    cfg->setValue("memory/math", ui->TraceMathcomboBox->currentIndex());
+    cfg->setValue("golden/bands", ui->GoldenBandsplainTextEdit->toPlainText());
+    cfg->setValue("network/enable", ui->NetworkcheckBox->isChecked());
     Q_UNUSED(event);
 }
 
@@ -196,15 +545,17 @@ void MainWindow::VSWR(qreal cent, qreal span, int pts)
 {
     if(cent == 0 || span == 0 || pts == 0) return;
 //    if(isnan(cent) || isinf(cent) || isnan(span) || isinf(span)) return;
+    lastSweepType = VswrSweep;
+    lastCent = cent;
+    lastSpan = span;
+    lastPts = pts;
     startReceive();
     if( _pSocket->isWritable() ) {
 #ifdef KC901V_FIX
-        QByteArray cmd = QString("$S11,run,calon,vswr,%1,CS,%2,%3\n").arg(pts).arg(cent,0,'f',0).arg(span,0,'f',0).toLatin1();
+        sendSweep("$S11,run,calon,vswr,%d,CS,%.0f,%.0f\n", cent, span, pts);
 #else
-        QByteArray cmd = QString("$S11,run,calon,vswr,point=%1,CS,cent=%2,span=%3\n").arg(pts).arg(cent,0,'f',0).arg(span,0,'f',0).toLatin1();
+        sendSweep("$S11,run,calon,vswr,point=%d,CS,cent=%.0f,span=%.0f\n", cent, span, pts);
 #endif
-        _pSocket->write(cmd);
-        qDebug() << cmd;
     }
 }
 
@@ -213,15 +564,17 @@ void MainWindow::RI(qreal cent, qreal span, int pts)
 {
     if(cent == 0 || span == 0 || pts == 0) return;
 //    if(isnan(cent) || isinf(cent) || isnan(span) || isinf(span)) return;
+    lastSweepType = RiSweep;
+    lastCent = cent;
+    lastSpan = span;
+    lastPts = pts;
     startReceive();
     if( _pSocket->isWritable() ) {
 #ifdef KC901V_FIX
-        QByteArray cmd = QString("$S11,run,calon,ri,%1,CS,%2,%3\n").arg(pts).arg(cent,0,'f',0).arg(span,0,'f',0).toLatin1();
+        sendSweep("$S11,run,calon,ri,%d,CS,%.0f,%.0f\n", cent, span, pts);
 #else
-        QByteArray cmd = QString("$S11,run,calon,ri,point=%1,CS,cent=%2,span=%3\n").arg(pts).arg(cent,0,'f',0).arg(span,0,'f',0).toLatin1();
+        sendSweep("$S11,run,calon,ri,point=%d,CS,cent=%.0f,span=%.0f\n", cent, span, pts);
 #endif
-        _pSocket->write(cmd);
-        qDebug() << cmd;
     }
 }
 
@@ -230,18 +583,31 @@ void MainWindow::S21(qreal cent, qreal span, int pts)
 {
     if(cent == 0 || span == 0 || pts == 0) return;
 //    if(isnan(cent) || isinf(cent) || isnan(span) || isinf(span)) return;
+    lastSweepType = S21Sweep;
+    lastCent = cent;
+    lastSpan = span;
+    lastPts = pts;
     startReceive();
     if( _pSocket->isWritable() ) {
 #ifdef KC901V_FIX
-        QByteArray cmd = QString("$S21,run,calon,lowlo,%1,CS,%2,%3\n").arg(pts).arg(cent,0,'f',0).arg(span,0,'f',0).toLatin1();
+        sendSweep("$S21,run,calon,lowlo,%d,CS,%.0f,%.0f\n", cent, span, pts);
 #else
-        QByteArray cmd = QString("$S21,run,calon,lowlo,point=%1,CS,cent=%2,span=%3\n").arg(pts).arg(cent,0,'f',0).arg(span,0,'f',0).toLatin1();
+        sendSweep("$S21,run,calon,lowlo,point=%d,CS,cent=%.0f,span=%.0f\n", cent, span, pts);
 #endif
-        _pSocket->write(cmd);
-        qDebug() << cmd;
     }
 }
 
+void MainWindow::sendSweep(const char *format, qreal cent, qreal span, int pts)
+//sweep command formatted into the reused command buffer, no strings per sweep
+{
+    sweepcmd.resize(sweepcmd.capacity());
+    int n = qsnprintf(sweepcmd.data(), sweepcmd.size(), format, pts, cent, span);
+    sweepcmd.resize(qBound(0, n, sweepcmd.size() - 1));
+    qint64 sendBegin = profiler->now();
+    sendCommand(sweepcmd);
+    profiler->commandSent(sendBegin, profiler->now());
+}
+
 
 void MainWindow::on_ConnectpushButton_clicked()
 {
@@ -266,20 +632,70 @@ void MainWindow::connectSuccess()
 void MainWindow::startReceive()
 //clear receive buffer and start receiver timer
 {
-    receivedata.clear();
+    //keeps the capacity, the buffer is reserved in the constructor
+    receivedata.resize(0);
     receiveElapsed->start();
     receiveTimer->start(1000);
 }
 
 void MainWindow::receiveTimeout()
+//a lost reply would stall the plan or the sweep loops: repeat the request, give up after a few
 {
     ui->statusBar->showMessage(trUtf8("数据接收超时"));
+    if(replay->isRunning()) return;
+    //a lost remote reply is not repeated, the client asks again
+    if(remoteInFlight)
+    {
+        remoteFinished();
+        return;
+    }
+    int retries = cfg->value("sweep/retries", 2).toInt();
+    if(sequencer->inFlight())
+    {
+        const MeasurementSequencer::Report &r = sequencer->currentReport();
+        if(++receiveTimeouts <= retries)
+        {
+            sendStep(r.step, r.modeSwitch);
+            return;
+        }
+        receiveTimeouts = 0;
+        int line = r.step.line;
+        sequencer->fail(sequenceElapsed->elapsed());
+        sequenceFinished();
+        ui->statusBar->showMessage(QString(trUtf8("测量计划中止: 第%1行无响应")).arg(line));
+        return;
+    }
+    bool looping = ui->ContinuouscheckBox->isChecked() || tracker->isActive();
+    if(!looping || sequencer->isRunning()) return;
+    if(++receiveTimeouts <= retries)
+    {
+        nextSweep();
+        return;
+    }
+    receiveTimeouts = 0;
+    ui->TrackcheckBox->setChecked(false);
+    ui->ContinuouscheckBox->setChecked(false);
+    ui->statusBar->showMessage(trUtf8("数据接收超时, 连续扫描已停止"));
 }
 
-void MainWindow::displayS11VSWR(QVector<qreal> freq, QVector<qreal> vswr)
+static void setSweepData(QwtPlotCurve *curve, const Sweep &sweep, const QVector<qreal> &y)
+//update the curve data in place once it reads from a sweep
 {
-    s11curve->setData(new QwtPointArrayData(freq, vswr));
+    SweepSeriesData *data = dynamic_cast<SweepSeriesData *>(curve->data());
+    if(!data)
+    {
+        curve->setData(new SweepSeriesData(sweep, y));
+        return;
+    }
+    data->setSamples(sweep, y);
+    curve->itemChanged();
+}
+
+void MainWindow::displayS11VSWR(const Sweep &sweep, const QVector<qreal> &vswr)
+{
+    setSweepData(s11curve, sweep, vswr);
     s11curve->setVisible(true);
+    checkLimits(sweep, vswr);
     //s21curve->setVisible(false);
     if(autoscaleAndZoomReset)
     {
@@ -294,21 +710,30 @@ void MainWindow::displayS11VSWR(QVector<qreal> freq, QVector<qreal> vswr)
     {
         ui->plot->setAxisAutoScale(QwtPlot::yLeft, false);
         ui->plot->setAxisAutoScale(QwtPlot::xBottom, false);
-        ui->plot->replot();
+        scheduleReplot();
     }
 }
 
 
-void MainWindow::displayS11RI(QVector<qreal> freq, QVector<QPointF> ri)
+void MainWindow::displayProcessed(const Sweep &sweep, const QVector<qreal> &values)
+{
+    //no replot here, the live trace display that follows does it
+    setSweepData(proccurve, sweep, values);
+    proccurve->setVisible(true);
+}
+
+void MainWindow::displayS11RI(const Sweep &sweep)
 {
+    ProfileScope scope(profiler, Profiler::Smith);
     ui->smith->clear();
-    ui->smith->setReflection(ri);
+    ui->smith->setReflection(sweep.ri());
 }
 
-void MainWindow::displayS21(QVector<qreal> freq, QVector<qreal> lose)
+void MainWindow::displayS21(const Sweep &sweep, const QVector<qreal> &lose)
 {
-    s21curve->setData(new QwtPointArrayData(freq, lose));
+    setSweepData(s21curve, sweep, lose);
     s21curve->setVisible(true);
+    checkLimits(sweep, lose);
     //s21curve->setVisible(false);
     if(autoscaleAndZoomReset)
     {
@@ -323,7 +748,7 @@ void MainWindow::displayS21(QVector<qreal> freq, QVector<qreal> lose)
     {
         ui->plot->setAxisAutoScale(QwtPlot::yLeft, false);
         ui->plot->setAxisAutoScale(QwtPlot::xBottom, false);
-        ui->plot->replot();
+        scheduleReplot();
     }
 }
 
@@ -346,104 +771,217 @@ void MainWindow::refinePlot()
 
 void MainWindow::autoRefine()
 {
-    if(autoRefineEnable)
+    //the sweep loop sets the axes itself
+    if(autoRefineEnable && !ui->ContinuouscheckBox->isChecked() && !tracker->isActive())
         refinePlot();
 }
 
 void MainWindow::readTcpData()
 {
-    QByteArray newdata = _pSocket->readAll();
-    if(newdata.isEmpty()) return;
-    receivedata.append(newdata);
+    //read into the reused receive buffer, no temporary per chunk
+    qint64 available = _pSocket->bytesAvailable();
+    if(available <= 0) return;
+    int size = receivedata.size();
+    receivedata.resize(size + available);
+    qint64 got = _pSocket->read(receivedata.data() + size, available);
+    receivedata.resize(size + qMax<qint64>(got, 0));
+    if(capture->isActive())
+        capture->record(WireCapture::Received, receivedata.constData() + size, receivedata.size() - size);
+    processReceived(size);
+}
+
+static SweepParser::Reply expectedReply(MeasurementSequencer::StepType type)
+{
+    switch(type)
+    {
+    case MeasurementSequencer::VswrStep: return SweepParser::VswrReply;
+    case MeasurementSequencer::RiStep: return SweepParser::RiReply;
+    default: return SweepParser::S21Reply;
+    }
+}
+
+void MainWindow::processReceived(int size)
+//bytes from size on are new, read from the socket or replayed from a capture
+{
+    profiler->firstByte();
     receiveTimer->start(1000);
-    if(receivedata.contains("$end"))
+    if(receivedata.indexOf("$end", qMax(0, size - 3)) >= 0)
     {
         receiveTimer->stop();
+        bool sweepDone = false;
+        qint64 deltaT = receiveElapsed->elapsed();
+        profiler->replyEnd();
 
-        QStringList list = receivedata.split(QRegExp("[$\n]"));
-        list.removeAll("");
-
-        if(list[0] == "start,s11,vswr" && list[list.size()-1] == "end")
+        SweepParser::Reply reply;
+        Sweep sweep;
         {
-            //get s11 vswr
-            list.removeFirst();
-            list.removeLast();
-            QVector<qreal> freq(list.size());
-            QVector<qreal> vswr(list.size());
-            for(int i = 0; i < list.size(); i++)
+            ProfileScope scope(profiler, Profiler::Parse);
+            reply = SweepParser::type(receivedata);
+            sweep = SweepParser::parse(receivedata);
+        }
+        //an init or id reply in between, the sweep of the plan step is still to come
+        if(sequencer->inFlight() && reply != expectedReply(sequencer->current().type))
+        {
+            int end = receivedata.indexOf('\n', receivedata.indexOf("$end"));
+            receivedata.remove(0, end < 0 ? receivedata.size() : end + 1);
+            receiveTimer->start(1000);
+            if(!receivedata.isEmpty())
+                processReceived(0);
+            return;
+        }
+        receiveTimeouts = 0;
+        if(!sweep.isNull())
+        {
+            //raw sweep to the local subscribers before any display work
+            if(server->clientCount() > 0)
+                server->publish(sweep);
+            if(ring->isOpen())
+                ring->publish(sweep, lastCent, lastSpan, QDateTime::currentMSecsSinceEpoch());
+            //the publish answers a remote request, none of it is the sweep of the operator
+            if(remoteInFlight)
             {
-                QStringList sample = list[i].split(',');
-                if(sample.size() < 2) continue;
-                freq[i] = sample[0].toDouble();
-                vswr[i] = sample[1].toDouble();
-                //qDebug() << QPointF(freq[i], vswr[i]);
+                profiler->endSweep();
+                remoteFinished();
+                return;
             }
-            qint64 deltaT = receiveElapsed->elapsed();
-            ui->statusBar->showMessage(QString(trUtf8("VSWR:采集到%1数据点,耗时%2ms")).arg(list.size()).arg(deltaT));
-            displayS11VSWR(freq, vswr);
+            lastSweep = sweep;
+            if(recorder->isWriting())
+            {
+                recorder->append(sweep, lastCent, lastSpan, QDateTime::currentMSecsSinceEpoch());
+                if(recorder->count() % 64 == 1)
+                    ui->ArchiveStatuslabel->setText(QString("%1 sweeps, %2 kB, %3:1")
+                                                    .arg(recorder->count()).arg(recorder->fileBytes() / 1024)
+                                                    .arg(qreal(recorder->rawBytes()) / qMax<qint64>(recorder->fileBytes(), 1), 0, 'f', 1));
+            }
+            //the summary line goes out with the readout
+            readoutReply = reply;
+            readoutPoints = sweep.size();
+            readoutMs = deltaT;
+            scheduleReadout();
+        }
+        else
+            ui->label->setPlainText(QString::fromUtf8(receivedata));
+        if(reply == SweepParser::IdReply)
+        {
+            QStringList list = QString::fromUtf8(receivedata).split(QRegExp("[$\n]"), QString::SkipEmptyParts);
+            ui->statusBar->showMessage(QString(trUtf8("申请控制成功, 目标设备序列号%1").arg(list.value(1))));
         }
 
-        if(list[0] == "start,s21" && list[list.size()-1] == "end")
+        //reply to a plan step: send the next one before the display work
+        bool sequenced = sequencer->inFlight();
+        if(sequenced)
         {
-            //get s21 vswr
-            list.removeFirst();
-            list.removeLast();
-            QVector<qreal> freq(list.size());
-            QVector<qreal> s21(list.size());
-            for(int i = 0; i < list.size(); i++)
-            {
-                QStringList sample = list[i].split(',');
-                if(sample.size() < 3) continue;
-                freq[i] = sample[0].toDouble();
-                s21[i] = sample[1].toDouble();
-            }
-            qint64 deltaT = receiveElapsed->elapsed();
-            ui->statusBar->showMessage(QString(trUtf8("S21:采集到%1数据点,耗时%2ms")).arg(list.size()).arg(deltaT));
-            displayS21(freq, s21);
+            mesmode = sequencer->current().mesmode;
+            ui->PeakModecomboBox->setCurrentIndex(mesmode == 2 ? 1 : 0);
+            autoscaleAndZoomReset = true;
+            sequencer->done(sequenceElapsed->elapsed(), sweep.size());
+            if(sequencer->hasNext())
+                sequenceStep();
+            else
+                sequenceFinished();
         }
+        //the loops sweep the same dut over and over, single sweeps and plan steps are the units
+        bool unit = sequenced || !(ui->ContinuouscheckBox->isChecked() || tracker->isActive());
 
+        if(reply == SweepParser::VswrReply)
+        {
+            //get s11 vswr
+            sweep = applyTraceMath(sweep);
+            const QVector<qreal> &freq = sweep.freq();
+            const QVector<qreal> &vswr = sweep.value();
+            showImpedanceView(false);
+            //return loss from vswr for the search and the waterfall
+            if(ui->PeakcheckBox->isChecked())
+                analyzeTrace(freq, sweep.db());
+            if(ui->WaterfallcheckBox->isChecked())
+                ui->waterfall->addSweep(freq, sweep.db());
+            if(scalarproc->mode() != TraceProcessor::Off)
+                displayProcessed(sweep, phaseproc->smooth(scalarproc->process(freq, vswr)));
+            displayS11VSWR(sweep, phaseproc->smooth(vswr));
+            collectStats(sweep, unit);
+            scoreGolden(sweep);
+            sweepDone = true;
+        }
 
+        if(reply == SweepParser::S21Reply)
+        {
+            //get s21 vswr
+            sweep = applyTraceMath(sweep);
+            const QVector<qreal> &freq = sweep.freq();
+            const QVector<qreal> &s21 = sweep.value();
+            showImpedanceView(false);
+            analyzeTrace(freq, s21);
+            if(ui->WaterfallcheckBox->isChecked())
+                ui->waterfall->addSweep(freq, s21);
+            if(scalarproc->mode() != TraceProcessor::Off)
+                displayProcessed(sweep, phaseproc->smooth(scalarproc->process(freq, s21)));
+            displayS21(sweep, phaseproc->smooth(s21));
+            if(ui->FitContinuouscheckBox->isChecked())
+                runFit(sweep);
+            collectStats(sweep, unit);
+            scoreGolden(sweep);
+            sweepDone = true;
+        }
 
-        if(list[0] == "start,s11,ri" && list[list.size()-1] == "end")
+        if(reply == SweepParser::RiReply)
         {
             //get s11 rl
-            list.removeFirst();
-            list.removeLast();
-            QVector<qreal> freq(list.size());
-            QVector<QPointF> s11(list.size());
-            QVector<qreal> S11dB(list.size());
-            QVector<qreal> S11VSWR(list.size());
-            for(int i = 0; i < list.size(); i++)
+            //port extension, then the what-if network, before every s11 view
+            if(ui->PortExtcheckBox->isChecked())
+            {
+                sweep = extendPort(sweep);
+                lastSweep = sweep;
+            }
+            if(ui->NetworkcheckBox->isChecked())
+            {
+                ProfileScope scope(profiler, Profiler::Math);
+                sweep = network->apply(sweep);
+                lastSweep = sweep;
+            }
+            //health figures of the corrected s11, once for the trend store and the statistics
+            const QVector<qreal> *figures = 0;
+            if(trend->isOpen() || (unit && ui->SpccheckBox->isChecked()))
             {
-                QStringList sample = list[i].split(',');
-                if(sample.size() < 3) continue;
-                freq[i] = sample[0].toDouble();
-                s11[i] = QPointF(sample[1].toDouble(), sample[2].toDouble());
-                S11dB[i] = 20*log10(sqrt(pow(s11[i].rx(),2) + pow(s11[i].ry(),2)));
-                S11VSWR[i] = (1+sqrt(pow(s11[i].rx(),2) + pow(s11[i].ry(),2)))/(1-sqrt(pow(s11[i].rx(),2) + pow(s11[i].ry(),2)));
+                ProfileScope scope(profiler, Profiler::Math);
+                figures = &kpis->extract(sweep);
+                if(trend->isOpen())
+                    trend->append(QDateTime::currentMSecsSinceEpoch(), *figures);
             }
-            qint64 deltaT = receiveElapsed->elapsed();
-            ui->statusBar->showMessage(QString(trUtf8("S11:采集到%1数据点,耗时%2ms")).arg(list.size()).arg(deltaT));
-            displayS11RI(freq, s11);
-            if(mesmode == 1){
-                displayS11VSWR(freq, S11dB);
+            //memory math last, the trend keeps the figures of the dut
+            sweep = applyTraceMath(sweep);
+            const QVector<qreal> &freq = sweep.freq();
+            const QVector<QPointF> &s11 = sweep.ri();
+            displayS11RI(sweep);
+            if(ui->PeakcheckBox->isChecked())
+                analyzeTrace(freq, sweep.db(), &s11);
+            if(ui->WaterfallcheckBox->isChecked())
+                ui->waterfall->addSweep(freq, sweep.db());
+            //average on the complex data, then convert to the displayed unit
+            if(s11proc->mode() != TraceProcessor::Off)
+                displayProcessed(sweep, s11Values(freq, s11proc->process(freq, s11)));
+            showImpedanceView(mesmode == 5);
+            if(mesmode == 5){
+                displayImpedance(sweep);
             }
-            if(mesmode == 0){
-                displayS11VSWR(freq, S11VSWR);
+            else if(mesmode == 2){
+                displayS21(sweep, s11Values(sweep));
             }
-            if(mesmode == 2){
-                displayS21(freq, S11VSWR);
+            else{
+                displayS11VSWR(sweep, s11Values(sweep));
             }
+            if(ui->FitContinuouscheckBox->isChecked())
+                runFit(sweep);
+            collectStats(sweep, unit, figures);
+            scoreGolden(sweep);
+            sweepDone = true;
 
         }
 
-        if(list[0] == "start,id" && list[list.size()-1] == "end")
-        {
-            ui->statusBar->showMessage(QString(trUtf8("申请控制成功, 目标设备序列号%1").arg(list[1])));
-        }
+        profiler->endSweep();
+
+        if(sweepDone && !sequenced) sweepFinished();
 
     }
-    ui->label->setPlainText(receivedata);
 }
 
 void MainWindow::on_SendpushButton_clicked()
@@ -452,7 +990,7 @@ void MainWindow::on_SendpushButton_clicked()
     cmddata = senddata.toUtf8();
     startReceive();
     if( _pSocket->isWritable() ) {
-        _pSocket->write("$" + cmddata + "\n" );
+        sendCommand("$" + cmddata + "\n" );
     }
 
 }
@@ -465,7 +1003,7 @@ void MainWindow::on_ClosepushButton_clicked()
 void MainWindow::on_ControlpushButton_clicked()
 {
     if( _pSocket->isWritable() ) {
-        _pSocket->write("C");
+        sendCommand("C");
         startReceive();
     }
 }
@@ -473,17 +1011,18 @@ void MainWindow::on_ControlpushButton_clicked()
 void MainWindow::on_LocalpushButton_2_clicked()
 {
     if( _pSocket->isWritable() ) {
-        _pSocket->write("$local\n");
+        sendCommand("$local\n");
     }
 }
 
 void MainWindow::on_S11initpushButton_clicked()
 {
     autoscaleAndZoomReset = true;
-    _pSocket->write("$S21,stop\n");
+    resetProcessing();
+    sendCommand("$S21,stop\n");
 
     if( _pSocket->isWritable() ) {
-        _pSocket->write("$S11,init\n");
+        sendCommand("$S11,init\n");
     }
 
 #ifdef KC901V_FIX
@@ -499,17 +1038,19 @@ void MainWindow::on_S11initpushButton_clicked()
     ui->CentlineEdit->setText(QString("%1").arg(cent));
     ui->SpanlineEdit->setText(QString("%1").arg(span));
     ui->PointlineEdit->setText(QString("%1").arg(pts));
+    ui->PeakModecomboBox->setCurrentIndex(0);
 
     VSWR(cent, span, pts);
 }
 
 void MainWindow::on_S21initpushButton_clicked()
 {
-    _pSocket->write("$S11,stop\n");
+    sendCommand("$S11,stop\n");
     autoscaleAndZoomReset = true;
+    resetProcessing();
 
     if( _pSocket->isWritable() ) {
-        _pSocket->write("$S21,init\n");
+        sendCommand("$S21,init\n");
     }
 
 #ifdef KC901V_FIX
@@ -529,6 +1070,7 @@ void MainWindow::on_S21initpushButton_clicked()
     S21(cent, span, pts);
 
     mesmode = 2; //s21 mode
+    ui->PeakModecomboBox->setCurrentIndex(1);
 
 }
 
@@ -560,6 +1102,34 @@ void MainWindow::on_vswrmespushButton_clicked()
     mesmode = 0; //vswr mesmode
 }
 
+void MainWindow::on_PhaseMes_clicked()
+{
+    qreal cent, span;
+    int pts;
+    bool convert_ok = parseCentSpanPts(&cent, &span, &pts);
+    if(!convert_ok) return;
+
+    autoscaleAndZoomReset = true;
+    ui->history->insertItem(0,QString("C=%1,SP=%2,%3pts").arg(cent).arg(span).arg(pts));
+
+    RI(cent, span, pts);
+    mesmode = 3; //unwrapped phase mesmode
+}
+
+void MainWindow::on_GDMes_clicked()
+{
+    qreal cent, span;
+    int pts;
+    bool convert_ok = parseCentSpanPts(&cent, &span, &pts);
+    if(!convert_ok) return;
+
+    autoscaleAndZoomReset = true;
+    ui->history->insertItem(0,QString("C=%1,SP=%2,%3pts").arg(cent).arg(span).arg(pts));
+
+    RI(cent, span, pts);
+    mesmode = 4; //group delay mesmode
+}
+
 void MainWindow::on_history_doubleClicked(const QModelIndex &index)
 {
     QString str = index.data().toString();
@@ -609,3 +1179,1489 @@ bool MainWindow::parseCentSpanPts(qreal *cent, qreal *span, int *pts)
     }
     return true;
 }
+
+void MainWindow::resetProcessing()
+{
+    s11proc->reset();
+    scalarproc->reset();
+}
+
+void MainWindow::on_TraceModecomboBox_currentIndexChanged(int index)
+{
+    TraceProcessor::Mode mode = TraceProcessor::Mode(index);
+    s11proc->setMode(mode);
+    scalarproc->setMode(mode);
+    proccurve->setVisible(false);
+    ui->plot->replot();
+}
+
+void MainWindow::on_AvgCountspinBox_valueChanged(int count)
+{
+    s11proc->setCount(count);
+    scalarproc->setCount(count);
+}
+
+void MainWindow::on_TraceResetpushButton_clicked()
+{
+    resetProcessing();
+}
+
+void MainWindow::on_AperturespinBox_valueChanged(int points)
+{
+    phaseproc->setAperture(points);
+}
+
+void MainWindow::on_SmoothspinBox_valueChanged(int points)
+{
+    phaseproc->setSmoothing(points);
+}
+
+//ZLeftcomboBox entries, a pair is drawn as two traces on the left axis
+static const ImpedanceCalculator::Quantity leftQuantities[][2] = {
+    { ImpedanceCalculator::Resistance, ImpedanceCalculator::Reactance },
+    { ImpedanceCalculator::Resistance, ImpedanceCalculator::QuantityCount },
+    { ImpedanceCalculator::Reactance, ImpedanceCalculator::QuantityCount },
+    { ImpedanceCalculator::Magnitude, ImpedanceCalculator::QuantityCount },
+    { ImpedanceCalculator::Conductance, ImpedanceCalculator::Susceptance },
+    { ImpedanceCalculator::Conductance, ImpedanceCalculator::QuantityCount },
+    { ImpedanceCalculator::Susceptance, ImpedanceCalculator::QuantityCount },
+    { ImpedanceCalculator::SeriesL, ImpedanceCalculator::QuantityCount },
+    { ImpedanceCalculator::SeriesC, ImpedanceCalculator::QuantityCount }
+};
+
+//ZRightcomboBox entries after None
+static const ImpedanceCalculator::Quantity rightQuantities[] = {
+    ImpedanceCalculator::Resistance,
+    ImpedanceCalculator::Reactance,
+    ImpedanceCalculator::Magnitude,
+    ImpedanceCalculator::Conductance,
+    ImpedanceCalculator::Susceptance,
+    ImpedanceCalculator::SeriesL,
+    ImpedanceCalculator::SeriesC
+};
+
+const QVector<qreal> &MainWindow::s11Values(const Sweep &sweep)
+//live s11 trace in the unit of the current mesmode, from the sweep columns
+{
+    if(mesmode >= 3)
+        return s11Values(sweep.freq(), sweep.ri());
+    ProfileScope scope(profiler, Profiler::Math);
+    return phaseproc->smooth(mesmode == 1 ? sweep.db() : sweep.vswr());
+}
+
+const QVector<qreal> &MainWindow::s11Values(const QVector<qreal> &freq, const QVector<QPointF> &ri)
+//s11 trace in the unit of the current mesmode, smoothed, valid until the next call
+{
+    ProfileScope scope(profiler, Profiler::Math);
+    if(mesmode == 3)
+        return phaseproc->smooth(phaseproc->unwrappedPhase(ri));
+    if(mesmode == 4)
+        return phaseproc->smooth(phaseproc->groupDelay(freq, ri));
+    if(mesmode == 5)
+    {
+        //first quantity of the left axis
+        zcalcproc->computeFromReflection(freq, ri, impedanceMask());
+        return phaseproc->smooth(zcalcproc->values(leftQuantities[ui->ZLeftcomboBox->currentIndex()][0]));
+    }
+
+    s11buffer.resize(ri.size());
+    for(int i = 0; i < ri.size(); i++)
+    {
+        qreal mag = sqrt(pow(ri[i].x(),2) + pow(ri[i].y(),2));
+        s11buffer[i] = mesmode == 1 ? 20*log10(mag) : (1+mag)/(1-mag);
+    }
+    return phaseproc->smooth(s11buffer);
+}
+
+void MainWindow::loadLimitMask(const QString &fileName)
+{
+    QString error;
+    if(!limitmask->load(fileName, &error))
+    {
+        ui->statusBar->showMessage(QString(trUtf8("模板文件错误: %1")).arg(error));
+        return;
+    }
+    cfg->setValue("limit/file", fileName);
+    ui->LimitFilelabel->setText(QFileInfo(fileName).fileName());
+    upperlimitcurve->setSamples(limitmask->outline(true));
+    lowerlimitcurve->setSamples(limitmask->outline(false));
+    upperlimitcurve->setVisible(ui->LimitcheckBox->isChecked());
+    lowerlimitcurve->setVisible(ui->LimitcheckBox->isChecked());
+    ui->plot->replot();
+}
+
+static LimitMask::Unit traceUnit(const Sweep &sweep, int mesmode)
+//unit of the trace the views show for sweep
+{
+    if(sweep.kind() == Sweep::S21) return LimitMask::S21;
+    if(sweep.kind() == Sweep::Vswr) return LimitMask::Vswr;
+    switch(mesmode)
+    {
+    case 1: return LimitMask::Db;
+    case 3: return LimitMask::Phase;
+    case 4: return LimitMask::Delay;
+    case 5: return LimitMask::NoUnit;
+    default: return LimitMask::Vswr;
+    }
+}
+
+void MainWindow::checkLimits(const Sweep &sweep, const QVector<qreal> &values)
+//test the displayed trace against the limit mask, called before replot
+{
+    ProfileScope scope(profiler, Profiler::Math);
+    limitVerdict = -1;
+    if(!ui->LimitcheckBox->isChecked() || limitmask->isEmpty())
+    {
+        failcurve->setVisible(false);
+        showLimitLabel(-1);
+        return;
+    }
+
+    //a trace in another unit is neither pass nor fail
+    LimitMask::Unit unit = traceUnit(sweep, mesmode);
+    if(unit != limitmask->unit())
+    {
+        failcurve->setVisible(false);
+        limitTraceUnit = unit;
+        showLimitLabel(2);
+        scheduleReadout();
+        return;
+    }
+
+    const QVector<qreal> &freq = sweep.freq();
+    LimitMask::Result result = limitmask->test(freq, values);
+    if(!result.pass)
+        failcurve->setSamples(limitmask->failFreq(), limitmask->failValue());
+    failcurve->setVisible(!result.pass);
+    showLimitLabel(result.pass ? 1 : 0);
+
+    limitVerdict = result.pass ? 1 : 0;
+    if(result.pass) limitPass++;
+    else limitFail++;
+    limitMargin = result.worstMargin;
+    limitMarginFreq = result.worstFreq;
+    scheduleReadout();
+
+    if(limitlog->isOpen())
+    {
+        QTextStream out(limitlog);
+        out << QDateTime::currentDateTime().toString(Qt::ISODate) << ','
+            << QFileInfo(limitmask->fileName()).fileName() << ','
+            << (result.pass ? "PASS" : "FAIL") << ','
+            << result.failPoints << ','
+            << result.worstMargin << ','
+            << QString::number(result.worstFreq, 'f', 0) << '\n';
+        out.flush();
+    }
+}
+
+void MainWindow::showLimitLabel(int state)
+//verdict label on the plot, rebuilt only when the verdict changes
+{
+    if(state == limitShown) return;
+    limitShown = state;
+    if(state < 0)
+    {
+        limitlabel->setVisible(false);
+        return;
+    }
+    static const char *names[] = { "FAIL", "PASS", "UNIT" };
+    static const Qt::GlobalColor colors[] = { Qt::red, Qt::darkGreen, Qt::darkGray };
+    QwtText text(names[state]);
+    text.setRenderFlags(Qt::AlignTop | Qt::AlignRight);
+    text.setFont(QFont("consolas", 16, QFont::Bold));
+    text.setColor(Qt::white);
+    text.setBackgroundBrush(QBrush(colors[state]));
+    limitlabel->setText(text);
+    limitlabel->setVisible(true);
+}
+
+void MainWindow::on_LimitLoadpushButton_clicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, trUtf8("打开模板"),
+                            cfg->value("limit/file").toString(),
+                            trUtf8("Limit mask (*.txt *.lim);;All files (*)"));
+    if(fileName.isEmpty()) return;
+    loadLimitMask(fileName);
+}
+
+void MainWindow::on_LimitClearpushButton_clicked()
+{
+    limitPass = 0;
+    limitFail = 0;
+    ui->LimitResultlabel->clear();
+}
+
+void MainWindow::on_LimitcheckBox_toggled(bool checked)
+{
+    upperlimitcurve->setVisible(checked && !limitmask->isEmpty());
+    lowerlimitcurve->setVisible(checked && !limitmask->isEmpty());
+    if(!checked)
+    {
+        failcurve->setVisible(false);
+        showLimitLabel(-1);
+    }
+    ui->plot->replot();
+}
+
+void MainWindow::on_LimitLogcheckBox_toggled(bool checked)
+{
+    if(!checked)
+    {
+        limitlog->close();
+        return;
+    }
+    if(!limitlog->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        ui->statusBar->showMessage(QString(trUtf8("无法打开日志文件 %1")).arg(limitlog->fileName()));
+        ui->LimitLogcheckBox->setChecked(false);
+    }
+}
+
+void MainWindow::hidePeakMarkers()
+{
+    resmarker->setVisible(false);
+    bwmarkers[0]->setVisible(false);
+    bwmarkers[1]->setVisible(false);
+    for(int i = 0; i < notchmarkers.size(); i++)
+        notchmarkers[i]->setVisible(false);
+    ui->smith->setMarkers(QVector<QPointF>());
+}
+
+void MainWindow::analyzeTrace(const QVector<qreal> &freq, const QVector<qreal> &db, const QVector<QPointF> *ri)
+//peak / notch search on a dB trace, places the markers before the replot
+{
+    ProfileScope scope(profiler, Profiler::Math);
+    hidePeakMarkers();
+    if(!ui->PeakcheckBox->isChecked()) return;
+
+    const PeakSearch::Result &r = peaksearch->search(freq, db);
+    if(!r.valid) return;
+
+    //marker labels and the readout text follow in readoutNow
+    resmarker->setXValue(r.freq);
+    resmarker->setVisible(true);
+    if(r.bw3 > 0)
+    {
+        bwmarkers[0]->setXValue(r.bw3Low);
+        bwmarkers[1]->setXValue(r.bw3High);
+        bwmarkers[0]->setVisible(true);
+        bwmarkers[1]->setVisible(true);
+    }
+
+    const QVector<PeakSearch::Notch> &notches = peaksearch->notches();
+    smithmarkers.resize(0);
+    if(ri && r.index < ri->size()) smithmarkers.append(ri->at(r.index));
+    for(int i = 0; i < notches.size() && i < notchmarkers.size(); i++)
+    {
+        notchmarkers[i]->setXValue(notches[i].freq);
+        notchmarkers[i]->setVisible(true);
+        if(ri && notches[i].index < ri->size()) smithmarkers.append(ri->at(notches[i].index));
+    }
+    if(ri) ui->smith->setMarkers(smithmarkers);
+    scheduleReadout();
+}
+
+void MainWindow::showPeakReadout()
+//text of the last search into the markers and the readout
+{
+    const PeakSearch::Result &r = peaksearch->result();
+    QString readout = QString("f0 %1 MHz\n%2 dB").arg(r.freq/1e6, 0, 'f', 3).arg(r.value, 0, 'f', 2);
+    if(r.bw3 > 0)
+        readout += QString("\nBW3 %1 MHz\nfc %2 MHz\nQ %3")
+                   .arg(r.bw3/1e6, 0, 'f', 3).arg(r.center/1e6, 0, 'f', 3).arg(r.q, 0, 'f', 1);
+    if(r.bw10 > 0)
+        readout += QString("\nBW10 %1 MHz").arg(r.bw10/1e6, 0, 'f', 3);
+
+    QwtText label(readout);
+    label.setColor(Qt::green);
+    resmarker->setLabel(label);
+
+    const QVector<PeakSearch::Notch> &notches = peaksearch->notches();
+    for(int i = 0; i < notches.size() && i < notchmarkers.size(); i++)
+    {
+        QwtText notchLabel(QString("%1: %2 MHz %3 dB").arg(i+1)
+                           .arg(notches[i].freq/1e6, 0, 'f', 3).arg(notches[i].value, 0, 'f', 2));
+        notchLabel.setColor(Qt::magenta);
+        notchmarkers[i]->setLabel(notchLabel);
+    }
+    ui->PeakResultlabel->setText(readout);
+}
+
+void MainWindow::on_PeakcheckBox_toggled(bool checked)
+{
+    if(!checked)
+    {
+        hidePeakMarkers();
+        ui->PeakResultlabel->clear();
+        ui->plot->replot();
+    }
+}
+
+void MainWindow::on_PeakModecomboBox_currentIndexChanged(int index)
+{
+    peaksearch->setPeakMode(index == 1);
+}
+
+void MainWindow::on_NotchCountspinBox_valueChanged(int count)
+{
+    peaksearch->setNotchCount(count);
+}
+
+void MainWindow::sweepFinished()
+//closes the tracking loop and keeps continuous sweeps going
+{
+    if(tracker->isActive())
+    {
+        ResonanceTracker::State state = tracker->state();
+        tracker->update(peaksearch->result(), lastCent, lastSpan, lastPts);
+        if(tracker->state() != state)
+            ui->TrackStatelabel->setText(tracker->stateName());
+        scheduleReadout();
+    }
+    else if(ui->AutoCentercheckBox->isChecked() && ui->PeakcheckBox->isChecked() && peaksearch->result().valid)
+    {
+        //next sweep centred on the resonance, span a few bandwidths wide
+        const PeakSearch::Result &r = peaksearch->result();
+        lastCent = r.freq;
+        if(r.bw3 > 0)
+            lastSpan = r.bw3 * centerSpanFactor;
+        scheduleReadout();
+    }
+    //a replay feeds the receive path by itself
+    if(replay->isRunning()) return;
+    //queued remote requests go first, the loops resume after them
+    if(server->hasRequest() && !sequencer->isRunning())
+    {
+        QTimer::singleShot(0, this, SLOT(serveRequest()));
+        return;
+    }
+    if(ui->ContinuouscheckBox->isChecked() || tracker->isActive())
+        QTimer::singleShot(0, this, SLOT(nextSweep()));
+}
+
+void MainWindow::nextSweep()
+{
+    if(tracker->isActive())
+    {
+        lastCent = tracker->cent();
+        lastSpan = tracker->span();
+        lastPts = tracker->pts();
+        //the line edits follow with the readout
+        autoscaleAndZoomReset = true;
+    }
+
+    switch(lastSweepType)
+    {
+    case VswrSweep: VSWR(lastCent, lastSpan, lastPts); break;
+    case RiSweep: RI(lastCent, lastSpan, lastPts); break;
+    case S21Sweep: S21(lastCent, lastSpan, lastPts); break;
+    default: break;
+    }
+}
+
+void MainWindow::on_TrackcheckBox_toggled(bool checked)
+{
+    if(!checked)
+    {
+        tracker->stop();
+        ui->TrackStatelabel->setText(tracker->stateName());
+        return;
+    }
+
+    qreal cent, span;
+    int pts;
+    if(!parseCentSpanPts(&cent, &span, &pts))
+    {
+        ui->TrackcheckBox->setChecked(false);
+        return;
+    }
+    tracker->setSpanFactor(cfg->value("track/spanfactor", 4.0).toDouble());
+    tracker->setMinSpan(cfg->value("track/minspan", 10e3).toDouble());
+    tracker->setMinDepth(cfg->value("track/mindepth", 3.0).toDouble());
+    //denser once locked, a few times the search points up to what the instrument sweeps
+    int maxPts = cfg->value("instrument/maxpts", 1000).toInt();
+    tracker->setLockPoints(cfg->value("track/lockpts", qMax(pts, qMin(4 * pts, maxPts))).toInt());
+    tracker->start(cent, span, pts);
+    ui->TrackStatelabel->setText(tracker->stateName());
+
+    //tracking runs on the search result of every sweep
+    ui->PeakcheckBox->setChecked(true);
+    if(lastSweepType == NoSweep || lastSweepType == VswrSweep)
+        lastSweepType = mesmode == 2 ? S21Sweep : RiSweep;
+    lastCent = cent;
+    lastSpan = span;
+    lastPts = pts;
+    autoscaleAndZoomReset = true;
+    nextSweep();
+}
+
+void MainWindow::on_FastcheckBox_toggled(bool fast)
+{
+    s11curve->setFastMode(fast);
+    s21curve->setFastMode(fast);
+    proccurve->setFastMode(fast);
+    fitcurve->setFastMode(fast);
+    if(!fast)
+    {
+        //back to the spline fitted, antialiased s11 trace
+        s11curve->setCurveAttribute(QwtPlotCurve::Fitted, true);
+        s11curve->setRenderHint(QwtPlotItem::RenderAntialiased, true);
+        s21curve->setRenderHint(QwtPlotItem::RenderAntialiased, false);
+        proccurve->setRenderHint(QwtPlotItem::RenderAntialiased, false);
+    }
+    ui->plot->replot();
+}
+
+void MainWindow::scheduleReplot()
+//replot at most plot/maxfps times a second, the latest data is always drawn
+{
+    if(replotTimer->isActive()) return;
+    qint64 wait = replotInterval - replotElapsed->elapsed();
+    if(wait <= 0)
+        replotNow();
+    else
+        replotTimer->start(wait);
+}
+
+void MainWindow::scheduleReadout()
+{
+    if(!readoutTimer->isActive())
+        readoutTimer->start(readoutInterval);
+}
+
+void MainWindow::readoutNow()
+//text of the latest sweep: formatted here a few times a second, not per sweep
+{
+    if(readoutReply)
+    {
+        static const char *names[] = { "", "VSWR", "S11", "S21" };
+        ui->statusBar->showMessage(QString(names[qMin(readoutReply, 3)]) + ":"
+                                   + QString(trUtf8("采集到%1数据点,耗时%2ms")).arg(readoutPoints).arg(readoutMs));
+        ui->label->setPlainText(QString("%1: %2 points").arg(SweepParser::header(SweepParser::Reply(readoutReply)))
+                                .arg(readoutPoints));
+        readoutReply = 0;
+    }
+    if(profiler->isEnabled())
+        ui->ProfileTextlabel->setText(profiler->summary());
+    if(server->clientCount() > 0)
+        updateStreamStatus();
+    //the loops moved the sweep, the line edits follow
+    if(tracker->isActive() || ui->AutoCentercheckBox->isChecked())
+    {
+        ui->CentlineEdit->setText(QString("%1").arg(lastCent, 0, 'f', 0));
+        ui->SpanlineEdit->setText(QString("%1").arg(lastSpan, 0, 'f', 0));
+        ui->PointlineEdit->setText(QString("%1").arg(lastPts));
+    }
+    if(ui->PeakcheckBox->isChecked() && resmarker->isVisible())
+    {
+        showPeakReadout();
+        scheduleReplot();
+    }
+    if(limitShown == 2)
+        ui->LimitResultlabel->setText(QString("PASS %1 / FAIL %2\nmask in %3, trace in %4")
+                                      .arg(limitPass).arg(limitFail)
+                                      .arg(LimitMask::unitName(limitmask->unit()))
+                                      .arg(limitTraceUnit == LimitMask::NoUnit ? QString("impedance")
+                                                                              : LimitMask::unitName(LimitMask::Unit(limitTraceUnit))));
+    else if(limitShown >= 0)
+        ui->LimitResultlabel->setText(QString("PASS %1 / FAIL %2\nmargin %3 @ %4")
+                                      .arg(limitPass).arg(limitFail)
+                                      .arg(limitMargin, 0, 'g', 4)
+                                      .arg(limitMarginFreq, 0, 'f', 0));
+    if(goldenScored)
+    {
+        goldenScored = false;
+        qreal distance = golden->distance();
+        if(qIsNaN(distance))
+        {
+            ui->GoldenScorelabel->setText("--");
+            ui->GoldenBandslabel->setText(trUtf8("No band on this sweep"));
+        }
+        else
+        {
+            ui->GoldenScorelabel->setText(QString("%1 dB").arg(distance, 0, 'f', 2));
+            ui->GoldenBandslabel->setText(golden->summary());
+        }
+    }
+}
+
+void MainWindow::replotNow()
+{
+    replotTimer->stop();
+    replotElapsed->restart();
+    //a deferred replot belongs to the sweep that scheduled it
+    qint64 begin = profiler->isEnabled() ? profiler->now() : -1;
+    ui->plot->replot();
+    if(begin >= 0) profiler->recordDeferred(Profiler::Replot, begin, profiler->now());
+    if(!golden->golden().isNull() && ui->Goldendock->isVisible())
+        ui->goldenplot->replot();
+}
+
+void MainWindow::on_WaterfallcheckBox_toggled(bool checked)
+{
+    //the waterfall is fed by the Cont sweep loop
+    if(checked) ui->waterfall->clear();
+}
+
+void MainWindow::on_WfMindoubleSpinBox_valueChanged(double value)
+{
+    ui->waterfall->setRange(value, ui->WfMaxdoubleSpinBox->value());
+}
+
+void MainWindow::on_WfMaxdoubleSpinBox_valueChanged(double value)
+{
+    ui->waterfall->setRange(ui->WfMindoubleSpinBox->value(), value);
+}
+
+void MainWindow::on_WaterfallClearpushButton_clicked()
+{
+    ui->waterfall->clear();
+}
+
+void MainWindow::loadSequence(const QString &fileName)
+{
+    QString error;
+    if(!sequencer->load(fileName, &error))
+    {
+        ui->statusBar->showMessage(QString(trUtf8("测量计划错误: %1")).arg(error));
+        return;
+    }
+    cfg->setValue("sequence/file", fileName);
+    ui->SeqFilelabel->setText(QFileInfo(fileName).fileName());
+    ui->SeqStatuslabel->setText(QString("%1 steps").arg(sequencer->stepCount()));
+}
+
+void MainWindow::sequenceStep()
+{
+    bool modeSwitch;
+    const MeasurementSequencer::Step &step = sequencer->next(sequenceElapsed->elapsed(), &modeSwitch);
+    sendStep(step, modeSwitch);
+}
+
+void MainWindow::sendStep(const MeasurementSequencer::Step &step, bool modeSwitch)
+//send a plan step, an init goes out in the same batch when the port changes
+{
+    if(modeSwitch && _pSocket->isWritable())
+    {
+        if(step.type == MeasurementSequencer::S21Step)
+            sendCommand("$S11,stop\n$S21,init\n");
+        else
+            sendCommand("$S21,stop\n$S11,init\n");
+    }
+
+    switch(step.type)
+    {
+    case MeasurementSequencer::VswrStep: VSWR(step.cent, step.span, step.pts); break;
+    case MeasurementSequencer::RiStep: RI(step.cent, step.span, step.pts); break;
+    case MeasurementSequencer::S21Step: S21(step.cent, step.span, step.pts); break;
+    }
+    ui->SeqStatuslabel->setText(QString("%1/%2 %3").arg(sequencer->completed() + 1)
+                                .arg(sequencer->scheduled()).arg(step.label));
+}
+
+void MainWindow::sequenceFinished()
+//write the timing report next to the plan
+{
+    if(sequencer->completed() == 0) return;
+    const QVector<MeasurementSequencer::Report> &report = sequencer->report();
+    qint64 total = 0;
+    for(int i = 0; i < report.size(); i++)
+        total = qMax(total, report[i].done);
+
+    QFileInfo plan(sequencer->fileName());
+    QString fileName = plan.absolutePath() + "/" + plan.completeBaseName()
+            + QDateTime::currentDateTime().toString("_yyyyMMdd_hhmmss") + ".csv";
+    QString error;
+    if(!sequencer->writeReport(fileName, &error))
+        ui->statusBar->showMessage(QString(trUtf8("无法写入报告 %1: %2")).arg(fileName).arg(error));
+    else
+        ui->statusBar->showMessage(QString(trUtf8("测量计划完成: %1/%2 步, %3 次切换, 耗时%4ms"))
+                                   .arg(sequencer->completed()).arg(sequencer->scheduled())
+                                   .arg(sequencer->modeSwitches()).arg(total));
+    ui->SeqStatuslabel->setText(QString("%1/%2 %3 ms").arg(sequencer->completed())
+                                .arg(sequencer->scheduled()).arg(total));
+}
+
+void MainWindow::on_SeqLoadpushButton_clicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, trUtf8("打开测量计划"),
+                            cfg->value("sequence/file").toString(),
+                            trUtf8("Measurement plan (*.txt *.seq);;All files (*)"));
+    if(fileName.isEmpty()) return;
+    loadSequence(fileName);
+}
+
+void MainWindow::on_SeqRunpushButton_clicked()
+{
+    //the plan drives the sweeps, stop the other loops
+    ui->ContinuouscheckBox->setChecked(false);
+    ui->TrackcheckBox->setChecked(false);
+
+    MeasurementSequencer::Port port = MeasurementSequencer::NoPort;
+    if(lastSweepType == S21Sweep) port = MeasurementSequencer::S21;
+    else if(lastSweepType != NoSweep) port = MeasurementSequencer::S11;
+    if(!sequencer->start(port))
+    {
+        ui->statusBar->showMessage(trUtf8("未加载测量计划"));
+        return;
+    }
+    resetProcessing();
+    sequenceElapsed->start();
+    sequenceStep();
+}
+
+void MainWindow::on_SeqStoppushButton_clicked()
+{
+    if(!sequencer->isRunning()) return;
+    sequenceFinished();
+    sequencer->stop();
+}
+
+void MainWindow::on_SeqReordercheckBox_toggled(bool checked)
+{
+    sequencer->setReorder(checked);
+}
+
+void MainWindow::on_Profiledock_visibilityChanged(bool visible)
+{
+    //no timing while nobody looks at it
+    profiler->setEnabled(visible);
+}
+
+void MainWindow::on_ProfileResetpushButton_clicked()
+{
+    profiler->reset();
+    ui->ProfileTextlabel->setText(profiler->summary());
+}
+
+void MainWindow::on_ProfileExportpushButton_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, trUtf8("导出性能记录"),
+                            cfg->value("profile/trace", "kc901_trace.json").toString(),
+                            trUtf8("Chrome trace (*.json);;All files (*)"));
+    if(fileName.isEmpty()) return;
+    cfg->setValue("profile/trace", fileName);
+    QString error;
+    if(profiler->exportTrace(fileName, &error))
+        ui->statusBar->showMessage(QString(trUtf8("已导出 %1")).arg(fileName));
+    else
+        ui->statusBar->showMessage(QString(trUtf8("无法写入 %1: %2")).arg(fileName).arg(error));
+}
+
+void MainWindow::on_ZMes_clicked()
+{
+    qreal cent, span;
+    int pts;
+    bool convert_ok = parseCentSpanPts(&cent, &span, &pts);
+    if(!convert_ok) return;
+
+    autoscaleAndZoomReset = true;
+    ui->history->insertItem(0,QString("C=%1,SP=%2,%3pts").arg(cent).arg(span).arg(pts));
+
+    RI(cent, span, pts);
+    mesmode = 5; //impedance / admittance mesmode
+}
+
+void MainWindow::on_ZLeftcomboBox_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    autoscaleAndZoomReset = true;
+    if(impedanceShown)
+    {
+        //yLeft title now, the trace with the next sweep
+        impedanceShown = false;
+        showImpedanceView(true);
+    }
+}
+
+void MainWindow::on_ZRightcomboBox_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    if(impedanceShown)
+    {
+        //axis and trace follow with the next sweep
+        impedanceShown = false;
+        showImpedanceView(true);
+    }
+}
+
+int MainWindow::impedanceMask() const
+//quantities the impedance view needs
+{
+    const ImpedanceCalculator::Quantity *left = leftQuantities[ui->ZLeftcomboBox->currentIndex()];
+    int mask = 1 << left[0];
+    if(left[1] != ImpedanceCalculator::QuantityCount) mask |= 1 << left[1];
+    int right = ui->ZRightcomboBox->currentIndex();
+    if(right > 0) mask |= 1 << rightQuantities[right-1];
+    return mask;
+}
+
+void MainWindow::showImpedanceView(bool show)
+//second left trace, right axis and axis titles of mesmode 5
+{
+    if(show == impedanceShown) return;
+    impedanceShown = show;
+    int right = ui->ZRightcomboBox->currentIndex();
+    const ImpedanceCalculator::Quantity *left = leftQuantities[ui->ZLeftcomboBox->currentIndex()];
+    bool pair = left[1] != ImpedanceCalculator::QuantityCount;
+
+    zcurve->setVisible(show && pair);
+    rightcurve->setVisible(show && right > 0);
+    ui->plot->enableAxis(QwtPlot::yRight, show && right > 0);
+    if(!show)
+    {
+        ui->plot->setAxisTitle(QwtPlot::yLeft, QString());
+        return;
+    }
+
+    QString title = QString("%1").arg(ImpedanceCalculator::name(left[0]));
+    if(pair) title += QString(", %1").arg(ImpedanceCalculator::name(left[1]));
+    ui->plot->setAxisTitle(QwtPlot::yLeft, QString("%1 (%2)").arg(title).arg(ImpedanceCalculator::unit(left[0])));
+    if(right > 0)
+    {
+        ImpedanceCalculator::Quantity q = rightQuantities[right-1];
+        ui->plot->setAxisTitle(QwtPlot::yRight, QString("%1 (%2)")
+                               .arg(ImpedanceCalculator::name(q)).arg(ImpedanceCalculator::unit(q)));
+        ui->plot->setAxisAutoScale(QwtPlot::yRight);
+    }
+}
+
+void MainWindow::displayImpedance(const Sweep &sweep)
+//all quantities in one pass, the first left one goes through the normal trace display
+{
+    const QVector<qreal> &freq = sweep.freq();
+    {
+        ProfileScope scope(profiler, Profiler::Math);
+        zcalc->compute(freq, sweep.z(), impedanceMask());
+    }
+
+    const ImpedanceCalculator::Quantity *left = leftQuantities[ui->ZLeftcomboBox->currentIndex()];
+    if(left[1] != ImpedanceCalculator::QuantityCount)
+        setSweepData(zcurve, sweep, phaseproc->smooth(zcalc->values(left[1])));
+    int right = ui->ZRightcomboBox->currentIndex();
+    if(right > 0)
+        setSweepData(rightcurve, sweep, phaseproc->smooth(zcalc->values(rightQuantities[right-1])));
+    displayS11VSWR(sweep, phaseproc->smooth(zcalc->values(left[0])));
+}
+
+bool MainWindow::compileNetwork()
+//chain from the editor, kept in the settings file: fixture files are relative to its directory
+{
+    QString error;
+    if(!network->parse(ui->ChainplainTextEdit->toPlainText(), QFileInfo(cfg->fileName()).absolutePath(), &error))
+    {
+        ui->NetworkStatuslabel->setText(error);
+        ui->NetworkcheckBox->setChecked(false);
+        return false;
+    }
+    ui->NetworkStatuslabel->setText(QString("%1 elements").arg(network->size()));
+    return true;
+}
+
+void MainWindow::on_NetworkCompilepushButton_clicked()
+{
+    if(!compileNetwork())
+        ui->statusBar->showMessage(QString(trUtf8("匹配网络错误: %1")).arg(ui->NetworkStatuslabel->text()));
+}
+
+void MainWindow::on_NetworkMatchpushButton_clicked()
+//append an L section matching the shown s11 at the center frequency
+{
+    qreal cent, span;
+    int pts;
+    if(!parseCentSpanPts(&cent, &span, &pts)) return;
+    if(lastSweep.kind() != Sweep::Ri || lastSweep.size() == 0)
+    {
+        ui->statusBar->showMessage(trUtf8("需要S11 RI扫描数据"));
+        return;
+    }
+
+    //nearest sweep point to the center
+    const QVector<qreal> &freq = lastSweep.freq();
+    int best = 0;
+    for(int i = 1; i < freq.size(); i++)
+        if(fabs(freq[i] - cent) < fabs(freq[best] - cent)) best = i;
+
+    QString match = NetworkChain::synthesize(freq[best], lastSweep.ri().at(best), network->reference());
+    if(match.isEmpty())
+    {
+        ui->statusBar->showMessage(trUtf8("无法匹配该负载"));
+        return;
+    }
+    QString chain = ui->ChainplainTextEdit->toPlainText();
+    if(!chain.isEmpty() && !chain.endsWith('\n')) chain += '\n';
+    ui->ChainplainTextEdit->setPlainText(chain + match);
+    if(compileNetwork())
+        ui->NetworkcheckBox->setChecked(true);
+}
+
+Sweep MainWindow::extendPort(const Sweep &sweep)
+//estimates run on the raw sweep, the boxes show what is applied
+{
+    {
+        ProfileScope scope(profiler, Profiler::Math);
+        if(ui->AutoDelaycheckBox->isChecked())
+            portext->setDelay(PortExtension::estimateDelay(sweep.freq(), sweep.ri()));
+        if(ui->AutoLosscheckBox->isChecked())
+            portext->setLoss(PortExtension::estimateLoss(sweep.freq(), sweep.ri()));
+    }
+    if(ui->AutoDelaycheckBox->isChecked())
+        ui->DelaydoubleSpinBox->setValue(portext->delay() * 1e12);
+    if(ui->AutoLosscheckBox->isChecked())
+        ui->LossdoubleSpinBox->setValue(portext->loss());
+    ProfileScope scope(profiler, Profiler::Math);
+    return portext->apply(sweep);
+}
+
+void MainWindow::on_DelaydoubleSpinBox_valueChanged(double delay)
+{
+    //the box shows ps
+    portext->setDelay(delay * 1e-12);
+}
+
+void MainWindow::on_LossdoubleSpinBox_valueChanged(double loss)
+{
+    portext->setLoss(loss);
+}
+
+void MainWindow::on_StreamcheckBox_toggled(bool checked)
+{
+    ui->StreamPortspinBox->setEnabled(!checked);
+    if(!checked)
+    {
+        server->close();
+        ui->StreamStatuslabel->setText("");
+        return;
+    }
+    QString error;
+    if(!server->listen(ui->StreamPortspinBox->value(), &error))
+    {
+        ui->statusBar->showMessage(QString(trUtf8("无法启动数据服务: %1")).arg(error));
+        ui->StreamcheckBox->setChecked(false);
+        return;
+    }
+    updateStreamStatus();
+}
+
+void MainWindow::updateStreamStatus()
+{
+    if(!server->isListening()) return;
+    ui->StreamStatuslabel->setText(QString("127.0.0.1:%1, %2 clients, %3 dropped")
+                                   .arg(server->port()).arg(server->clientCount()).arg(server->dropped()));
+}
+
+void MainWindow::serveRequest()
+//remote sweep requests go out between the sweeps of the GUI, through the same commands
+{
+    if(!server->hasRequest() || receiveTimer->isActive() || sequencer->isRunning()) return;
+    StreamServer::Request request = server->takeRequest();
+    remoteInFlight = true;
+    guiSweepType = lastSweepType;
+    guiCent = lastCent;
+    guiSpan = lastSpan;
+    guiPts = lastPts;
+    guiMesmode = mesmode;
+
+    bool s21 = request.kind == Sweep::S21;
+    if((lastSweepType == NoSweep || s21 != (lastSweepType == S21Sweep)) && _pSocket->isWritable())
+        sendCommand(s21 ? "$S11,stop\n$S21,init\n" : "$S21,stop\n$S11,init\n");
+    if(s21)
+        mesmode = 2;
+    else if(mesmode == 2)
+        mesmode = 0;
+
+    switch(request.kind)
+    {
+    case Sweep::Vswr: VSWR(request.cent, request.span, request.pts); break;
+    case Sweep::Ri: RI(request.cent, request.span, request.pts); break;
+    default: S21(request.cent, request.span, request.pts); break;
+    }
+}
+
+void MainWindow::remoteFinished()
+//back to the sweep of the gui after a remote request, the instrument in its mode again
+{
+    bool s21 = lastSweepType == S21Sweep;
+    remoteInFlight = false;
+    lastSweepType = guiSweepType;
+    lastCent = guiCent;
+    lastSpan = guiSpan;
+    lastPts = guiPts;
+    mesmode = guiMesmode;
+    if(lastSweepType != NoSweep && s21 != (lastSweepType == S21Sweep) && _pSocket->isWritable())
+        sendCommand(s21 ? "$S21,stop\n$S11,init\n" : "$S11,stop\n$S21,init\n");
+
+    if(server->hasRequest() && !sequencer->isRunning())
+        QTimer::singleShot(0, this, SLOT(serveRequest()));
+    else if(ui->ContinuouscheckBox->isChecked() || tracker->isActive())
+        QTimer::singleShot(0, this, SLOT(nextSweep()));
+}
+
+void MainWindow::on_ShmcheckBox_toggled(bool checked)
+//ring geometry from the settings, see sweepring.h for the layout
+{
+    if(!checked)
+    {
+        ring->close();
+        return;
+    }
+    QString error;
+    QString name = cfg->value("shm/name", "/kc901gui_sweeps").toString();
+    if(!ring->open(name, cfg->value("shm/slots", 8).toInt(), cfg->value("shm/points", 100001).toInt(), &error))
+    {
+        ui->statusBar->showMessage(QString(trUtf8("无法创建共享内存 %1: %2")).arg(name).arg(error));
+        ui->ShmcheckBox->setChecked(false);
+    }
+}
+
+void MainWindow::sendCommand(const QByteArray &cmd)
+//every command to the instrument goes through here, so a capture sees it
+{
+    if(capture->isActive())
+        capture->record(WireCapture::Sent, cmd);
+    _pSocket->write(cmd);
+}
+
+void MainWindow::on_CapturecheckBox_toggled(bool checked)
+{
+    if(!checked)
+    {
+        if(capture->isActive())
+            ui->ReplayStatuslabel->setText(QString("%1 records captured").arg(capture->records()));
+        capture->stop();
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, trUtf8("保存通信记录"),
+                            cfg->value("capture/file").toString(),
+                            trUtf8("Wire capture (*.kcw);;All files (*)"));
+    QString error;
+    if(fileName.isEmpty() || !capture->start(fileName, &error))
+    {
+        if(!fileName.isEmpty())
+            ui->statusBar->showMessage(QString(trUtf8("无法写入 %1: %2")).arg(fileName).arg(error));
+        ui->CapturecheckBox->setChecked(false);
+        return;
+    }
+    cfg->setValue("capture/file", fileName);
+    ui->ReplayStatuslabel->setText(QString("capturing %1").arg(QFileInfo(fileName).fileName()));
+}
+
+void MainWindow::on_ReplaypushButton_clicked()
+{
+    if(replay->isRunning())
+    {
+        replay->stop();
+        ui->ReplaypushButton->setText("Replay capture");
+        ui->ReplayStatuslabel->setText("stopped");
+        return;
+    }
+    QString fileName = QFileDialog::getOpenFileName(this, trUtf8("打开通信记录"),
+                            cfg->value("capture/file").toString(),
+                            trUtf8("Wire capture (*.kcw);;All files (*)"));
+    if(fileName.isEmpty()) return;
+    QString error;
+    if(!replay->load(fileName, &error))
+    {
+        ui->statusBar->showMessage(QString(trUtf8("通信记录错误: %1")).arg(error));
+        return;
+    }
+
+    //the capture drives the receive path, stop the loops that send
+    ui->ContinuouscheckBox->setChecked(false);
+    ui->TrackcheckBox->setChecked(false);
+    on_SeqStoppushButton_clicked();
+    autoscaleAndZoomReset = true;
+    startReceive();
+    static const qreal speeds[] = { 1, 4, 16, 0 };
+    replay->start(speeds[ui->ReplaySpeedcomboBox->currentIndex()]);
+    ui->ReplaypushButton->setText("Stop replay");
+    ui->ReplayStatuslabel->setText(QString("replaying %1 records").arg(replay->chunks()));
+}
+
+void MainWindow::replayChunk(const QByteArray &chunk)
+{
+    int size = receivedata.size();
+    receivedata.append(chunk);
+    processReceived(size);
+}
+
+void MainWindow::replayFinished(int chunks, qint64 elapsedMs)
+{
+    ui->ReplaypushButton->setText("Replay capture");
+    ui->ReplayStatuslabel->setText(QString("replayed %1 chunks in %2 ms").arg(chunks).arg(elapsedMs));
+}
+
+void MainWindow::on_ArchiveRecordcheckBox_toggled(bool checked)
+{
+    if(!checked)
+    {
+        if(recorder->isWriting())
+        {
+            int sweeps = recorder->count();
+            qint64 raw = recorder->rawBytes();
+            recorder->close();
+            QFileInfo info(cfg->value("archive/file").toString());
+            ui->ArchiveStatuslabel->setText(QString("%1 sweeps recorded, %2:1")
+                                            .arg(sweeps).arg(qreal(raw) / qMax<qint64>(info.size(), 1), 0, 'f', 1));
+        }
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, trUtf8("保存扫描存档"),
+                            cfg->value("archive/file").toString(),
+                            trUtf8("Sweep archive (*.kca);;All files (*)"));
+    QString error;
+    if(fileName.isEmpty() || !recorder->create(fileName, &error))
+    {
+        if(!fileName.isEmpty())
+            ui->statusBar->showMessage(QString(trUtf8("无法写入 %1: %2")).arg(fileName).arg(error));
+        ui->ArchiveRecordcheckBox->setChecked(false);
+        return;
+    }
+    cfg->setValue("archive/file", fileName);
+    ui->ArchiveStatuslabel->setText(QString("recording %1").arg(QFileInfo(fileName).fileName()));
+}
+
+void MainWindow::on_ArchiveOpenpushButton_clicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, trUtf8("打开扫描存档"),
+                            cfg->value("archive/file").toString(),
+                            trUtf8("Sweep archive (*.kca);;All files (*)"));
+    if(fileName.isEmpty()) return;
+    if(recorder->isWriting() && QFileInfo(fileName) == QFileInfo(cfg->value("archive/file").toString()))
+        ui->ArchiveRecordcheckBox->setChecked(false);
+    archiveTimer->stop();
+    ui->ArchivePlaypushButton->setText("Play");
+    QString error;
+    if(!archive->open(fileName, &error) || archive->count() == 0)
+    {
+        ui->statusBar->showMessage(QString(trUtf8("存档错误: %1")).arg(error.isEmpty() ? QString("empty") : error));
+        return;
+    }
+    ui->ArchiveTimedateTimeEdit->setDateTimeRange(QDateTime::fromMSecsSinceEpoch(archive->firstTime()),
+                                                 QDateTime::fromMSecsSinceEpoch(archive->lastTime()));
+    ui->ArchivehorizontalSlider->setRange(0, archive->count() - 1);
+    autoscaleAndZoomReset = true;
+    if(ui->ArchivehorizontalSlider->value() == 0)
+        showArchived(0);
+    else
+        ui->ArchivehorizontalSlider->setValue(0);
+}
+
+void MainWindow::on_ArchivehorizontalSlider_valueChanged(int index)
+{
+    showArchived(index);
+}
+
+void MainWindow::on_ArchiveTimedateTimeEdit_editingFinished()
+//seek by time, through the block index
+{
+    if(archive->count() == 0) return;
+    int index = archive->find(ui->ArchiveTimedateTimeEdit->dateTime().toMSecsSinceEpoch());
+    ui->ArchivehorizontalSlider->setValue(qMin(index, archive->count() - 1));
+}
+
+void MainWindow::on_ArchivePlaypushButton_clicked()
+{
+    if(archiveTimer->isActive())
+    {
+        archiveTimer->stop();
+        ui->ArchivePlaypushButton->setText("Play");
+        return;
+    }
+    if(archive->count() == 0) return;
+    if(ui->ArchivehorizontalSlider->value() >= archive->count() - 1)
+        ui->ArchivehorizontalSlider->setValue(0);
+    //sweeps of a block decode once, playback is paced by the display
+    archiveTimer->start(cfg->value("archive/interval", 40).toInt());
+    ui->ArchivePlaypushButton->setText("Pause");
+}
+
+void MainWindow::archiveStep()
+{
+    int next = ui->ArchivehorizontalSlider->value() + 1;
+    if(next >= archive->count())
+    {
+        archiveTimer->stop();
+        ui->ArchivePlaypushButton->setText("Play");
+        return;
+    }
+    ui->ArchivehorizontalSlider->setValue(next);
+}
+
+void MainWindow::showArchived(int index)
+//archived sweeps take the display path of a live one, without the processing
+{
+    qint64 timestamp;
+    Sweep sweep = archive->read(index, &timestamp);
+    if(sweep.isNull()) return;
+    ui->ArchiveTimedateTimeEdit->blockSignals(true);
+    ui->ArchiveTimedateTimeEdit->setDateTime(QDateTime::fromMSecsSinceEpoch(timestamp));
+    ui->ArchiveTimedateTimeEdit->blockSignals(false);
+    ui->ArchiveStatuslabel->setText(QString("%1 / %2").arg(index + 1).arg(archive->count()));
+    lastSweep = sweep;
+    lastData = sweep;
+
+    switch(sweep.kind())
+    {
+    case Sweep::Vswr:
+        showImpedanceView(false);
+        displayS11VSWR(sweep, phaseproc->smooth(sweep.value()));
+        break;
+    case Sweep::S21:
+        showImpedanceView(false);
+        displayS21(sweep, phaseproc->smooth(sweep.value()));
+        break;
+    default:
+        displayS11RI(sweep);
+        showImpedanceView(mesmode == 5);
+        if(mesmode == 5)
+            displayImpedance(sweep);
+        else if(mesmode == 2)
+            displayS21(sweep, s11Values(sweep));
+        else
+            displayS11VSWR(sweep, s11Values(sweep));
+        break;
+    }
+}
+
+bool MainWindow::compileKpis()
+{
+    QString error;
+    if(!kpis->parse(ui->KpiplainTextEdit->toPlainText(), &error))
+    {
+        ui->TrendStatuslabel->setText(error);
+        return false;
+    }
+    int index = ui->TrendKpicomboBox->currentIndex();
+    ui->TrendKpicomboBox->blockSignals(true);
+    ui->TrendKpicomboBox->clear();
+    ui->TrendKpicomboBox->addItems(kpis->names());
+    ui->TrendKpicomboBox->setCurrentIndex(qBound(0, index, kpis->size() - 1));
+    ui->TrendKpicomboBox->blockSignals(false);
+    ui->TrendStatuslabel->setText(QString("%1 KPIs").arg(kpis->size()));
+    //the statistics are per kpi, a new list starts them over
+    if(spc->names() != kpis->names())
+        spc->setKpis(kpis->names());
+    return !kpis->isEmpty();
+}
+
+void MainWindow::on_KpiApplypushButton_clicked()
+//a store is tied to its kpi list, a new list needs another directory
+{
+    bool recording = trend->isOpen();
+    if(!compileKpis() || (recording && trend->names() != kpis->names()))
+    {
+        if(recording)
+            ui->TrendcheckBox->setChecked(false);
+        return;
+    }
+    refreshTrend();
+}
+
+void MainWindow::on_TrendcheckBox_toggled(bool checked)
+{
+    if(!checked)
+    {
+        trendTimer->stop();
+        trend->close();
+        return;
+    }
+    QString dir = QFileDialog::getExistingDirectory(this, trUtf8("趋势数据目录"),
+                            cfg->value("trend/dir").toString());
+    QString error;
+    if(dir.isEmpty() || kpis->isEmpty() || !trend->open(dir, kpis->names(), &error))
+    {
+        if(!dir.isEmpty())
+            ui->statusBar->showMessage(QString(trUtf8("无法打开趋势数据 %1: %2")).arg(dir)
+                                       .arg(kpis->isEmpty() ? QString("no KPIs") : error));
+        ui->TrendcheckBox->setChecked(false);
+        return;
+    }
+    cfg->setValue("trend/dir", dir);
+    trendTimer->start(10000);
+    refreshTrend();
+}
+
+void MainWindow::on_TrendKpicomboBox_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    refreshTrend();
+}
+
+void MainWindow::on_TrendRangecomboBox_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    refreshTrend();
+}
+
+void MainWindow::refreshTrend()
+//about one bucket per pixel, the store picks the rollup level
+{
+    if(!trend->isOpen() || !ui->Trenddock->isVisible()) return;
+    static const qint64 ranges[] = { 3600000LL, 86400000LL, 7*86400000LL, 30*86400000LL, 365*86400000LL };
+    qint64 to = QDateTime::currentMSecsSinceEpoch();
+    qint64 from = to - ranges[qBound(0, ui->TrendRangecomboBox->currentIndex(), 4)];
+    int kpi = ui->TrendKpicomboBox->currentIndex();
+
+    TrendStore::Level level;
+    QVector<TrendStore::Point> points = trend->query(kpi, from, to, qMax(ui->trendplot->width(), 100), &level);
+    QVector<QPointF> mean;
+    QVector<QwtIntervalSample> band;
+    mean.reserve(points.size());
+    band.reserve(points.size());
+    qint64 half = TrendStore::width(level) / 2;
+    for(int i = 0; i < points.size(); i++)
+    {
+        const TrendStore::Point &p = points[i];
+        if(qIsNaN(p.mean)) continue;
+        qreal x = p.time + half;
+        mean.append(QPointF(x, p.mean));
+        band.append(QwtIntervalSample(x, p.min, p.max));
+    }
+    trendcurve->setSamples(mean);
+    trendband->setSamples(band);
+    ui->trendplot->setAxisScale(QwtPlot::xBottom, from, to);
+    ui->trendplot->setAxisTitle(QwtPlot::yLeft, trend->names().value(kpi));
+    ui->trendplot->replot();
+
+    static const char *levels[] = { "raw", "minute", "hour", "day" };
+    ui->TrendStatuslabel->setText(QString("%1 %2 points").arg(points.size()).arg(levels[level]));
+}
+
+void MainWindow::runFit(const Sweep &sweep)
+//model of the sweep, drawn in the unit of the trace
+{
+    if(sweep.kind() != Sweep::Ri && sweep.kind() != Sweep::S21) return;
+    ProfileScope scope(profiler, Profiler::Math);
+    fitter->setModel(ModelFitter::Model(ui->FitModelcomboBox->currentIndex()), ui->FitPolesspinBox->value());
+    fitter->setReference(zcalc->reference());
+    const ModelFitter::Result &result = fitter->fit(sweep);
+    ui->FitResultlabel->setText(fitter->summary());
+    fitcurve->setVisible(result.valid);
+    if(result.valid)
+    {
+        if(sweep.kind() == Sweep::S21)
+            setSweepData(fitcurve, sweep, fitter->modelDb());
+        else
+            setSweepData(fitcurve, sweep, s11Values(sweep.freq(), fitter->modelRi()));
+    }
+    scheduleReplot();
+}
+
+void MainWindow::on_FitModelcomboBox_currentIndexChanged(int index)
+{
+    ui->FitPolesspinBox->setEnabled(index == ModelFitter::Rational);
+    fitcurve->setVisible(false);
+    ui->FitResultlabel->clear();
+    ui->plot->replot();
+}
+
+void MainWindow::on_FitpushButton_clicked()
+{
+    if(lastSweep.size() == 0)
+    {
+        ui->statusBar->showMessage(trUtf8("没有可拟合的扫描数据"));
+        return;
+    }
+    runFit(lastSweep);
+    if(!fitter->result().valid)
+        ui->statusBar->showMessage(QString(trUtf8("拟合失败:%1")).arg(fitter->result().error));
+}
+
+void MainWindow::collectStats(const Sweep &sweep, bool unit, const QVector<qreal> *figures)
+//one unit into the production statistics, with the verdict of its limit test
+{
+    int verdict = limitVerdict;
+    limitVerdict = -1;
+    if(!unit || !ui->SpccheckBox->isChecked()) return;
+    ProfileScope scope(profiler, Profiler::Math);
+    //the kpis are s11 figures, taken from the trend when it extracted them
+    if(sweep.kind() == Sweep::S21)
+        spc->add(sweep, QVector<qreal>(), verdict);
+    else
+        spc->add(sweep, figures ? *figures : kpis->extract(sweep), verdict);
+}
+
+void MainWindow::on_SpccheckBox_toggled(bool checked)
+{
+    if(checked)
+        spcTimer->start(1000);
+    else
+        spcTimer->stop();
+    refreshSpc();
+}
+
+void MainWindow::on_SpcEnvelopecheckBox_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+    refreshSpc();
+}
+
+void MainWindow::on_SpcResetpushButton_clicked()
+{
+    spc->reset();
+    refreshSpc();
+}
+
+void MainWindow::refreshSpc()
+//table and envelope, once a second: the quantiles merge the sketch buffers
+{
+    ui->SpcTextlabel->setText(spc->text());
+
+    //|s| in db maps monotonically to vswr, so do its quantiles
+    Sweep::Kind kind = spc->envelopeKind();
+    bool vswr = kind == Sweep::Vswr || (kind == Sweep::Ri && mesmode != 1);
+    bool shown = ui->SpcEnvelopecheckBox->isChecked() && spc->envelopeSweeps() > 0
+            && (kind != Sweep::Ri || mesmode <= 2);
+    spcband->setVisible(shown);
+    spcmedian->setVisible(shown);
+    if(shown)
+    {
+        const QVector<qreal> &freq = spc->envelopeFreq();
+        QVector<qreal> quantiles[3] = { spc->envelope(0.01), spc->envelope(0.5), spc->envelope(0.99) };
+        for(int q = 0; vswr && q < 3; q++)
+        {
+            for(int i = 0; i < quantiles[q].size(); i++)
+            {
+                qreal mag = pow(10, quantiles[q][i] / 20);
+                quantiles[q][i] = (1 + mag) / (1 - mag);
+            }
+        }
+        QVector<QwtIntervalSample> band(freq.size());
+        QVector<QPointF> median(freq.size());
+        for(int i = 0; i < freq.size(); i++)
+        {
+            band[i] = QwtIntervalSample(freq[i], quantiles[0][i], quantiles[2][i]);
+            median[i] = QPointF(freq[i], quantiles[1][i]);
+        }
+        spcband->setSamples(band);
+        spcmedian->setSamples(median);
+    }
+    scheduleReplot();
+}
+
+Sweep MainWindow::applyTraceMath(const Sweep &sweep)
+//the sweep is kept for the memory, the views get it combined with the memory
+{
+    lastData = sweep;
+    if(!tracemath->isActive()) return sweep;
+    Sweep out;
+    {
+        ProfileScope scope(profiler, Profiler::Math);
+        out = tracemath->apply(sweep);
+    }
+    lastSweep = out;
+    //-1 while the memory is of another kind than the sweeps
+    qreal coverage = sweep.kind() == tracemath->memory().kind() ? tracemath->coverage() : -1;
+    if(coverage != memoryCoverage || tracemath->rejected() != memoryRejected)
+    {
+        memoryCoverage = coverage;
+        memoryRejected = tracemath->rejected();
+        updateMemoryStatus();
+    }
+    return out;
+}
+
+void MainWindow::updateMemoryStatus()
+{
+    const Sweep &memory = tracemath->memory();
+    if(memory.isNull())
+    {
+        ui->MemoryStatuslabel->setText(trUtf8("No memory"));
+        return;
+    }
+    static const char *kinds[] = { "", "VSWR", "S11", "S21" };
+    const QVector<qreal> &freq = memory.freq();
+    QString text = QString("%1, %2 points, %3 - %4 MHz").arg(kinds[memory.kind()]).arg(memory.size())
+            .arg(freq.first() / 1e6).arg(freq.last() / 1e6);
+    if(memoryCoverage < 0)
+        text += QString("\nmath needs %1 sweeps").arg(kinds[memory.kind()]);
+    else if(memoryCoverage < 1)
+        text += QString("\ncovers %1 % of the sweep").arg(memoryCoverage * 100, 0, 'f', 1);
+    if(memoryRejected > 0)
+        text += QString("\n|G| ratio >= 1 at %1 points, not divided").arg(memoryRejected);
+    ui->MemoryStatuslabel->setText(text);
+}
+
+void MainWindow::on_MemoryStorepushButton_clicked()
+{
+    if(lastData.size() == 0)
+    {
+        ui->statusBar->showMessage(trUtf8("没有可存储的扫描数据"));
+        return;
+    }
+    tracemath->setMemory(lastData);
+    //grid of the stored sweep, the next sweep on another one updates it
+    memoryCoverage = 1;
+    memoryRejected = 0;
+    updateMemoryStatus();
+}
+
+void MainWindow::on_MemoryClearpushButton_clicked()
+{
+    tracemath->clearMemory();
+    updateMemoryStatus();
+}
+
+void MainWindow::on_TraceMathcomboBox_currentIndexChanged(int index)
+{
+    tracemath->setMode(TraceMath::Mode(index));
+    if(memoryRejected > 0)
+    {
+        memoryRejected = 0;
+        updateMemoryStatus();
+    }
+}
+
+bool MainWindow::compileBands()
+{
+    QString error;
+    if(!golden->parseBands(ui->GoldenBandsplainTextEdit->toPlainText(), &error))
+    {
+        ui->GoldenBandslabel->setText(error);
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::scoreGolden(const Sweep &sweep)
+//distance to the golden unit into the readout and the sparkline
+{
+    if(golden->golden().isNull()) return;
+    {
+        ProfileScope scope(profiler, Profiler::Math);
+        if(!golden->compare(sweep)) return;
+    }
+    goldenScored = true;
+    scheduleReadout();
+    qreal distance = golden->distance();
+    if(qIsNaN(distance)) return;
+    goldenHistory.append(QPointF(goldenSweeps++, distance));
+    if(goldenHistory.size() > GoldenHistory)
+        goldenHistory.remove(0);
+    goldencurve->setSamples(goldenHistory);
+}
+
+void MainWindow::on_GoldenStorepushButton_clicked()
+//the displayed sweep, with the memory math when it is on
+{
+    if(lastSweep.size() == 0)
+    {
+        ui->statusBar->showMessage(trUtf8("没有可存储的扫描数据"));
+        return;
+    }
+    golden->setGolden(lastSweep);
+    goldenHistory.clear();
+    goldenSweeps = 0;
+    goldencurve->setSamples(goldenHistory);
+    ui->GoldenScorelabel->setText("--");
+    ui->GoldenBandslabel->setText(QString("%1 points, %2 - %3 MHz").arg(lastSweep.size())
+                                  .arg(lastSweep.freq().first() / 1e6).arg(lastSweep.freq().last() / 1e6));
+}
+
+void MainWindow::on_GoldenApplypushButton_clicked()
+{
+    if(compileBands())
+        ui->GoldenBandslabel->setText(QString("%1 bands").arg(golden->bands().size()));
+}
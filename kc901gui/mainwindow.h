@@ -3,14 +3,41 @@
 
 #include <QMainWindow>
 #include <QTcpSocket>
+#include "sweep.h"
+#include "measurementsequencer.h"
 //#include <qwt_plot.h>
 
 class QTimer;
 class QSettings;
 class QwtPlotCurve;
+class FastPlotCurve;
 class QElapsedTimer;
 class QwtPlotZoomer;
 class KCScaleWidget;
+class TraceProcessor;
+class PhaseProcessor;
+class LimitMask;
+class PeakSearch;
+class ResonanceTracker;
+class QwtPlotMarker;
+class QwtPlotTextLabel;
+class QFile;
+class Profiler;
+class ImpedanceCalculator;
+class NetworkChain;
+class PortExtension;
+class StreamServer;
+class RingPublisher;
+class WireCapture;
+class WireReplay;
+class SweepArchive;
+class KpiExtractor;
+class TrendStore;
+class QwtPlotIntervalCurve;
+class ModelFitter;
+class ProductionStats;
+class TraceMath;
+class GoldenScore;
 
 namespace Ui {
 class MainWindow;
@@ -25,7 +52,7 @@ public:
     ~MainWindow();
     QTcpSocket * _pSocket;
     QString senddata;
-    QString receivedata;
+    QByteArray receivedata;
     QByteArray cmddata;
     int mesmode = 0;
 
@@ -47,6 +74,8 @@ private slots:
 
     void on_ClosepushButton_clicked();
     void readTcpData();
+    void replayChunk(const QByteArray &chunk);
+    void replayFinished(int chunks, qint64 elapsedMs);
 
     void on_ControlpushButton_clicked();
 
@@ -63,10 +92,10 @@ private slots:
     void startReceive();
     void receiveTimeout();
 
-    void displayS11VSWR(QVector<qreal> freq, QVector<qreal> vswr);
+    void displayS11VSWR(const Sweep &sweep, const QVector<qreal> &vswr);
     //void displayS11MA(QVector<qreal> freq, QVector<qreal> mag, QVector<qreal>phase);
-    void displayS11RI(QVector<qreal> freq, QVector<QPointF> ri);
-    void displayS21(QVector<qreal> freq, QVector<qreal> lose);
+    void displayS11RI(const Sweep &sweep);
+    void displayS21(const Sweep &sweep, const QVector<qreal> &lose);
     //void displayS11MA(QVector<qreal> freq, QVector<qreal> ma);
 
     void refinePlot();
@@ -77,18 +106,206 @@ private slots:
     void on_RLMes_clicked();
     void on_S21initpushButton_clicked();
 
+    void displayProcessed(const Sweep &sweep, const QVector<qreal> &values);
+    void resetProcessing();
+    void on_TraceModecomboBox_currentIndexChanged(int index);
+    void on_AvgCountspinBox_valueChanged(int count);
+    void on_TraceResetpushButton_clicked();
+    void on_PhaseMes_clicked();
+    void on_GDMes_clicked();
+    void on_AperturespinBox_valueChanged(int points);
+    void on_SmoothspinBox_valueChanged(int points);
+    void on_LimitLoadpushButton_clicked();
+    void on_LimitClearpushButton_clicked();
+    void on_LimitcheckBox_toggled(bool checked);
+    void on_LimitLogcheckBox_toggled(bool checked);
+    void on_PeakcheckBox_toggled(bool checked);
+    void on_PeakModecomboBox_currentIndexChanged(int index);
+    void on_NotchCountspinBox_valueChanged(int count);
+    void on_TrackcheckBox_toggled(bool checked);
+    void nextSweep();
+    void on_FastcheckBox_toggled(bool fast);
+    void scheduleReplot();
+    void replotNow();
+    void scheduleReadout();
+    void readoutNow();
+    void on_WaterfallcheckBox_toggled(bool checked);
+    void on_WfMindoubleSpinBox_valueChanged(double value);
+    void on_WfMaxdoubleSpinBox_valueChanged(double value);
+    void on_WaterfallClearpushButton_clicked();
+    void on_SeqLoadpushButton_clicked();
+    void on_SeqRunpushButton_clicked();
+    void on_SeqStoppushButton_clicked();
+    void on_SeqReordercheckBox_toggled(bool checked);
+    void on_Profiledock_visibilityChanged(bool visible);
+    void on_ProfileResetpushButton_clicked();
+    void on_ProfileExportpushButton_clicked();
+    void on_ZMes_clicked();
+    void on_ZLeftcomboBox_currentIndexChanged(int index);
+    void on_ZRightcomboBox_currentIndexChanged(int index);
+    void on_NetworkCompilepushButton_clicked();
+    void on_NetworkMatchpushButton_clicked();
+    void on_DelaydoubleSpinBox_valueChanged(double delay);
+    void on_LossdoubleSpinBox_valueChanged(double loss);
+    void on_StreamcheckBox_toggled(bool checked);
+    void on_ShmcheckBox_toggled(bool checked);
+    void on_CapturecheckBox_toggled(bool checked);
+    void on_ReplaypushButton_clicked();
+    void on_ArchiveRecordcheckBox_toggled(bool checked);
+    void on_ArchiveOpenpushButton_clicked();
+    void on_ArchivehorizontalSlider_valueChanged(int index);
+    void on_ArchiveTimedateTimeEdit_editingFinished();
+    void on_ArchivePlaypushButton_clicked();
+    void archiveStep();
+    void on_KpiApplypushButton_clicked();
+    void on_TrendcheckBox_toggled(bool checked);
+    void on_TrendKpicomboBox_currentIndexChanged(int index);
+    void on_TrendRangecomboBox_currentIndexChanged(int index);
+    void refreshTrend();
+    void on_FitModelcomboBox_currentIndexChanged(int index);
+    void on_FitpushButton_clicked();
+    void on_SpccheckBox_toggled(bool checked);
+    void on_SpcEnvelopecheckBox_toggled(bool checked);
+    void on_SpcResetpushButton_clicked();
+    void refreshSpc();
+    void on_MemoryStorepushButton_clicked();
+    void on_MemoryClearpushButton_clicked();
+    void on_TraceMathcomboBox_currentIndexChanged(int index);
+    void on_GoldenStorepushButton_clicked();
+    void on_GoldenApplypushButton_clicked();
+    void serveRequest();
+    void updateStreamStatus();
+
 private:
     Ui::MainWindow *ui;
     QTimer *receiveTimer;
+    // consecutive timeouts of the sweep loops
+    int receiveTimeouts;
     QElapsedTimer *receiveElapsed;
     QSettings *cfg;
-    QwtPlotCurve *s11curve, *s21curve;
+    FastPlotCurve *s11curve, *s21curve, *proccurve;
+    QTimer *replotTimer;
+    QElapsedTimer *replotElapsed;
+    int replotInterval;
+    QTimer *readoutTimer;
+    int readoutInterval;
+    // last sweep for the readout, reply 0 once it is shown
+    int readoutReply, readoutPoints;
+    qint64 readoutMs;
+    // sweep commands are formatted into this buffer
+    QByteArray sweepcmd;
+    // s11 trace converted from a processed or model trace
+    QVector<qreal> s11buffer;
     QwtPlotZoomer *zoomer;
     bool autoscaleAndZoomReset;
     KCScaleWidget *bottomScaleWidget;
     bool autoRefineEnable;
+    // auto centre span in bandwidths of the resonance
+    qreal centerSpanFactor;
+    TraceProcessor *s11proc, *scalarproc;
+    PhaseProcessor *phaseproc;
+    LimitMask *limitmask;
+    QwtPlotCurve *upperlimitcurve, *lowerlimitcurve, *failcurve;
+    QwtPlotTextLabel *limitlabel;
+    QFile *limitlog;
+    int limitPass, limitFail;
+    // verdict of the last limit test, 1 pass, 0 fail, -1 untested
+    int limitVerdict;
+    // label on the plot: -1 hidden, 0 fail, 1 pass, 2 unit mismatch
+    int limitShown;
+    int limitTraceUnit;
+    qreal limitMargin, limitMarginFreq;
+    PeakSearch *peaksearch;
+    QwtPlotMarker *resmarker;
+    QwtPlotMarker *bwmarkers[2];
+    QVector<QwtPlotMarker *> notchmarkers;
+    QVector<QPointF> smithmarkers;
+    ResonanceTracker *tracker;
+
+    //last sweep command, repeated in continuous / tracking mode
+    enum SweepType { NoSweep, VswrSweep, RiSweep, S21Sweep };
+    SweepType lastSweepType;
+    qreal lastCent, lastSpan;
+    int lastPts;
+    MeasurementSequencer *sequencer;
+    QElapsedTimer *sequenceElapsed;
+    Profiler *profiler;
+    ImpedanceCalculator *zcalc, *zcalcproc;
+    NetworkChain *network;
+    PortExtension *portext;
+    StreamServer *server;
+    // a remote request is on the instrument, the sweep of the gui waits in these
+    bool remoteInFlight;
+    SweepType guiSweepType;
+    qreal guiCent, guiSpan;
+    int guiPts, guiMesmode;
+    RingPublisher *ring;
+    WireCapture *capture;
+    WireReplay *replay;
+    SweepArchive *recorder, *archive;
+    QTimer *archiveTimer;
+    KpiExtractor *kpis;
+    TrendStore *trend;
+    QTimer *trendTimer;
+    QwtPlotCurve *trendcurve;
+    QwtPlotIntervalCurve *trendband;
+    ModelFitter *fitter;
+    FastPlotCurve *fitcurve;
+    ProductionStats *spc;
+    QTimer *spcTimer;
+    QwtPlotIntervalCurve *spcband;
+    QwtPlotCurve *spcmedian;
+    TraceMath *tracemath;
+    // memory coverage of the grid shown in the status
+    qreal memoryCoverage;
+    // points the vswr ratio could not combine in the last sweep
+    int memoryRejected;
+    GoldenScore *golden;
+    QwtPlotCurve *goldencurve;
+    // last scores for the sparkline, x counts the scored sweeps
+    QVector<QPointF> goldenHistory;
+    int goldenSweeps;
+    // a score waits for the readout
+    bool goldenScored;
+    FastPlotCurve *zcurve, *rightcurve;
+    bool impedanceShown;
+
+    //latest parsed sweep, shared with the plot curves
+    Sweep lastSweep;
+    //latest sweep before the trace math, what goes to the memory
+    Sweep lastData;
 
     bool parseCentSpanPts(qreal *cent, qreal *span, int *pts);
+    const QVector<qreal> &s11Values(const Sweep &sweep);
+    const QVector<qreal> &s11Values(const QVector<qreal> &freq, const QVector<QPointF> &ri);
+    void loadLimitMask(const QString &fileName);
+    void checkLimits(const Sweep &sweep, const QVector<qreal> &values);
+    void showLimitLabel(int state);
+    void analyzeTrace(const QVector<qreal> &freq, const QVector<qreal> &db, const QVector<QPointF> *ri = 0);
+    void hidePeakMarkers();
+    void showPeakReadout();
+    void sendSweep(const char *format, qreal cent, qreal span, int pts);
+    void sweepFinished();
+    void remoteFinished();
+    void loadSequence(const QString &fileName);
+    void sequenceStep();
+    void sendStep(const MeasurementSequencer::Step &step, bool modeSwitch);
+    void sequenceFinished();
+    void displayImpedance(const Sweep &sweep);
+    void showImpedanceView(bool show);
+    int impedanceMask() const;
+    bool compileNetwork();
+    Sweep extendPort(const Sweep &sweep);
+    void sendCommand(const QByteArray &cmd);
+    void processReceived(int size);
+    void showArchived(int index);
+    bool compileKpis();
+    void runFit(const Sweep &sweep);
+    void collectStats(const Sweep &sweep, bool unit, const QVector<qreal> *figures = 0);
+    Sweep applyTraceMath(const Sweep &sweep);
+    void updateMemoryStatus();
+    bool compileBands();
+    void scoreGolden(const Sweep &sweep);
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,204 @@
+#include "measurementsequencer.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+
+MeasurementSequencer::MeasurementSequencer() :
+    m_port(NoPort),
+    m_reorder(true),
+    m_running(false),
+    m_next(0),
+    m_inFlight(-1),
+    m_completed(0)
+{
+}
+
+bool MeasurementSequencer::load(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        if(error) *error = file.errorString();
+        return false;
+    }
+
+    QVector<Step> plan;
+    QTextStream in(&file);
+    int lineNumber = 0;
+    int group = 0;
+    while(!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        lineNumber++;
+        if(line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList fields = line.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+        //separators only leave no fields and no port, the line is an error below
+        QString port = fields.value(0).toLower();
+        if(port == "fixed" && fields.size() == 1)
+        {
+            group++;
+            continue;
+        }
+
+        Step step;
+        step.line = lineNumber;
+        step.group = group;
+        step.mesmode = 0;
+        int first = 1;
+        bool ok = true;
+        if(port == "s21")
+        {
+            step.type = S21Step;
+            step.mesmode = 2;
+        }
+        else if(port == "s11" && fields.size() > 1)
+        {
+            QString mode = fields[1].toLower();
+            first = 2;
+            step.type = RiStep;
+            if(mode == "vswr") step.type = VswrStep;
+            else if(mode == "swr") step.mesmode = 0;
+            else if(mode == "rl") step.mesmode = 1;
+            else if(mode == "phase") step.mesmode = 3;
+            else if(mode == "gd") step.mesmode = 4;
+            else if(mode == "z") step.mesmode = 5;
+            else ok = false;
+        }
+        else
+            ok = false;
+
+        ok = ok && fields.size() >= first + 3;
+        if(ok) step.cent = fields[first].toDouble(&ok);
+        if(ok) step.span = fields[first+1].toDouble(&ok);
+        if(ok) step.pts = fields[first+2].toInt(&ok);
+        if(!ok || step.cent <= 0 || step.span <= 0 || step.pts <= 0)
+        {
+            if(error) *error = QString("line %1: %2").arg(lineNumber).arg(line);
+            return false;
+        }
+        step.label = QStringList(fields.mid(first + 3)).join(" ");
+        plan.append(step);
+    }
+
+    if(plan.isEmpty())
+    {
+        if(error) *error = "no steps";
+        return false;
+    }
+    stop();
+    steps = plan;
+    m_fileName = fileName;
+    return true;
+}
+
+bool MeasurementSequencer::start(Port port)
+{
+    stop();
+    schedule.clear();
+    if(steps.isEmpty()) return false;
+    m_port = port;
+    if(port == NoPort) port = MeasurementSequencer::port(steps.first().type);
+
+    //per group: the steps on the active port first, plan order otherwise
+    int begin = 0;
+    while(begin < steps.size())
+    {
+        int end = begin;
+        while(end < steps.size() && steps[end].group == steps[begin].group) end++;
+        for(int pass = 0; pass < 2; pass++)
+        {
+            for(int i = begin; i < end; i++)
+            {
+                bool active = MeasurementSequencer::port(steps[i].type) == port;
+                if(m_reorder && active != (pass == 0)) continue;
+                if(!m_reorder && pass == 1) continue;
+                Report r;
+                r.step = steps[i];
+                r.modeSwitch = false;
+                r.sent = r.done = -1;
+                r.points = 0;
+                schedule.append(r);
+            }
+        }
+        if(!schedule.isEmpty())
+            port = MeasurementSequencer::port(schedule.last().step.type);
+        begin = end;
+    }
+
+    m_running = true;
+    return true;
+}
+
+void MeasurementSequencer::stop()
+{
+    m_running = false;
+    m_next = 0;
+    m_inFlight = -1;
+    m_completed = 0;
+}
+
+const MeasurementSequencer::Step &MeasurementSequencer::next(qint64 now, bool *modeSwitch)
+{
+    Report &r = schedule[m_next];
+    Port previous = m_next == 0 ? m_port : port(schedule[m_next-1].step.type);
+    r.modeSwitch = port(r.step.type) != previous;
+    r.sent = now;
+    if(modeSwitch) *modeSwitch = r.modeSwitch;
+    m_inFlight = m_next++;
+    return r.step;
+}
+
+void MeasurementSequencer::done(qint64 now, int points)
+{
+    if(m_inFlight < 0) return;
+    schedule[m_inFlight].done = now;
+    schedule[m_inFlight].points = points;
+    m_completed++;
+    m_inFlight = -1;
+    if(m_next >= schedule.size()) m_running = false;
+}
+
+void MeasurementSequencer::fail(qint64 now)
+{
+    if(m_inFlight < 0) return;
+    schedule[m_inFlight].done = now;
+    schedule[m_inFlight].points = -1;
+    m_inFlight = -1;
+    m_running = false;
+}
+
+int MeasurementSequencer::modeSwitches() const
+{
+    int switches = 0;
+    for(int i = 0; i < schedule.size(); i++)
+        if(schedule[i].sent >= 0 && schedule[i].modeSwitch) switches++;
+    return switches;
+}
+
+bool MeasurementSequencer::writeReport(const QString &fileName, QString *error) const
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        if(error) *error = file.errorString();
+        return false;
+    }
+
+    static const char *types[] = { "vswr", "ri", "s21" };
+    QTextStream out(&file);
+    out << "order,line,label,type,mesmode,cent,span,pts,points,init,sent_ms,done_ms,duration_ms\n";
+    for(int i = 0; i < schedule.size(); i++)
+    {
+        const Report &r = schedule[i];
+        out << i + 1 << ',' << r.step.line << ',' << r.step.label << ','
+            << types[r.step.type] << ',' << r.step.mesmode << ','
+            << QString::number(r.step.cent, 'f', 0) << ','
+            << QString::number(r.step.span, 'f', 0) << ','
+            << r.step.pts << ',' << r.points << ',' << (r.modeSwitch ? 1 : 0) << ','
+            << r.sent << ',' << r.done << ','
+            << (r.done >= 0 ? r.done - r.sent : -1) << '\n';
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+#ifndef MEASUREMENTSEQUENCER_H
+#define MEASUREMENTSEQUENCER_H
+
+#include <QString>
+#include <QVector>
+
+/// Runs a measurement plan step by step
+/**
+A plan is a text file, one step per line:
+
+    # comment
+    s11 vswr|swr|rl|phase|gd|z cent span pts [label]
+    s21 cent span pts [label]
+    fixed
+
+vswr is the native VSWR sweep, the other S11 modes are RI sweeps shown
+as VSWR, return loss, unwrapped phase or group delay. Frequencies are
+in Hz. Switching between S11 and S21 needs an init of the instrument
+and costs far more than a sweep, so with reordering enabled the steps
+between two "fixed" lines are grouped by port, starting with the port
+that is already active. A "fixed" line is a barrier steps are never
+moved across.
+
+The sequencer only keeps the schedule and the timing, the owner sends
+the commands: next() hands out the step to send, done() closes the one
+in flight. Calling next() straight after the end of a reply keeps the
+instrument busy while the reply is still being displayed.
+*/
+class MeasurementSequencer
+{
+public:
+    enum Port {
+        NoPort = -1,
+        S11 = 0,
+        S21
+    };
+
+    enum StepType {
+        VswrStep = 0,
+        RiStep,
+        S21Step
+    };
+
+    struct Step {
+        int line;
+        StepType type;
+        /// display mode of RI steps, same values as MainWindow::mesmode
+        int mesmode;
+        qreal cent, span;
+        int pts;
+        QString label;
+        int group;
+    };
+
+    struct Report {
+        Step step;
+        /// an init had to be sent before this step
+        bool modeSwitch;
+        /// ms since start() when the command was sent / the reply ended
+        qint64 sent, done;
+        int points;
+    };
+
+    MeasurementSequencer();
+
+    bool load(const QString &fileName, QString *error = 0);
+    QString fileName() const { return m_fileName; }
+    int stepCount() const { return steps.size(); }
+
+    void setReorder(bool reorder) { m_reorder = reorder; }
+    bool reorder() const { return m_reorder; }
+
+    /// Build the schedule, port is the mode the instrument is in
+    /**
+    NoPort when unknown: the run then starts with an init on the port of
+    the first plan step.
+    */
+    bool start(Port port);
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    /// A reply is expected
+    bool inFlight() const { return m_inFlight >= 0; }
+    /// Step of the reply that is expected
+    const Step &current() const { return schedule[m_inFlight].step; }
+    const Report &currentReport() const { return schedule[m_inFlight]; }
+
+    /// Steps left to send
+    bool hasNext() const { return m_running && m_next < schedule.size(); }
+    /// Take the next step, *modeSwitch is set when it needs an init first
+    const Step &next(qint64 now, bool *modeSwitch);
+    /// Close the step in flight, finishes the run after the last one
+    void done(qint64 now, int points);
+    /// The step in flight got no reply, it is reported with -1 points and the run ends
+    void fail(qint64 now);
+
+    int completed() const { return m_completed; }
+    int scheduled() const { return schedule.size(); }
+    int modeSwitches() const;
+    const QVector<Report> &report() const { return schedule; }
+    bool writeReport(const QString &fileName, QString *error = 0) const;
+
+    static Port port(StepType type) { return type == S21Step ? S21 : S11; }
+
+private:
+    QVector<Step> steps;
+    QVector<Report> schedule;
+    QString m_fileName;
+    Port m_port;
+    bool m_reorder;
+    bool m_running;
+    int m_next;
+    int m_inFlight;
+    int m_completed;
+};
+
+#endif // MEASUREMENTSEQUENCER_H
@@ -0,0 +1,808 @@
+#include "modelfitter.h"
+#include <QtConcurrentMap>
+#include <QThread>
+#include <complex>
+#include <math.h>
+#include <qnumeric.h>
+
+typedef std::complex<qreal> Complex;
+
+// points per chunk of the normal equations, shorter sweeps stay on the calling thread
+static const int ChunkPoints = 2048;
+// forward difference step on the log of an element value
+static const qreal Step = 1e-6;
+
+static Complex toComplex(const QPointF &p)
+{
+    return Complex(p.x(), p.y());
+}
+
+static bool solve(QVector<qreal> a, QVector<qreal> b, int n, QVector<qreal> *x)
+//n x n system, Jacobi scaled, gaussian elimination with partial pivoting
+{
+    QVector<qreal> scale(n);
+    for(int i = 0; i < n; i++)
+        scale[i] = a[i*n + i] > 0 ? 1 / sqrt(a[i*n + i]) : 1;
+    for(int i = 0; i < n; i++)
+    {
+        for(int j = 0; j < n; j++)
+            a[i*n + j] *= scale[i] * scale[j];
+        b[i] *= scale[i];
+    }
+    for(int col = 0; col < n; col++)
+    {
+        int pivot = col;
+        for(int r = col + 1; r < n; r++)
+            if(fabs(a[r*n + col]) > fabs(a[pivot*n + col])) pivot = r;
+        if(!(fabs(a[pivot*n + col]) > 1e-300)) return false;
+        if(pivot != col)
+        {
+            for(int j = 0; j < n; j++)
+                qSwap(a[col*n + j], a[pivot*n + j]);
+            qSwap(b[col], b[pivot]);
+        }
+        for(int r = col + 1; r < n; r++)
+        {
+            qreal m = a[r*n + col] / a[col*n + col];
+            if(m == 0) continue;
+            for(int j = col; j < n; j++)
+                a[r*n + j] -= m * a[col*n + j];
+            b[r] -= m * b[col];
+        }
+    }
+    x->resize(n);
+    for(int i = n - 1; i >= 0; i--)
+    {
+        qreal sum = b[i];
+        for(int j = i + 1; j < n; j++)
+            sum -= a[i*n + j] * (*x)[j];
+        (*x)[i] = sum / a[i*n + i];
+    }
+    for(int i = 0; i < n; i++)
+        (*x)[i] *= scale[i];
+    return true;
+}
+
+static void rotateRow(qreal *r, qreal *z, int n, qreal *a, qreal b, qreal *sse)
+//givens update of the upper triangular r and q'b with one more row a, b
+{
+    for(int j = 0; j < n; j++)
+    {
+        if(a[j] == 0) continue;
+        qreal *row = r + j*n;
+        qreal h = hypot(row[j], a[j]);
+        qreal c = row[j] / h, s = a[j] / h;
+        row[j] = h;
+        for(int k = j + 1; k < n; k++)
+        {
+            qreal t = row[k];
+            row[k] = c*t + s*a[k];
+            a[k] = c*a[k] - s*t;
+        }
+        qreal t = z[j];
+        z[j] = c*t + s*b;
+        b = c*b - s*t;
+    }
+    *sse += b * b;
+}
+
+static bool backSubstitute(const QVector<qreal> &r, const QVector<qreal> &z, int n, QVector<qreal> *x)
+{
+    qreal largest = 0;
+    for(int j = 0; j < n; j++)
+        largest = qMax(largest, fabs(r[j*n + j]));
+    x->resize(n);
+    for(int i = n - 1; i >= 0; i--)
+    {
+        if(!(fabs(r[i*n + i]) > 1e-13 * largest)) return false;
+        qreal sum = z[i];
+        for(int j = i + 1; j < n; j++)
+            sum -= r[i*n + j] * (*x)[j];
+        (*x)[i] = sum / r[i*n + i];
+    }
+    return true;
+}
+
+static Complex circuitZ(ModelFitter::Model model, const qreal *p, qreal w)
+//impedance from the logarithms of the element values
+{
+    qreal r = exp(p[0]), l = exp(p[1]), c = exp(p[2]);
+    switch(model)
+    {
+    case ModelFitter::SeriesRlc:
+        return Complex(r, w*l - 1/(w*c));
+    case ModelFitter::ParallelRlc:
+        return 1.0 / Complex(1/r, w*c - 1/(w*l));
+    default:
+        //butterworth-van dyke: motional rlc parallel to c0
+        return 1.0 / (1.0 / Complex(r, w*l - 1/(w*c)) + Complex(0, w*exp(p[3])));
+    }
+}
+
+static QVector<Complex> polynomialRoots(const QVector<qreal> &p)
+//monic polynomial, highest power first, durand-kerner iteration
+{
+    int n = p.size() - 1;
+    qreal radius = 0;
+    for(int k = 1; k <= n; k++)
+        radius = qMax(radius, fabs(p[k]));
+    radius += 1;
+    QVector<Complex> z(n);
+    Complex seed(0.4, 0.9), power(1, 0);
+    for(int i = 0; i < n; i++)
+    {
+        z[i] = 0.5 * radius * power;
+        power *= seed;
+    }
+    for(int iteration = 0; iteration < 1000; iteration++)
+    {
+        qreal largest = 0;
+        for(int i = 0; i < n; i++)
+        {
+            Complex value(p[0], 0);
+            for(int k = 1; k <= n; k++)
+                value = value * z[i] + p[k];
+            Complex product(1, 0);
+            for(int j = 0; j < n; j++)
+                if(j != i) product *= z[i] - z[j];
+            Complex step = value / product;
+            z[i] -= step;
+            largest = qMax(largest, abs(step));
+        }
+        if(largest < 1e-14 * radius) break;
+    }
+    return z;
+}
+
+ModelFitter::ModelFitter() :
+    m_model(SeriesRlc),
+    m_poles(4),
+    m_z0(50.0),
+    scalar(false),
+    omegaScale(1),
+    warm(false),
+    warmPoints(0),
+    warmStart(0),
+    warmStop(0),
+    warmScalar(false)
+{
+    m_result.valid = false;
+    m_result.rms = 0;
+    m_result.iterations = 0;
+}
+
+void ModelFitter::setModel(Model model, int poles)
+{
+    poles = qBound(1, poles, 16);
+    if(model != m_model || (model == Rational && poles != m_poles))
+        warm = false;
+    m_model = model;
+    m_poles = poles;
+}
+
+const ModelFitter::Result &ModelFitter::fit(const Sweep &sweep)
+{
+    m_result = Result();
+    m_result.valid = false;
+    m_result.rms = 0;
+    m_result.iterations = 0;
+    m_modelRi.clear();
+    m_modelDb.clear();
+
+    const QVector<qreal> &freq = sweep.freq();
+    int n = freq.size();
+    if((sweep.kind() != Sweep::Ri && sweep.kind() != Sweep::S21) || n < 8 || freq.first() <= 0)
+    {
+        m_result.error = "needs an RI or S21 sweep of 8 points or more";
+        warm = false;
+        return m_result;
+    }
+    scalar = sweep.kind() == Sweep::S21;
+    omega.resize(n);
+    for(int i = 0; i < n; i++)
+        omega[i] = 2 * M_PI * freq[i];
+    omegaScale = omega.last();
+    if(scalar)
+        db = sweep.value();
+    else
+        data = sweep.ri();
+
+    //the last solution is a start only on the same grid
+    warm = warm && warmPoints == n && warmStart == freq.first() && warmStop == freq.last() && warmScalar == scalar;
+    if(m_model == Rational)
+        fitRational();
+    else
+        fitCircuit();
+
+    warm = m_result.valid;
+    warmPoints = n;
+    warmStart = freq.first();
+    warmStop = freq.last();
+    warmScalar = scalar;
+    if(m_result.valid) evaluate();
+    return m_result;
+}
+
+void ModelFitter::accumulate(Chunk &chunk)
+{
+    chunk.fitter->accumulateRange(chunk);
+}
+
+int ModelFitter::basis(const Complex &s, Complex *phi) const
+//partial fractions of the poles at s, a conjugate pair as two real combinations
+{
+    int c = 0;
+    for(int k = 0; k < poles.size(); k++)
+    {
+        Complex pole(poles[k].x(), poles[k].y());
+        if(poles[k].y() == 0)
+            phi[c++] = 1.0 / (s - pole);
+        else
+        {
+            Complex u = 1.0 / (s - pole), v = 1.0 / (s - conj(pole));
+            phi[c++] = u + v;
+            phi[c++] = Complex(0, 1) * (u - v);
+        }
+    }
+    return c;
+}
+
+int ModelFitter::poleColumns() const
+{
+    int columns = 0;
+    for(int k = 0; k < poles.size(); k++)
+        columns += poles[k].y() == 0 ? 1 : 2;
+    return columns;
+}
+
+void ModelFitter::accumulateRange(Chunk &chunk) const
+//normal equation sums of the rows of points from..to
+{
+    int cols = chunk.columns;
+    chunk.ata.fill(0, cols * cols);
+    chunk.atb.fill(0, cols);
+    chunk.btb = 0;
+    QVector<qreal> rowBuffer(2 * qMax(cols, 1));
+    qreal *a[2] = { rowBuffer.data(), rowBuffer.data() + qMax(cols, 1) };
+    qreal b[2];
+    QVector<Complex> phi(poles.size() * 2 + 2);
+    QVector<qreal> shifted(trial);
+    int np = trial.size();
+
+    for(int i = chunk.from; i < chunk.to; i++)
+    {
+        int rows;
+        qreal w = omega[i];
+        if(chunk.pass == Normal || chunk.pass == Cost)
+        {
+            //residual of the model at trial, then forward differences per parameter
+            qreal r0[2] = { 0, 0 };
+            Complex z = circuitZ(m_model, trial.constData(), w);
+            if(scalar)
+            {
+                rows = 1;
+                r0[0] = 20 * log10(abs(2*m_z0 / (2*m_z0 + z))) - db[i];
+            }
+            else
+            {
+                rows = 2;
+                Complex g = (z - m_z0) / (z + m_z0) - toComplex(data[i]);
+                r0[0] = g.real();
+                r0[1] = g.imag();
+            }
+            b[0] = -r0[0];
+            b[1] = -r0[1];
+            for(int k = 0; chunk.pass == Normal && k < np; k++)
+            {
+                shifted[k] = trial[k] + Step;
+                Complex zk = circuitZ(m_model, shifted.constData(), w);
+                shifted[k] = trial[k];
+                if(scalar)
+                    a[0][k] = (20 * log10(abs(2*m_z0 / (2*m_z0 + zk))) - db[i] - r0[0]) / Step;
+                else
+                {
+                    Complex gk = (zk - m_z0) / (zk + m_z0) - toComplex(data[i]);
+                    a[0][k] = (gk.real() - r0[0]) / Step;
+                    a[1][k] = (gk.imag() - r0[1]) / Step;
+                }
+            }
+        }
+        else
+        {
+            //vector fitting: pole basis and constant, for sigma the same times -f
+            //relaxed sigma (its constant is an unknown too), the rows are homogeneous
+            Complex f = toComplex(data[i]);
+            int c = basis(Complex(0, w / omegaScale), phi.data());
+            phi[c] = 1;
+            rows = 2;
+            for(int k = 0; k <= c; k++)
+            {
+                a[0][k] = phi[k].real();
+                a[1][k] = phi[k].imag();
+            }
+            for(int k = 0; chunk.pass == Sigma && k <= c; k++)
+            {
+                Complex fphi = -f * phi[k];
+                a[0][c + 1 + k] = fphi.real();
+                a[1][c + 1 + k] = fphi.imag();
+            }
+            b[0] = chunk.pass == Sigma ? 0 : f.real();
+            b[1] = chunk.pass == Sigma ? 0 : f.imag();
+        }
+
+        if(chunk.pass == Sigma || chunk.pass == Residues)
+        {
+            //vector fitting is badly conditioned, qr instead of the normal equations
+            for(int r = 0; r < rows; r++)
+                rotateRow(chunk.ata.data(), chunk.atb.data(), cols, a[r], b[r], &chunk.btb);
+            continue;
+        }
+        for(int r = 0; r < rows; r++)
+        {
+            chunk.btb += b[r] * b[r];
+            for(int j = 0; j < cols; j++)
+            {
+                chunk.atb[j] += a[r][j] * b[r];
+                qreal *row = chunk.ata.data() + j*cols;
+                for(int k = 0; k <= j; k++)
+                    row[k] += a[r][j] * a[r][k];
+            }
+        }
+    }
+    if(chunk.pass == Sigma || chunk.pass == Residues) return;
+    for(int j = 0; j < cols; j++)
+        for(int k = j + 1; k < cols; k++)
+            chunk.ata[j*cols + k] = chunk.ata[k*cols + j];
+}
+
+void ModelFitter::run(Pass pass, int columns, QVector<qreal> *ata, QVector<qreal> *atb, qreal *btb)
+{
+    int n = omega.size();
+    int count = qBound(1, n / ChunkPoints, 4 * QThread::idealThreadCount());
+    QVector<Chunk> chunks(count);
+    for(int c = 0; c < count; c++)
+    {
+        chunks[c].fitter = this;
+        chunks[c].pass = pass;
+        chunks[c].from = qint64(n) * c / count;
+        chunks[c].to = qint64(n) * (c + 1) / count;
+        chunks[c].columns = columns;
+    }
+    if(count == 1)
+        accumulate(chunks[0]);
+    else
+        QtConcurrent::blockingMap(chunks, &ModelFitter::accumulate);
+
+    //fixed order, the sums do not depend on which thread finished first
+    if(ata) ata->fill(0, columns * columns);
+    if(atb) atb->fill(0, columns);
+    *btb = 0;
+    if(pass == Sigma || pass == Residues)
+    {
+        //stack the triangular factors of the chunks and factor again
+        QVector<qreal> row(columns);
+        for(int c = 0; c < count; c++)
+        {
+            *btb += chunks[c].btb;
+            for(int j = 0; j < columns; j++)
+            {
+                for(int k = 0; k < columns; k++)
+                    row[k] = chunks[c].ata[j*columns + k];
+                rotateRow(ata->data(), atb->data(), columns, row.data(), chunks[c].atb[j], btb);
+            }
+        }
+        return;
+    }
+    for(int c = 0; c < count; c++)
+    {
+        for(int j = 0; ata && j < columns * columns; j++)
+            (*ata)[j] += chunks[c].ata[j];
+        for(int j = 0; atb && j < columns; j++)
+            (*atb)[j] += chunks[c].atb[j];
+        *btb += chunks[c].btb;
+    }
+}
+
+bool ModelFitter::initialGuess(QVector<qreal> *p, QString *error) const
+//element values from the resonances of the data
+{
+    int n = omega.size();
+    qreal r, l, c, c0 = 0;
+    if(!scalar)
+    {
+        QVector<Complex> z(n);
+        int lowest = 0, highest = 0;
+        for(int i = 0; i < n; i++)
+        {
+            Complex g = toComplex(data[i]);
+            z[i] = m_z0 * (1.0 + g) / (1.0 - g);
+            if(abs(z[i]) < abs(z[lowest])) lowest = i;
+            if(abs(z[i]) > abs(z[highest])) highest = i;
+        }
+        //reactance or susceptance slope over a few percent of the sweep
+        int reach = qMax(1, n / 50);
+        int i0 = m_model == ParallelRlc ? highest : lowest;
+        int lo = qMax(0, i0 - reach), hi = qMin(n - 1, i0 + reach);
+        qreal w0 = omega[i0];
+        if(m_model == ParallelRlc)
+        {
+            Complex y0 = 1.0 / z[i0];
+            qreal slope = ((1.0 / z[hi]).imag() - (1.0 / z[lo]).imag()) / (omega[hi] - omega[lo]);
+            r = 1 / qMax(y0.real(), 1e-9);
+            c = slope > 0 ? slope / 2 : fabs((1.0 / z[n-1]).imag()) / omega[n-1];
+            l = 1 / (w0 * w0 * c);
+        }
+        else
+        {
+            qreal slope = (z[hi].imag() - z[lo].imag()) / (omega[hi] - omega[lo]);
+            r = qMax(z[i0].real(), 1e-3);
+            l = slope > 0 ? slope / 2 : fabs(z[n-1].imag()) / omega[n-1];
+            c = 1 / (w0 * w0 * l);
+            if(m_model == Bvd)
+            {
+                //c0 from the susceptance at the far end, the motional arm from fp / fs
+                int e = i0 > n / 2 ? 0 : n - 1;
+                c0 = (1.0 / z[e]).imag() / omega[e];
+                if(!(c0 > 0)) c0 = 1e-12;
+                qreal ratio = omega[highest] / w0;
+                c = c0 * (ratio > 1 ? ratio * ratio - 1 : 1e-3);
+                l = 1 / (w0 * w0 * c);
+            }
+        }
+    }
+    else
+    {
+        if(m_model == ParallelRlc)
+        {
+            if(error) *error = "parallel RLC needs an RI sweep";
+            return false;
+        }
+        int peak = 0, notch = 0;
+        for(int i = 0; i < n; i++)
+        {
+            if(db[i] > db[peak]) peak = i;
+            if(db[i] < db[notch]) notch = i;
+        }
+        qreal w0 = omega[peak];
+        r = qMax(2 * m_z0 * (pow(10, -db[peak] / 20) - 1), 1e-3);
+        //loaded bandwidth of the series resonance with the 2 z0 of the fixture
+        int lo = peak, hi = peak;
+        while(lo > 0 && db[lo - 1] >= db[peak] - 3) lo--;
+        while(hi < n - 1 && db[hi + 1] >= db[peak] - 3) hi++;
+        qreal bw = omega[hi] - omega[lo];
+        if(!(bw > 0)) bw = (omega.last() - omega.first()) / 10;
+        l = (r + 2 * m_z0) / bw;
+        c = 1 / (w0 * w0 * l);
+        //a broad resonance leaves the sweep before -3 dB, fit X = L w - 1/(C w) to all points instead
+        qreal sww = 0, swd = 0, sdd = 0, sxw = 0, sxd = 0;
+        for(int i = 0; i < n; i++)
+        {
+            qreal ratio = 2 * m_z0 / pow(10, db[i] / 20);
+            qreal x = sqrt(qMax(ratio * ratio - (r + 2 * m_z0) * (r + 2 * m_z0), qreal(0)));
+            if(i < peak) x = -x;
+            qreal inv = -1 / omega[i];
+            sww += omega[i] * omega[i];
+            swd += omega[i] * inv;
+            sdd += inv * inv;
+            sxw += x * omega[i];
+            sxd += x * inv;
+        }
+        qreal det = sww * sdd - swd * swd;
+        qreal fitL = (sxw * sdd - sxd * swd) / det, fitD = (sww * sxd - swd * sxw) / det;
+        if(m_model != Bvd && fitL > 0 && fitD > 0)
+        {
+            l = fitL;
+            c = 1 / fitD;
+        }
+        if(m_model == Bvd)
+        {
+            int e = peak > n / 2 ? 0 : n - 1;
+            qreal ratio = 2 * m_z0 / pow(10, db[e] / 20);
+            qreal x0 = sqrt(ratio * ratio - 4 * m_z0 * m_z0);
+            c0 = x0 > 0 ? 1 / (omega[e] * x0) : 1e-12;
+            qreal fp = omega[notch] / w0;
+            c = c0 * (fp > 1 ? fp * fp - 1 : 1e-3);
+            l = 1 / (w0 * w0 * c);
+        }
+    }
+
+    p->resize(m_model == Bvd ? 4 : 3);
+    (*p)[0] = log(r);
+    (*p)[1] = log(l);
+    (*p)[2] = log(c);
+    if(m_model == Bvd) (*p)[3] = log(c0);
+    for(int k = 0; k < p->size(); k++)
+    {
+        if(!qIsFinite((*p)[k]))
+        {
+            if(error) *error = "no resonance in the sweep";
+            return false;
+        }
+    }
+    return true;
+}
+
+void ModelFitter::fitCircuit()
+{
+    int np = m_model == Bvd ? 4 : 3;
+    if(!warm || params.size() != np)
+    {
+        if(!initialGuess(&params, &m_result.error)) return;
+    }
+    trial = params;
+
+    QVector<qreal> ata, atb, delta;
+    qreal cost, trialCost;
+    run(Normal, np, &ata, &atb, &cost);
+    qreal lambda = warm ? 1e-4 : 1e-2;
+    int rows = omega.size() * (scalar ? 1 : 2);
+    int iteration;
+    for(iteration = 1; iteration <= 100; iteration++)
+    {
+        //marquardt damping of the diagonal
+        QVector<qreal> damped(ata);
+        for(int k = 0; k < np; k++)
+            damped[k*np + k] = ata[k*np + k] * (1 + lambda) + 1e-30;
+        bool solved = solve(damped, atb, np, &delta);
+        if(solved)
+        {
+            for(int k = 0; k < np; k++)
+                trial[k] = params[k] + delta[k];
+            run(Cost, 0, 0, 0, &trialCost);
+        }
+        qreal largest = 0;
+        for(int k = 0; solved && k < np; k++)
+            largest = qMax(largest, fabs(delta[k]));
+        if(solved && trialCost < cost)
+        {
+            qreal gain = cost - trialCost;
+            params = trial;
+            lambda = qMax(lambda / 10, 1e-12);
+            run(Normal, np, &ata, &atb, &cost);
+            //the values moved below the 5 digits shown, or the cost fell by less than
+            //1% of the residual variance, cost / rows: further steps only fit the noise
+            if(largest < 1e-6 || gain <= 1e-2 * cost / rows) break;
+        }
+        else
+        {
+            //a step below the digits shown that does not lower the cost: at the minimum
+            trial = params;
+            lambda *= 10;
+            if(lambda > 1e12 || (solved && largest < 1e-6)) break;
+        }
+    }
+
+    if(!qIsFinite(cost))
+    {
+        m_result.error = "did not converge";
+        return;
+    }
+    m_result.valid = true;
+    m_result.iterations = qMin(iteration, 100);
+    m_result.rms = sqrt(cost / (omega.size() * (scalar ? 1 : 2)));
+
+    qreal r = exp(params[0]), l = exp(params[1]), c = exp(params[2]);
+    qreal w0 = 1 / sqrt(l * c);
+    if(m_model == Bvd)
+    {
+        qreal c0 = exp(params[3]);
+        m_result.names << "Rm" << "Lm" << "Cm" << "C0" << "fs" << "fp" << "Q";
+        m_result.units << "ohm" << "H" << "F" << "F" << "Hz" << "Hz" << "";
+        m_result.values << r << l << c << c0 << w0 / (2*M_PI) << w0 / (2*M_PI) * sqrt(1 + c / c0) << w0 * l / r;
+    }
+    else
+    {
+        m_result.names << "R" << "L" << "C" << "f0" << "Q";
+        m_result.units << "ohm" << "H" << "F" << "Hz" << "";
+        m_result.values << r << l << c << w0 / (2*M_PI) << (m_model == SeriesRlc ? w0 * l / r : r / (w0 * l));
+    }
+}
+
+void ModelFitter::fitRational()
+{
+    int n = omega.size();
+    if(scalar || n < 2 * m_poles + 2)
+    {
+        m_result.error = scalar ? "the rational model needs an RI sweep" : "too few points for the poles";
+        return;
+    }
+    if(!warm || poles.isEmpty())
+    {
+        //complex pairs spread over the band, lightly damped, a real pole if odd
+        poles.clear();
+        qreal low = omega.first() / omegaScale;
+        int pairs = m_poles / 2;
+        for(int k = 0; k < pairs; k++)
+        {
+            qreal beta = low + (1 - low) * (k + 0.5) / pairs;
+            poles.append(QPointF(-beta / 100, beta));
+        }
+        if(m_poles % 2)
+            poles.append(QPointF(-(1 + low) / 2, 0));
+    }
+
+    QVector<qreal> ata, atb, x;
+    QVector<Complex> phi(2 * m_poles + 1);
+    qreal btb;
+    int iterations = warm ? 2 : 6;
+    int iteration;
+    for(iteration = 1; iteration <= iterations; iteration++)
+    {
+        int cols = poleColumns();
+        int unknowns = 2 * cols + 2;
+        run(Sigma, unknowns, &ata, &atb, &btb);
+        //relaxation row: the real part of sigma sums to the number of points
+        QVector<qreal> relax(unknowns, 0);
+        qreal energy = 0;
+        for(int i = 0; i < n; i++)
+        {
+            int c = basis(Complex(0, omega[i] / omegaScale), phi.data());
+            for(int k = 0; k < c; k++)
+                relax[cols + 1 + k] += phi[k].real();
+            energy += norm(toComplex(data[i]));
+        }
+        relax[unknowns - 1] = n;
+        qreal weight = sqrt(energy) / n;
+        for(int k = 0; k < unknowns; k++)
+            relax[k] *= weight;
+        rotateRow(ata.data(), atb.data(), unknowns, relax.data(), weight * n, &btb);
+        if(!backSubstitute(ata, atb, unknowns, &x)) break;
+        qreal constant = x[unknowns - 1];
+        if(fabs(constant) < 1e-8)
+            constant = constant < 0 ? -1e-8 : 1e-8;
+
+        //zeros of sigma are the new poles: numerator of 1 + sum r / (s - q), r scaled by the constant
+        QVector<Complex> q, r;
+        int c = cols + 1;
+        for(int k = 0; k < poles.size(); k++)
+        {
+            Complex pole(poles[k].x(), poles[k].y());
+            if(poles[k].y() == 0)
+            {
+                q.append(pole);
+                r.append(x[c++] / constant);
+            }
+            else
+            {
+                Complex residue(x[c] / constant, x[c + 1] / constant);
+                c += 2;
+                q << pole << conj(pole);
+                r << residue << conj(residue);
+            }
+        }
+        int degree = q.size();
+        QVector<Complex> d(1, Complex(1, 0));
+        for(int k = 0; k < degree; k++)
+        {
+            d.append(0);
+            for(int j = d.size() - 1; j > 0; j--)
+                d[j] -= q[k] * d[j - 1];
+        }
+        QVector<Complex> numerator(d);
+        for(int k = 0; k < degree; k++)
+        {
+            //d / (s - q[k]) by synthetic division, added one power down
+            Complex quotient = d[0];
+            numerator[1] += r[k] * quotient;
+            for(int j = 1; j < degree; j++)
+            {
+                quotient = d[j] + q[k] * quotient;
+                numerator[j + 1] += r[k] * quotient;
+            }
+        }
+        QVector<qreal> coefficients(degree + 1);
+        for(int j = 0; j <= degree; j++)
+            coefficients[j] = numerator[j].real();
+        QVector<Complex> zeros = polynomialRoots(coefficients);
+
+        //one entry per conjugate pair, stable, real poles with exactly zero imaginary part
+        QVector<QPointF> next;
+        int members = 0;
+        for(int k = 0; k < zeros.size(); k++)
+        {
+            qreal re = -fabs(zeros[k].real()), im = zeros[k].imag();
+            if(fabs(im) <= 1e-9 * qMax(abs(zeros[k]), 1e-6))
+            {
+                next.append(QPointF(re, 0));
+                members++;
+            }
+            else if(im > 0)
+            {
+                next.append(QPointF(re, im));
+                members += 2;
+            }
+        }
+        if(members != degree) break;
+        poles = next;
+    }
+
+    int cols = poleColumns();
+    run(Residues, cols + 1, &ata, &atb, &btb);
+    if(!backSubstitute(ata, atb, cols + 1, &residues))
+    {
+        m_result.error = "singular pole basis";
+        poles.clear();
+        return;
+    }
+    m_result.valid = true;
+    m_result.iterations = qMin(iteration, iterations);
+
+    int pair = 0, real = 0;
+    for(int k = 0; k < poles.size(); k++)
+    {
+        qreal re = poles[k].x() * omegaScale, im = poles[k].y() * omegaScale;
+        if(poles[k].y() == 0)
+        {
+            m_result.names << QString("fr%1").arg(++real);
+            m_result.units << "Hz";
+            m_result.values << fabs(re) / (2*M_PI);
+        }
+        else
+        {
+            pair++;
+            m_result.names << QString("f%1").arg(pair) << QString("Q%1").arg(pair);
+            m_result.units << "Hz" << "";
+            m_result.values << im / (2*M_PI) << sqrt(re*re + im*im) / (2 * fabs(re));
+        }
+    }
+}
+
+void ModelFitter::evaluate()
+//model curve on the sweep grid and its rms residual
+{
+    int n = omega.size();
+    qreal sum = 0;
+    QVector<Complex> phi(2 * poles.size() + 1);
+    if(scalar)
+        m_modelDb.resize(n);
+    else
+        m_modelRi.resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        qreal w = omega[i];
+        if(m_model == Rational)
+        {
+            int c = basis(Complex(0, w / omegaScale), phi.data());
+            Complex g(residues[c], 0);
+            for(int k = 0; k < c; k++)
+                g += residues[k] * phi[k];
+            m_modelRi[i] = QPointF(g.real(), g.imag());
+            sum += norm(g - toComplex(data[i]));
+            continue;
+        }
+        Complex z = circuitZ(m_model, params.constData(), w);
+        if(scalar)
+        {
+            m_modelDb[i] = 20 * log10(abs(2*m_z0 / (2*m_z0 + z)));
+            sum += (m_modelDb[i] - db[i]) * (m_modelDb[i] - db[i]);
+        }
+        else
+        {
+            Complex g = (z - m_z0) / (z + m_z0);
+            m_modelRi[i] = QPointF(g.real(), g.imag());
+        }
+    }
+    if(m_model == Rational)
+        m_result.rms = sqrt(sum / (2 * n));
+}
+
+static QString engineering(qreal value, const QString &unit)
+{
+    static const char prefixes[] = "fpnum kMGT";
+    if(unit.isEmpty() || value == 0 || !qIsFinite(value))
+        return QString::number(value, 'g', 5) + (unit.isEmpty() ? "" : " " + unit);
+    int exponent = qBound(-5, int(floor(log10(fabs(value)) / 3)), 4);
+    QString prefix = exponent == 0 ? QString() : QString(QChar(prefixes[exponent + 5]));
+    return QString("%1 %2%3").arg(value / pow(1000.0, exponent), 0, 'g', 5).arg(prefix).arg(unit);
+}
+
+QString ModelFitter::summary() const
+{
+    if(!m_result.valid) return m_result.error;
+    QString text;
+    for(int k = 0; k < m_result.values.size(); k++)
+        text += QString("%1 %2\n").arg(m_result.names[k], -3).arg(engineering(m_result.values[k], m_result.units[k]));
+    text += QString("rms %1%2, %3 iterations").arg(m_result.rms, 0, 'g', 3).arg(scalar ? " dB" : "")
+            .arg(m_result.iterations);
+    return text;
+}
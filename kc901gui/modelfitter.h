@@ -0,0 +1,131 @@
+#ifndef MODELFITTER_H
+#define MODELFITTER_H
+
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <complex>
+#include "sweep.h"
+
+/// Equivalent circuit and rational model fits to a sweep
+/**
+RI sweeps are fitted on the complex reflection of the model as a one
+port. S21 sweeps only carry |S21| in dB, there the model is a series
+element between the two ports, S21 = 2 Z0 / (2 Z0 + Z), the usual
+crystal and resonator test fixture.
+
+Circuit models are fitted with Levenberg-Marquardt on the logarithm of
+the element values, which keeps them positive and equally scaled. The
+first fit starts from the resonances found in the data, later fits of
+the same model on the same grid start from the last solution. For a
+drifting resonance that takes three steps for a series RLC and three to
+six for a crystal, fast enough for every sweep.
+
+The rational model is relaxed vector fitting (Gustavsen) of the
+reflection with the given number of poles, complex pairs or real, poles
+flipped into the left half plane on every iteration.
+
+Both passes over the frequency points run in chunks on the global
+thread pool, model and Jacobian evaluation included. Levenberg-Marquardt
+only needs the normal equations, the chunk sums are added up. Vector
+fitting is too badly conditioned for them, every chunk reduces its rows
+to a triangular factor with Givens rotations and the factors are merged
+the same way. Chunks are always combined in the same order so the
+result does not depend on timing.
+*/
+class ModelFitter
+{
+public:
+    enum Model {
+        SeriesRlc = 0,
+        ParallelRlc,
+        Bvd,
+        Rational
+    };
+
+    struct Result {
+        bool valid;
+        QString error;
+        /// fitted values in SI units, then derived ones
+        QStringList names;
+        QVector<qreal> values;
+        QStringList units;
+        /// rms of the residual, |S11| units or dB for S21
+        qreal rms;
+        int iterations;
+    };
+
+    ModelFitter();
+
+    /// Poles of the rational model, a new model drops the warm start
+    void setModel(Model model, int poles = 4);
+    Model model() const { return m_model; }
+    void setReference(qreal z0) { m_z0 = z0; }
+
+    const Result &fit(const Sweep &sweep);
+    const Result &result() const { return m_result; }
+    /// Model over the sweep grid: reflection for RI sweeps, dB for S21
+    const QVector<QPointF> &modelRi() const { return m_modelRi; }
+    const QVector<qreal> &modelDb() const { return m_modelDb; }
+
+    /// Parameters and residual for display, engineering notation
+    QString summary() const;
+
+private:
+    enum Pass {
+        Normal = 0,     // Levenberg-Marquardt J'J, -J'r and r'r
+        Cost,           // r'r only
+        Sigma,          // vector fitting pole identification
+        Residues        // vector fitting residues with fixed poles
+    };
+
+    struct Chunk {
+        const ModelFitter *fitter;
+        Pass pass;
+        int from, to;
+        int columns;
+        QVector<qreal> ata, atb;
+        qreal btb;
+    };
+
+    static void accumulate(Chunk &chunk);
+    void accumulateRange(Chunk &chunk) const;
+    /// Sums of a pass over all points, in parallel for long sweeps
+    void run(Pass pass, int columns, QVector<qreal> *ata, QVector<qreal> *atb, qreal *btb);
+
+    bool initialGuess(QVector<qreal> *p, QString *error) const;
+    void fitCircuit();
+    void fitRational();
+    void evaluate();
+    int basis(const std::complex<qreal> &s, std::complex<qreal> *phi) const;
+    int poleColumns() const;
+
+    Model m_model;
+    int m_poles;
+    qreal m_z0;
+
+    // data of the sweep being fitted
+    bool scalar;
+    QVector<qreal> omega;
+    QVector<QPointF> data;
+    QVector<qreal> db;
+    qreal omegaScale;
+
+    // circuit: log of the element values, rational: poles in units of omegaScale
+    QVector<qreal> params, trial;
+    QVector<QPointF> poles;
+    QVector<qreal> residues;
+
+    // warm start
+    bool warm;
+    int warmPoints;
+    qreal warmStart, warmStop;
+    bool warmScalar;
+
+    Result m_result;
+    QVector<QPointF> m_modelRi;
+    QVector<qreal> m_modelDb;
+};
+
+#endif // MODELFITTER_H
@@ -0,0 +1,426 @@
+#include "networkchain.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+#include <complex>
+#include <math.h>
+
+typedef std::complex<qreal> Complex;
+
+// moebius coefficients of one element at one frequency
+struct Moebius {
+    Complex a, b, c, d;
+};
+
+static Moebius multiply(const Moebius &l, const Moebius &r)
+{
+    Moebius m;
+    m.a = l.a*r.a + l.b*r.c;
+    m.b = l.a*r.b + l.b*r.d;
+    m.c = l.c*r.a + l.d*r.c;
+    m.d = l.c*r.b + l.d*r.d;
+    //only the ratios matter, keep the magnitudes near one
+    qreal scale = abs(m.a) + abs(m.b) + abs(m.c) + abs(m.d);
+    if(scale > 0)
+    {
+        m.a /= scale; m.b /= scale; m.c /= scale; m.d /= scale;
+    }
+    return m;
+}
+
+static Moebius fromAbcd(Complex a, Complex b, Complex c, Complex d, qreal z0)
+//zin = (a zl + b) / (c zl + d) seen through g = (z - z0) / (z + z0)
+{
+    Moebius gz = { z0, z0, -1, 1 };
+    Moebius abcd = { a, b, c, d };
+    Moebius zg = { 1, -z0, 1, z0 };
+    return multiply(zg, multiply(abcd, gz));
+}
+
+static Complex toComplex(const QPointF &p)
+{
+    return Complex(p.x(), p.y());
+}
+
+static Complex interpolate(const QVector<qreal> &freq, const QVector<QPointF> &s, int i, qreal f)
+//linear in re / im between freq[i-1] and freq[i], clamped at the ends
+{
+    if(i <= 0) return toComplex(s.first());
+    if(i >= freq.size()) return toComplex(s.last());
+    qreal t = (f - freq[i-1]) / (freq[i] - freq[i-1]);
+    return toComplex(s[i-1]) + t * (toComplex(s[i]) - toComplex(s[i-1]));
+}
+
+NetworkChain::NetworkChain() :
+    m_z0(50.0),
+    m_dirty(true),
+    m_points(0),
+    m_fstart(0),
+    m_fstop(0)
+{
+}
+
+bool NetworkChain::parse(const QString &text, const QString &dir, QString *error)
+{
+    QVector<Element> chain;
+    QStringList lines = text.split('\n');
+    for(int lineNumber = 1; lineNumber <= lines.size(); lineNumber++)
+    {
+        QString line = lines[lineNumber-1].trimmed();
+        if(line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList fields = line.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+        //a line of separators only has no fields, it falls through to the error
+        QString kind = fields.isEmpty() ? QString() : fields[0].toLower();
+        Element element;
+        element.value = 0;
+        element.vf = 1.0;
+        element.z0 = m_z0;
+        bool ok = true;
+        if((kind == "series" || kind == "shunt") && fields.size() == 3)
+        {
+            QString part = fields[1].toLower();
+            bool shunt = kind == "shunt";
+            if(part == "l") element.type = shunt ? ShuntL : SeriesL;
+            else if(part == "c") element.type = shunt ? ShuntC : SeriesC;
+            else ok = false;
+            if(ok) element.value = fields[2].toDouble(&ok);
+            ok = ok && element.value > 0;
+        }
+        else if(kind == "line" && fields.size() >= 2)
+        {
+            element.type = Line;
+            element.value = fields[1].toDouble(&ok);
+            for(int i = 2; ok && i + 1 < fields.size(); i += 2)
+            {
+                QString key = fields[i].toLower();
+                if(key == "vf") element.vf = fields[i+1].toDouble(&ok);
+                else if(key == "z0") element.z0 = fields[i+1].toDouble(&ok);
+                else ok = false;
+            }
+            ok = ok && fields.size() % 2 == 0 && element.vf > 0 && element.z0 > 0;
+        }
+        else if((kind == "embed" || kind == "deembed") && fields.size() >= 2)
+        {
+            element.type = kind == "embed" ? Embed : Deembed;
+            //the file name is the rest of the line
+            element.fileName = QDir(dir).absoluteFilePath(line.mid(fields[0].length()).trimmed());
+            QString fileError;
+            if(!readTouchstone(element.fileName, &element.fixture, &fileError))
+            {
+                if(error) *error = QString("line %1: %2").arg(lineNumber).arg(fileError);
+                return false;
+            }
+        }
+        else
+            ok = false;
+
+        if(!ok)
+        {
+            if(error) *error = QString("line %1: %2").arg(lineNumber).arg(line);
+            return false;
+        }
+        chain.append(element);
+    }
+
+    elements = chain;
+    m_dirty = true;
+    return true;
+}
+
+void NetworkChain::clear()
+{
+    elements.clear();
+    m_dirty = true;
+}
+
+void NetworkChain::setReference(qreal z0)
+{
+    m_z0 = z0;
+    m_dirty = true;
+}
+
+void NetworkChain::compile(const QVector<qreal> &freq)
+{
+    int n = freq.size();
+    coefA.resize(n);
+    coefB.resize(n);
+    coefC.resize(n);
+    coefD.resize(n);
+
+    //walk position of every fixture on its own frequency grid
+    QVector<int> cursor(elements.size(), 0);
+    for(int i = 0; i < n; i++)
+    {
+        qreal f = freq[i];
+        qreal w = 2 * M_PI * qMax(f, 1.0);
+        Moebius total = { 1, 0, 0, 1 };
+        for(int k = 0; k < elements.size(); k++)
+        {
+            const Element &e = elements[k];
+            Moebius m;
+            switch(e.type)
+            {
+            case SeriesL:
+                m = fromAbcd(1, Complex(0, w * e.value * 1e-9), 0, 1, m_z0);
+                break;
+            case SeriesC:
+                m = fromAbcd(1, Complex(0, -1 / (w * e.value * 1e-12)), 0, 1, m_z0);
+                break;
+            case ShuntL:
+                m = fromAbcd(1, 0, Complex(0, -1 / (w * e.value * 1e-9)), 1, m_z0);
+                break;
+            case ShuntC:
+                m = fromAbcd(1, 0, Complex(0, w * e.value * 1e-12), 1, m_z0);
+                break;
+            case Line:
+            {
+                //lossless line, beta = w / (vf c)
+                qreal theta = w * e.value * 1e-3 / (e.vf * 299792458.0);
+                m = fromAbcd(cos(theta), Complex(0, e.z0 * sin(theta)),
+                             Complex(0, sin(theta) / e.z0), cos(theta), m_z0);
+                break;
+            }
+            case Embed:
+            case Deembed:
+            {
+                const TwoPort &t = e.fixture;
+                int &j = cursor[k];
+                while(j < t.freq.size() && t.freq[j] < f) j++;
+                Complex s11 = interpolate(t.freq, t.s11, j, f);
+                Complex s21 = interpolate(t.freq, t.s21, j, f);
+                Complex s12 = interpolate(t.freq, t.s12, j, f);
+                Complex s22 = interpolate(t.freq, t.s22, j, f);
+                Complex det = s11*s22 - s12*s21;
+                //g' = s11 + s12 s21 g / (1 - s22 g), the inverse for de-embedding
+                if(e.type == Embed)
+                {
+                    Moebius embed = { -det, s11, -s22, 1 };
+                    m = embed;
+                }
+                else
+                {
+                    Moebius deembed = { 1, -s11, s22, -det };
+                    m = deembed;
+                }
+                //the file has its own reference: convert into it and back, for the inverse as well
+                if(t.z0 != m_z0)
+                {
+                    qreal rho = (t.z0 - m_z0) / (t.z0 + m_z0);
+                    Moebius toFile = { 1, -rho, -rho, 1 };
+                    Moebius toChain = { 1, rho, rho, 1 };
+                    m = multiply(toChain, multiply(m, toFile));
+                }
+                break;
+            }
+            }
+            //each element sits at the instrument side of the previous ones
+            total = multiply(m, total);
+        }
+        coefA[i] = QPointF(total.a.real(), total.a.imag());
+        coefB[i] = QPointF(total.b.real(), total.b.imag());
+        coefC[i] = QPointF(total.c.real(), total.c.imag());
+        coefD[i] = QPointF(total.d.real(), total.d.imag());
+    }
+
+    m_points = n;
+    m_fstart = n > 0 ? freq.first() : 0;
+    m_fstop = n > 0 ? freq.last() : 0;
+    m_dirty = false;
+}
+
+Sweep NetworkChain::apply(const Sweep &sweep)
+{
+    if(elements.isEmpty() || sweep.kind() != Sweep::Ri) return sweep;
+
+    const QVector<qreal> &freq = sweep.freq();
+    int n = freq.size();
+    if(m_dirty || n != m_points
+            || (n > 0 && (freq.first() != m_fstart || freq.last() != m_fstop)))
+        compile(freq);
+
+    Sweep out = Sweep::create(Sweep::Ri, n);
+    qreal *f = out.freqData();
+    QPointF *g = out.riData();
+    const QPointF *in = sweep.ri().constData();
+    const QPointF *a = coefA.constData();
+    const QPointF *b = coefB.constData();
+    const QPointF *c = coefC.constData();
+    const QPointF *d = coefD.constData();
+    for(int i = 0; i < n; i++)
+    {
+        f[i] = freq[i];
+        qreal gr = in[i].x(), gi = in[i].y();
+        //(a g + b) / (c g + d)
+        qreal nr = a[i].x()*gr - a[i].y()*gi + b[i].x();
+        qreal ni = a[i].x()*gi + a[i].y()*gr + b[i].y();
+        qreal dr = c[i].x()*gr - c[i].y()*gi + d[i].x();
+        qreal di = c[i].x()*gi + c[i].y()*gr + d[i].y();
+        qreal den = dr*dr + di*di;
+        g[i] = den > 0 ? QPointF((nr*dr + ni*di) / den, (ni*dr - nr*di) / den) : QPointF(1, 0);
+    }
+    return out;
+}
+
+static QString reactanceLine(const QString &position, qreal x, qreal w)
+{
+    if(x > 0)
+        return QString("%1 l %2\n").arg(position).arg(1e9 * x / w, 0, 'g', 4);
+    return QString("%1 c %2\n").arg(position).arg(-1e12 / (w * x), 0, 'g', 4);
+}
+
+static QString susceptanceLine(qreal b, qreal w)
+{
+    if(b > 0)
+        return QString("shunt c %1\n").arg(1e12 * b / w, 0, 'g', 4);
+    return QString("shunt l %1\n").arg(-1e9 / (w * b), 0, 'g', 4);
+}
+
+QString NetworkChain::synthesize(qreal freq, const QPointF &g, qreal z0)
+{
+    Complex gamma = toComplex(g);
+    if(freq <= 0 || abs(Complex(1) - gamma) < 1e-12) return QString();
+    Complex z = z0 * (Complex(1) + gamma) / (Complex(1) - gamma);
+    qreal r = z.real();
+    qreal x = z.imag();
+    if(r <= 0) return QString();
+    qreal w = 2 * M_PI * freq;
+
+    //lines are listed from the load towards the instrument
+    QString chain = QString("# L match at %1 MHz\n").arg(freq / 1e6);
+    const qreal tolerance = 1e-6;
+    if(fabs(r - z0) < tolerance * z0)
+    {
+        if(fabs(x) > tolerance * z0)
+            chain += reactanceLine("series", -x, w);
+    }
+    else if(r > z0)
+    {
+        //shunt across the load, series towards the instrument
+        qreal b = (x + sqrt(r / z0) * sqrt(r*r + x*x - z0*r)) / (r*r + x*x);
+        qreal xs = 1 / b + x * z0 / r - z0 / (b * r);
+        chain += susceptanceLine(b, w);
+        if(fabs(xs) > tolerance * z0)
+            chain += reactanceLine("series", xs, w);
+    }
+    else
+    {
+        //series at the load, shunt towards the instrument
+        qreal xs = sqrt(r * (z0 - r)) - x;
+        qreal b = sqrt((z0 - r) / r) / z0;
+        if(fabs(xs) > tolerance * z0)
+            chain += reactanceLine("series", xs, w);
+        chain += susceptanceLine(b, w);
+    }
+    return chain;
+}
+
+bool NetworkChain::readTouchstone(const QString &fileName, TwoPort *twoPort, QString *error)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        if(error) *error = QString("%1: %2").arg(QFileInfo(fileName).fileName()).arg(file.errorString());
+        return false;
+    }
+
+    //touchstone defaults: # GHz S MA R 50
+    qreal unit = 1e9;
+    qreal z0 = 50;
+    QString format = "ma";
+    QVector<qreal> numbers;
+    bool noise = false;
+    QTextStream in(&file);
+    while(!in.atEnd() && !noise)
+    {
+        QString line = in.readLine();
+        int comment = line.indexOf('!');
+        if(comment >= 0) line.truncate(comment);
+        line = line.trimmed();
+        if(line.isEmpty()) continue;
+
+        QStringList fields = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if(line.startsWith('#'))
+        {
+            fields[0].remove(0, 1);
+            for(int i = 0; i < fields.size(); i++)
+            {
+                QString option = fields[i].toLower();
+                if(option == "hz") unit = 1;
+                else if(option == "khz") unit = 1e3;
+                else if(option == "mhz") unit = 1e6;
+                else if(option == "ghz") unit = 1e9;
+                else if(option == "ri" || option == "ma" || option == "db") format = option;
+                else if(option == "r" && i + 1 < fields.size())
+                {
+                    bool ok;
+                    z0 = fields[++i].toDouble(&ok);
+                    if(!ok || z0 <= 0)
+                    {
+                        if(error) *error = QString("%1: bad reference %2").arg(QFileInfo(fileName).fileName()).arg(fields[i]);
+                        return false;
+                    }
+                }
+                else if(option == "y" || option == "z" || option == "h" || option == "g")
+                {
+                    if(error) *error = QString("%1: only S parameters").arg(QFileInfo(fileName).fileName());
+                    return false;
+                }
+            }
+            continue;
+        }
+        for(int i = 0; i < fields.size(); i++)
+        {
+            bool ok;
+            qreal x = fields[i].toDouble(&ok);
+            if(!ok)
+            {
+                if(error) *error = QString("%1: %2").arg(QFileInfo(fileName).fileName()).arg(line);
+                return false;
+            }
+            //a row whose frequency does not increase starts the noise parameters
+            if(numbers.size() >= 9 && numbers.size() % 9 == 0 && x <= numbers[numbers.size() - 9])
+            {
+                noise = true;
+                break;
+            }
+            numbers.append(x);
+        }
+    }
+
+    //two-port rows: f s11 s21 s12 s22
+    if(numbers.isEmpty() || numbers.size() % 9 != 0)
+    {
+        if(error) *error = QString("%1: not a 2-port file").arg(QFileInfo(fileName).fileName());
+        return false;
+    }
+    int n = numbers.size() / 9;
+    TwoPort t;
+    t.z0 = z0;
+    t.freq.resize(n);
+    QVector<QPointF> *columns[4] = { &t.s11, &t.s21, &t.s12, &t.s22 };
+    for(int k = 0; k < 4; k++)
+        columns[k]->resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        const qreal *row = numbers.constData() + 9*i;
+        t.freq[i] = row[0] * unit;
+        for(int k = 0; k < 4; k++)
+        {
+            qreal u = row[1 + 2*k], v = row[2 + 2*k];
+            if(format == "ri")
+                (*columns[k])[i] = QPointF(u, v);
+            else
+            {
+                qreal mag = format == "db" ? pow(10, u / 20) : u;
+                qreal arg = v * M_PI / 180;
+                (*columns[k])[i] = QPointF(mag * cos(arg), mag * sin(arg));
+            }
+        }
+    }
+    *twoPort = t;
+    return true;
+}
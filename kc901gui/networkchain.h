@@ -0,0 +1,93 @@
+#ifndef NETWORKCHAIN_H
+#define NETWORKCHAIN_H
+
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include "sweep.h"
+
+/// What-if matching network and fixture de-embedding on S11
+/**
+A chain is a list of two-ports, one per line, applied in order to the
+measured reflection. Each element is added at the instrument side of
+what came before, "deembed" removes a fixture from the instrument side:
+
+    # values in nH, pF and mm
+    series l 12
+    shunt c 3.3
+    line 25 [vf 0.66] [z0 50]
+    deembed fixture.s2p
+    embed fixture.s2p
+
+Fixture files are read in their own reference ("R" of the option line)
+and renormalised to the chain reference when the table is compiled. A
+noise parameter block after the S-parameters is skipped.
+
+Every two-port maps the reflection through a Moebius transform
+G' = (a G + b) / (c G + d), so the whole chain collapses to one set of
+coefficients per frequency. The table is compiled when the chain or the
+sweep grid changes, applying it to a sweep is a single pass of complex
+multiplies into a pooled sweep.
+*/
+class NetworkChain
+{
+public:
+    enum ElementType {
+        SeriesL = 0,
+        SeriesC,
+        ShuntL,
+        ShuntC,
+        Line,
+        Embed,
+        Deembed
+    };
+
+    /// Two-port S-parameters from a Touchstone file, in the reference z0 of the file
+    struct TwoPort {
+        qreal z0;
+        QVector<qreal> freq;
+        QVector<QPointF> s11, s21, s12, s22;
+    };
+
+    struct Element {
+        ElementType type;
+        qreal value;      // nH, pF or line length in mm
+        qreal vf;         // line velocity factor
+        qreal z0;         // line impedance
+        QString fileName;
+        TwoPort fixture;
+    };
+
+    NetworkChain();
+
+    /// Parse a chain, fixture paths are relative to dir
+    bool parse(const QString &text, const QString &dir, QString *error);
+    void clear();
+    bool isEmpty() const { return elements.isEmpty(); }
+    int size() const { return elements.size(); }
+
+    void setReference(qreal z0);
+    qreal reference() const { return m_z0; }
+
+    /// RI sweep with the chain applied, the sweep itself if the chain is empty
+    Sweep apply(const Sweep &sweep);
+
+    /// Chain lines of an L section matching g at freq to the reference
+    static QString synthesize(qreal freq, const QPointF &g, qreal z0);
+
+    static bool readTouchstone(const QString &fileName, TwoPort *twoPort, QString *error);
+
+private:
+    void compile(const QVector<qreal> &freq);
+
+    QVector<Element> elements;
+    qreal m_z0;
+
+    // table of the compiled chain and the grid it was built for
+    bool m_dirty;
+    int m_points;
+    qreal m_fstart, m_fstop;
+    QVector<QPointF> coefA, coefB, coefC, coefD;
+};
+
+#endif // NETWORKCHAIN_H
@@ -0,0 +1,107 @@
+#include "peaksearch.h"
+#include <qnumeric.h>
+
+PeakSearch::PeakSearch() :
+    m_peakMode(false),
+    m_notchCount(1)
+{
+    m_result.valid = false;
+    m_notches.reserve(16);
+}
+
+void PeakSearch::setNotchCount(int count)
+{
+    m_notchCount = qBound(1, count, 16);
+}
+
+void PeakSearch::refine(const QVector<qreal> &freq, const QVector<qreal> &db, int i,
+                        qreal *f, qreal *v) const
+//parabola through i-1, i, i+1
+{
+    *f = freq[i];
+    *v = db[i];
+    if(i <= 0 || i >= db.size() - 1) return;
+    qreal a = db[i-1];
+    qreal b = db[i];
+    qreal c = db[i+1];
+    qreal d = a - 2*b + c;
+    if(d == 0 || !qIsFinite(d)) return;
+    qreal delta = 0.5 * (a - c) / d;
+    if(delta < -0.5 || delta > 0.5) return;
+    qreal step = delta < 0 ? freq[i] - freq[i-1] : freq[i+1] - freq[i];
+    *f = freq[i] + delta * step;
+    *v = b - 0.25 * (a - c) * delta;
+}
+
+bool PeakSearch::edges(const QVector<qreal> &freq, const QVector<qreal> &db, int i,
+                       qreal level, bool below, qreal *low, qreal *high) const
+//walk out of the resonance until the trace crosses level
+{
+    int n = db.size();
+    auto inside = [&](int k) { return below ? db[k] <= level : db[k] >= level; };
+    if(!inside(i)) return false;
+    int lo = i;
+    while(lo > 0 && inside(lo - 1)) lo--;
+    int hi = i;
+    while(hi < n - 1 && inside(hi + 1)) hi++;
+    //the band has to close on both sides
+    if(lo == 0 || hi == n - 1) return false;
+
+    qreal d = db[lo] - db[lo-1];
+    *low = d == 0 ? freq[lo] : freq[lo-1] + (level - db[lo-1]) / d * (freq[lo] - freq[lo-1]);
+    d = db[hi+1] - db[hi];
+    *high = d == 0 ? freq[hi] : freq[hi] + (level - db[hi]) / d * (freq[hi+1] - freq[hi]);
+    return true;
+}
+
+const PeakSearch::Result &PeakSearch::search(const QVector<qreal> &freq, const QVector<qreal> &db)
+{
+    Result &r = m_result;
+    int n = qMin(freq.size(), db.size());
+    m_notches.resize(0);
+    r.valid = n >= 3;
+    if(!r.valid) return r;
+
+    //single scan: extrema and the lowest local minima
+    int minIndex = 0, maxIndex = 0;
+    for(int i = 0; i < n; i++)
+    {
+        qreal v = db[i];
+        if(v < db[minIndex]) minIndex = i;
+        if(v > db[maxIndex]) maxIndex = i;
+        if(i == 0 || i == n - 1 || !(v < db[i-1] && v <= db[i+1])) continue;
+        if(m_notches.size() == m_notchCount && v >= m_notches.last().value) continue;
+        Notch notch = { i, freq[i], v };
+        int k = m_notches.size();
+        if(k == m_notchCount)
+        {
+            m_notches.removeLast();
+            k--;
+        }
+        while(k > 0 && m_notches[k-1].value > v) k--;
+        m_notches.insert(k, notch);
+    }
+    for(int k = 0; k < m_notches.size(); k++)
+        refine(freq, db, m_notches[k].index, &m_notches[k].freq, &m_notches[k].value);
+
+    r.minIndex = minIndex;
+    r.maxIndex = maxIndex;
+    refine(freq, db, minIndex, &r.minFreq, &r.minValue);
+    refine(freq, db, maxIndex, &r.maxFreq, &r.maxValue);
+
+    r.index = m_peakMode ? maxIndex : minIndex;
+    r.freq = m_peakMode ? r.maxFreq : r.minFreq;
+    r.value = m_peakMode ? r.maxValue : r.minValue;
+
+    qreal level3 = m_peakMode ? r.maxValue - 3 : r.minValue + 3;
+    qreal level10 = m_peakMode ? r.maxValue - 10 : -10;
+    if(!edges(freq, db, r.index, level3, !m_peakMode, &r.bw3Low, &r.bw3High))
+        r.bw3Low = r.bw3High = r.freq;
+    if(!edges(freq, db, r.index, level10, !m_peakMode, &r.bw10Low, &r.bw10High))
+        r.bw10Low = r.bw10High = r.freq;
+    r.bw3 = r.bw3High - r.bw3Low;
+    r.bw10 = r.bw10High - r.bw10Low;
+    r.center = r.bw3 > 0 ? (r.bw3Low + r.bw3High) / 2 : r.freq;
+    r.q = r.bw3 > 0 ? r.center / r.bw3 : 0;
+    return r;
+}
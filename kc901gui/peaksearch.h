@@ -0,0 +1,68 @@
+#ifndef PEAKSEARCH_H
+#define PEAKSEARCH_H
+
+#include <QVector>
+
+/// Minimum / maximum, notch and bandwidth search on a dB trace
+/**
+One scan finds the global extrema and the lowest local minima, the
+bandwidth edges are then walked outwards from the resonance. Extrema
+are refined with a parabola through the neighbouring samples, band
+edges with linear interpolation.
+
+Notch mode (S11): the resonance is the minimum, bw3 is the width where
+the trace stays below min + 3 dB and bw10 the width below -10 dB.
+Peak mode (S21): the resonance is the maximum, bw3 / bw10 are the
+widths where the trace stays above max - 3 dB / max - 10 dB.
+*/
+class PeakSearch
+{
+public:
+    struct Notch {
+        int index;
+        qreal freq;
+        qreal value;
+    };
+
+    struct Result {
+        bool valid;
+        int minIndex, maxIndex;
+        qreal minFreq, minValue;
+        qreal maxFreq, maxValue;
+        /// resonance, the minimum in notch mode and the maximum in peak mode
+        int index;
+        qreal freq, value;
+        /// band edges, zero width when the trace never crosses the level
+        qreal bw3Low, bw3High, bw3;
+        qreal bw10Low, bw10High, bw10;
+        qreal center;
+        qreal q;
+    };
+
+    PeakSearch();
+
+    void setPeakMode(bool peak) { m_peakMode = peak; }
+    bool peakMode() const { return m_peakMode; }
+
+    void setNotchCount(int count);
+    int notchCount() const { return m_notchCount; }
+
+    const Result &search(const QVector<qreal> &freq, const QVector<qreal> &db);
+    const Result &result() const { return m_result; }
+
+    /// Lowest local minima of the last search, lowest first
+    const QVector<Notch> &notches() const { return m_notches; }
+
+private:
+    void refine(const QVector<qreal> &freq, const QVector<qreal> &db, int i,
+                qreal *f, qreal *v) const;
+    bool edges(const QVector<qreal> &freq, const QVector<qreal> &db, int i,
+               qreal level, bool below, qreal *low, qreal *high) const;
+
+    bool m_peakMode;
+    int m_notchCount;
+    Result m_result;
+    QVector<Notch> m_notches;
+};
+
+#endif // PEAKSEARCH_H
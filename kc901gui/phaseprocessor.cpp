@@ -0,0 +1,94 @@
+#include "phaseprocessor.h"
+#include <math.h>
+
+static const double PI = 3.14159265358979323846;
+
+PhaseProcessor::PhaseProcessor() :
+    m_aperture(2),
+    m_smoothing(1)
+{
+}
+
+void PhaseProcessor::setAperture(int points)
+{
+    m_aperture = qMax(1, points);
+}
+
+void PhaseProcessor::setSmoothing(int points)
+{
+    m_smoothing = qMax(1, points);
+}
+
+void PhaseProcessor::unwrap(const QVector<QPointF> &ri)
+{
+    int n = ri.size();
+    phaseRad.resize(n);
+    qreal offset = 0;
+    qreal last = 0;
+    for(int i = 0; i < n; i++)
+    {
+        qreal p = atan2(ri[i].y(), ri[i].x());
+        if(i > 0)
+        {
+            //keep the step between neighbours inside (-pi, pi]
+            qreal d = p - last;
+            if(d > PI) offset -= 2*PI;
+            else if(d <= -PI) offset += 2*PI;
+        }
+        last = p;
+        phaseRad[i] = p + offset;
+    }
+}
+
+const QVector<qreal> &PhaseProcessor::unwrappedPhase(const QVector<QPointF> &ri)
+{
+    unwrap(ri);
+    int n = phaseRad.size();
+    phaseDeg.resize(n);
+    for(int i = 0; i < n; i++)
+        phaseDeg[i] = phaseRad[i] * 180.0 / PI;
+    return phaseDeg;
+}
+
+const QVector<qreal> &PhaseProcessor::groupDelay(const QVector<qreal> &freq, const QVector<QPointF> &ri)
+{
+    unwrap(ri);
+    int n = qMin(phaseRad.size(), freq.size());
+    delay.resize(n);
+    int half = m_aperture / 2;
+    for(int i = 0; i < n; i++)
+    {
+        //full aperture wherever possible, shifted inwards at the edges
+        int lo = i - half;
+        int hi = lo + m_aperture;
+        if(lo < 0) { lo = 0; hi = qMin(m_aperture, n - 1); }
+        if(hi > n - 1) { hi = n - 1; lo = qMax(0, hi - m_aperture); }
+        qreal df = freq[hi] - freq[lo];
+        delay[i] = (hi == lo || df == 0) ? 0
+                 : -(phaseRad[hi] - phaseRad[lo]) / (2*PI*df) * 1e9;
+    }
+    return delay;
+}
+
+const QVector<qreal> &PhaseProcessor::smooth(const QVector<qreal> &values)
+{
+    int n = values.size();
+    if(m_smoothing <= 1 || n < 2) return values;
+
+    prefix.resize(n + 1);
+    prefix[0] = 0;
+    for(int i = 0; i < n; i++)
+        prefix[i+1] = prefix[i] + values[i];
+
+    smoothed.resize(n);
+    int left = (m_smoothing - 1) / 2;
+    int right = m_smoothing / 2;
+    for(int i = 0; i < n; i++)
+    {
+        //window shrinks at the trace edges
+        int lo = qMax(0, i - left);
+        int hi = qMin(n - 1, i + right);
+        smoothed[i] = (prefix[hi+1] - prefix[lo]) / (hi - lo + 1);
+    }
+    return smoothed;
+}
@@ -0,0 +1,49 @@
+#ifndef PHASEPROCESSOR_H
+#define PHASEPROCESSOR_H
+
+#include <QVector>
+#include <QPointF>
+
+/// Unwrapped phase, group delay and trace smoothing
+/**
+Group delay is the phase slope over an aperture of n points, smoothing
+is a centred moving average. Both are sliding windows over prefix data,
+so the cost is O(points) whatever the aperture. Results are kept in
+member buffers which are reused from sweep to sweep.
+*/
+class PhaseProcessor
+{
+public:
+    PhaseProcessor();
+
+    /// Group delay aperture in points
+    void setAperture(int points);
+    int aperture() const { return m_aperture; }
+
+    /// Smoothing window in points, 1 turns smoothing off
+    void setSmoothing(int points);
+    int smoothing() const { return m_smoothing; }
+
+    /// Unwrapped phase of a RI trace, in degrees
+    const QVector<qreal> &unwrappedPhase(const QVector<QPointF> &ri);
+
+    /// Group delay of a RI trace, in ns
+    const QVector<qreal> &groupDelay(const QVector<qreal> &freq, const QVector<QPointF> &ri);
+
+    /// Moving average of values, returns values itself when smoothing is off
+    const QVector<qreal> &smooth(const QVector<qreal> &values);
+
+private:
+    void unwrap(const QVector<QPointF> &ri);
+
+    int m_aperture;
+    int m_smoothing;
+
+    QVector<qreal> phaseRad;
+    QVector<qreal> phaseDeg;
+    QVector<qreal> delay;
+    QVector<qreal> prefix;
+    QVector<qreal> smoothed;
+};
+
+#endif // PHASEPROCESSOR_H
@@ -0,0 +1,118 @@
+#include "portextension.h"
+#include <math.h>
+
+PortExtension::PortExtension() :
+    m_delay(0),
+    m_loss(0),
+    m_tableDelay(0),
+    m_tableLoss(0),
+    m_points(-1),
+    m_fstart(0),
+    m_fstop(0)
+{
+}
+
+void PortExtension::setDelay(qreal delay)
+{
+    m_delay = delay;
+}
+
+void PortExtension::setLoss(qreal loss)
+{
+    m_loss = loss;
+}
+
+void PortExtension::compile(const QVector<qreal> &freq)
+{
+    int n = freq.size();
+    table.resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        //round trip: twice the phase and twice the loss
+        qreal phase = 4 * M_PI * freq[i] * m_delay;
+        qreal gain = pow(10, 2 * m_loss * sqrt(qMax(freq[i], 0.0) / 1e9) / 20);
+        table[i] = QPointF(gain * cos(phase), gain * sin(phase));
+    }
+    m_tableDelay = m_delay;
+    m_tableLoss = m_loss;
+    m_points = n;
+    m_fstart = n > 0 ? freq.first() : 0;
+    m_fstop = n > 0 ? freq.last() : 0;
+}
+
+Sweep PortExtension::apply(const Sweep &sweep)
+{
+    if(sweep.kind() != Sweep::Ri) return sweep;
+
+    const QVector<qreal> &freq = sweep.freq();
+    int n = freq.size();
+    bool gridChanged = n != m_points
+            || (n > 0 && (freq.first() != m_fstart || freq.last() != m_fstop));
+    //a continuously estimated delay jitters, rebuild only for a visible change
+    qreal fmax = n > 0 ? qMax(fabs(freq.first()), fabs(freq.last())) : 0;
+    bool moved = fabs(4 * M_PI * fmax * (m_delay - m_tableDelay)) > 1e-4
+            || fabs(m_loss - m_tableLoss) > 1e-4;
+    if(gridChanged || moved)
+        compile(freq);
+
+    Sweep out = Sweep::create(Sweep::Ri, n);
+    qreal *f = out.freqData();
+    QPointF *g = out.riData();
+    const QPointF *in = sweep.ri().constData();
+    const QPointF *t = table.constData();
+    for(int i = 0; i < n; i++)
+    {
+        f[i] = freq[i];
+        g[i] = QPointF(in[i].x()*t[i].x() - in[i].y()*t[i].y(),
+                       in[i].x()*t[i].y() + in[i].y()*t[i].x());
+    }
+    return out;
+}
+
+qreal PortExtension::estimateDelay(const QVector<qreal> &freq, const QVector<QPointF> &ri)
+//least squares slope of the unwrapped phase, phase = -4 pi f delay + c
+{
+    int n = qMin(freq.size(), ri.size());
+    if(n < 2) return 0;
+
+    //unwrap by the phase step between neighbours, arg(g[i] conj(g[i-1]))
+    qreal phase = atan2(ri[0].y(), ri[0].x());
+    qreal sf = 0, sp = 0, sff = 0, sfp = 0;
+    for(int i = 0; i < n; i++)
+    {
+        if(i > 0)
+        {
+            qreal re = ri[i].x()*ri[i-1].x() + ri[i].y()*ri[i-1].y();
+            qreal im = ri[i].y()*ri[i-1].x() - ri[i].x()*ri[i-1].y();
+            phase += atan2(im, re);
+        }
+        //frequencies relative to the start keep the sums well conditioned
+        qreal f = freq[i] - freq[0];
+        sf += f;
+        sp += phase;
+        sff += f*f;
+        sfp += f*phase;
+    }
+    qreal den = n*sff - sf*sf;
+    if(den <= 0) return 0;
+    qreal slope = (n*sfp - sf*sp) / den;
+    return -slope / (4 * M_PI);
+}
+
+qreal PortExtension::estimateLoss(const QVector<qreal> &freq, const QVector<QPointF> &ri)
+//|s11| dB = -2 loss sqrt(f / 1 GHz), least squares through the origin
+{
+    int n = qMin(freq.size(), ri.size());
+    qreal sxy = 0, sxx = 0;
+    for(int i = 0; i < n; i++)
+    {
+        qreal mag2 = ri[i].x()*ri[i].x() + ri[i].y()*ri[i].y();
+        if(mag2 <= 0 || freq[i] <= 0) continue;
+        qreal x = sqrt(freq[i] / 1e9);
+        qreal db = 10 * log10(mag2);
+        sxy += x * db;
+        sxx += x * x;
+    }
+    if(sxx <= 0) return 0;
+    return qMax(0.0, -sxy / (2 * sxx));
+}
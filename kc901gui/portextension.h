@@ -0,0 +1,52 @@
+#ifndef PORTEXTENSION_H
+#define PORTEXTENSION_H
+
+#include <QVector>
+#include <QPointF>
+#include "sweep.h"
+
+/// Port extension: removes the delay and loss of a cable in front of the DUT
+/**
+The reflection is rotated by exp(j 2 w delay) and scaled by the round
+trip loss, given in dB one way at 1 GHz and scaled with sqrt(f) like a
+coax cable. Both factors are kept as one complex table per frequency,
+rebuilt when the grid changes or the settings move by more than can be
+seen at the top of the sweep, so applying it is one complex multiply per
+point.
+
+The estimates fit the RI data in one pass: the delay from the slope of
+the unwrapped phase, the loss from |S11| in dB against sqrt(f). The loss
+estimate is only meaningful with an open or short at the cable end.
+*/
+class PortExtension
+{
+public:
+    PortExtension();
+
+    /// One way delay in seconds
+    void setDelay(qreal delay);
+    qreal delay() const { return m_delay; }
+    /// One way loss in dB at 1 GHz
+    void setLoss(qreal loss);
+    qreal loss() const { return m_loss; }
+
+    /// RI sweep with the extension applied
+    Sweep apply(const Sweep &sweep);
+
+    static qreal estimateDelay(const QVector<qreal> &freq, const QVector<QPointF> &ri);
+    static qreal estimateLoss(const QVector<qreal> &freq, const QVector<QPointF> &ri);
+
+private:
+    void compile(const QVector<qreal> &freq);
+
+    qreal m_delay;
+    qreal m_loss;
+
+    // settings and grid the table was built for
+    qreal m_tableDelay, m_tableLoss;
+    int m_points;
+    qreal m_fstart, m_fstop;
+    QVector<QPointF> table;
+};
+
+#endif // PORTEXTENSION_H
@@ -0,0 +1,152 @@
+#include "productionstats.h"
+#include <qnumeric.h>
+#include <math.h>
+
+// compression of the per bin digests, the KPIs get the default
+static const qreal BinCompression = 50;
+
+ProductionStats::ProductionStats() :
+    m_units(0),
+    m_tested(0),
+    m_passed(0),
+    m_kind(Sweep::None),
+    m_points(0),
+    m_start(0),
+    m_stop(0),
+    m_sweeps(0),
+    nextBin(0),
+    stagger(1)
+{
+}
+
+void ProductionStats::setKpis(const QStringList &names)
+{
+    m_names = names;
+    reset();
+}
+
+void ProductionStats::reset()
+{
+    Running empty;
+    empty.count = 0;
+    empty.mean = empty.m2 = 0;
+    running.fill(empty, m_names.size());
+    m_units = m_tested = m_passed = 0;
+    m_kind = Sweep::None;
+    m_points = 0;
+    m_sweeps = 0;
+    nextBin = 0;
+    binFreq.clear();
+    binOf.clear();
+    bins.clear();
+}
+
+void ProductionStats::add(const Sweep &sweep, const QVector<qreal> &kpis, int verdict)
+{
+    m_units++;
+    if(verdict >= 0)
+    {
+        m_tested++;
+        m_passed += verdict;
+    }
+    for(int k = 0; k < kpis.size() && k < running.size(); k++)
+    {
+        qreal x = kpis[k];
+        if(qIsNaN(x)) continue;
+        Running &r = running[k];
+        r.count++;
+        qreal delta = x - r.mean;
+        r.mean += delta / r.count;
+        r.m2 += delta * (x - r.mean);
+        r.digest.add(x);
+    }
+
+    const QVector<qreal> &freq = sweep.freq();
+    int n = freq.size();
+    if(n == 0) return;
+    if(sweep.kind() != m_kind || n != m_points || freq.first() != m_start || freq.last() != m_stop)
+    {
+        //another grid, the envelope starts over
+        m_kind = sweep.kind();
+        m_points = n;
+        m_start = freq.first();
+        m_stop = freq.last();
+        m_sweeps = 0;
+        nextBin = 0;
+        int count = qMin(n, int(MaxBins));
+        bins.fill(TDigest(BinCompression), count);
+        binFreq.fill(0, count);
+        binOf.resize(n);
+        QVector<int> members(count, 0);
+        for(int i = 0; i < n; i++)
+        {
+            int b = qint64(i) * count / n;
+            binOf[i] = b;
+            binFreq[b] += freq[i];
+            members[b]++;
+        }
+        for(int b = 0; b < count; b++)
+            binFreq[b] /= members[b];
+        //every bin merged once in the sweeps that fill most of its buffer
+        stagger = qMax(1, int(3 * BinCompression) / ((n + count - 1) / count));
+    }
+    m_sweeps++;
+    const QVector<qreal> &db = sweep.db();
+    int count = bins.size();
+    TDigest *digest = bins.data();
+    const int *bin = binOf.constData();
+    for(int i = 0; i < n; i++)
+        digest[bin[i]].add(db[i]);
+    //a few bins merged every sweep, before their buffers fill up all in the same sweep
+    for(int k = 0; k < count / stagger + 1; k++)
+    {
+        digest[nextBin].compress();
+        nextBin = (nextBin + 1) % count;
+    }
+}
+
+QVector<ProductionStats::Summary> ProductionStats::summary()
+{
+    QVector<Summary> list;
+    for(int k = 0; k < running.size(); k++)
+    {
+        Running &r = running[k];
+        Summary s;
+        s.name = m_names[k];
+        s.count = r.count;
+        s.mean = r.mean;
+        s.deviation = r.count > 1 ? sqrt(r.m2 / (r.count - 1)) : 0;
+        s.p1 = r.digest.quantile(0.01);
+        s.p50 = r.digest.quantile(0.5);
+        s.p99 = r.digest.quantile(0.99);
+        list.append(s);
+    }
+    return list;
+}
+
+QString ProductionStats::text()
+{
+    QString text = QString("units %1").arg(m_units);
+    if(m_tested > 0)
+        text += QString(", yield %1 / %2 = %3 %").arg(m_passed).arg(m_tested)
+                .arg(100.0 * m_passed / m_tested, 0, 'f', 2);
+    text += QString("\n%1 %2 %3 %4 %5 %6 %7").arg("", -16).arg("n", 8).arg("mean", 10).arg("std", 10)
+            .arg("p1", 10).arg("p50", 10).arg("p99", 10);
+    QVector<Summary> list = summary();
+    for(int k = 0; k < list.size(); k++)
+    {
+        const Summary &s = list[k];
+        text += QString("\n%1 %2 %3 %4 %5 %6 %7").arg(s.name.left(16), -16).arg(s.count, 8)
+                .arg(s.mean, 10, 'g', 5).arg(s.deviation, 10, 'g', 5)
+                .arg(s.p1, 10, 'g', 5).arg(s.p50, 10, 'g', 5).arg(s.p99, 10, 'g', 5);
+    }
+    return text;
+}
+
+QVector<qreal> ProductionStats::envelope(qreal q)
+{
+    QVector<qreal> values(bins.size());
+    for(int b = 0; b < bins.size(); b++)
+        values[b] = bins[b].quantile(q);
+    return values;
+}
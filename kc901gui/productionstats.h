@@ -0,0 +1,81 @@
+#ifndef PRODUCTIONSTATS_H
+#define PRODUCTIONSTATS_H
+
+#include <QVector>
+#include <QStringList>
+#include "sweep.h"
+#include "tdigest.h"
+
+/// Running statistics of a production run, in constant memory
+/**
+Every added sweep is one unit; the window adds single sweeps and the
+steps of a plan, not the repeats of the continuous and tracking loops.
+Counted are the units and, when a limit mask tested them, the passes. Each KPI keeps a running mean and
+variance (Welford) and a t-digest for p1 / p50 / p99, so neither grows
+with the number of units.
+
+The envelope is a t-digest of |S| in dB per frequency bin. A grid of up
+to MaxBins points has one bin per point, a finer grid shares bins
+between neighbouring points. It follows the grid of the sweeps: a sweep
+on another grid or of another kind starts a new envelope, the KPI
+statistics go on.
+*/
+class ProductionStats
+{
+public:
+    struct Summary {
+        QString name;
+        quint64 count;
+        qreal mean, deviation;
+        qreal p1, p50, p99;
+    };
+
+    ProductionStats();
+
+    /// New KPI list, restarts everything
+    void setKpis(const QStringList &names);
+    const QStringList &names() const { return m_names; }
+    void reset();
+
+    /// kpis as from KpiExtractor, empty when there are none, verdict 1 pass, 0 fail, -1 untested
+    void add(const Sweep &sweep, const QVector<qreal> &kpis, int verdict);
+
+    quint64 units() const { return m_units; }
+    quint64 tested() const { return m_tested; }
+    quint64 passed() const { return m_passed; }
+    QVector<Summary> summary();
+    /// Yield and the KPI table as monospace text
+    QString text();
+
+    /// Bin centres, empty before the first sweep
+    const QVector<qreal> &envelopeFreq() const { return binFreq; }
+    /// Quantile q of |S| dB per bin
+    QVector<qreal> envelope(qreal q);
+    Sweep::Kind envelopeKind() const { return m_kind; }
+    quint64 envelopeSweeps() const { return m_sweeps; }
+
+    static const int MaxBins = 1024;
+
+private:
+    struct Running {
+        quint64 count;
+        qreal mean, m2;
+        TDigest digest;
+    };
+
+    QStringList m_names;
+    QVector<Running> running;
+    quint64 m_units, m_tested, m_passed;
+
+    // envelope grid
+    Sweep::Kind m_kind;
+    int m_points;
+    qreal m_start, m_stop;
+    quint64 m_sweeps;
+    int nextBin, stagger;
+    QVector<qreal> binFreq;
+    QVector<int> binOf;
+    QVector<TDigest> bins;
+};
+
+#endif // PRODUCTIONSTATS_H
@@ -0,0 +1,219 @@
+#include "profiler.h"
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+static const int historySize = 256;
+static const int eventSize = 8192;
+
+Profiler::Profiler() :
+    m_enabled(false),
+    events(eventSize)
+{
+    clock.start();
+    for(int s = 0; s < StageCount; s++)
+        history[s].reserve(historySize);
+    reset();
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    if(enabled == m_enabled) return;
+    m_enabled = enabled;
+    //spans started while disabled are not valid
+    sentAt = firstAt = cycleAt = -1;
+    deferredOpen = false;
+    for(int s = 0; s < StageCount; s++)
+    {
+        pending[s] = 0;
+        touched[s] = false;
+    }
+}
+
+void Profiler::reset()
+{
+    sentAt = firstAt = cycleAt = -1;
+    deferredOpen = false;
+    for(int s = 0; s < StageCount; s++)
+    {
+        pending[s] = 0;
+        touched[s] = false;
+        history[s].resize(0);
+        historyHead[s] = 0;
+    }
+    eventHead = 0;
+    eventCount = 0;
+}
+
+void Profiler::record(Stage stage, qint64 begin, qint64 end)
+{
+    if(!m_enabled) return;
+    pending[stage] += end - begin;
+    touched[stage] = true;
+
+    Event &e = events[eventHead];
+    e.begin = begin;
+    e.duration = end - begin;
+    e.stage = stage;
+    eventHead = (eventHead + 1) % eventSize;
+    if(eventCount < eventSize) eventCount++;
+}
+
+void Profiler::commandSent(qint64 begin, qint64 end)
+{
+    if(!m_enabled) return;
+    record(Send, begin, end);
+    sentAt = end;
+    firstAt = -1;
+}
+
+void Profiler::firstByte()
+{
+    if(!m_enabled || sentAt < 0 || firstAt >= 0) return;
+    firstAt = now();
+    record(Instrument, sentAt, firstAt);
+}
+
+void Profiler::replyEnd()
+{
+    if(!m_enabled || firstAt < 0) return;
+    record(Transfer, firstAt, now());
+    //the next command may go out before this reply is handled
+    cycleAt = sentAt;
+    sentAt = firstAt = -1;
+}
+
+void Profiler::endSweep()
+{
+    if(!m_enabled) return;
+    if(cycleAt >= 0)
+        record(Cycle, cycleAt, now());
+    deferredOpen = cycleAt >= 0 && !touched[Replot];
+    cycleAt = -1;
+
+    for(int s = 0; s < StageCount; s++)
+    {
+        if(!touched[s]) continue;
+        if(history[s].size() < historySize)
+            history[s].append(pending[s]);
+        else
+            history[s][historyHead[s]] = pending[s];
+        historyHead[s] = (historyHead[s] + 1) % historySize;
+        pending[s] = 0;
+        touched[s] = false;
+    }
+}
+
+void Profiler::recordDeferred(Stage stage, qint64 begin, qint64 end)
+{
+    if(!m_enabled) return;
+    record(stage, begin, end);
+    //inside the sweep it is summed as usual
+    if(cycleAt >= 0) return;
+    //not caused by a sweep, or its sweep has one already: only in the trace
+    pending[stage] = 0;
+    touched[stage] = false;
+    if(!deferredOpen) return;
+    deferredOpen = false;
+    if(history[stage].size() < historySize)
+        history[stage].append(end - begin);
+    else
+        history[stage][historyHead[stage]] = end - begin;
+    historyHead[stage] = (historyHead[stage] + 1) % historySize;
+    //the cycle of that sweep ends with its replot
+    QVector<qint64> &cycles = history[Cycle];
+    if(!cycles.isEmpty())
+        cycles[(historyHead[Cycle] + historySize - 1) % historySize] += end - begin;
+}
+
+Profiler::Stats Profiler::stats(Stage stage) const
+{
+    Stats st;
+    const QVector<qint64> &h = history[stage];
+    st.count = h.size();
+    st.last = st.mean = st.p50 = st.p95 = st.max = 0;
+    for(int b = 0; b < Buckets; b++) st.histogram[b] = 0;
+    if(h.isEmpty()) return st;
+
+    QVector<qint64> sorted = h;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 sum = 0;
+    for(int i = 0; i < h.size(); i++)
+    {
+        sum += h[i];
+        qint64 us = h[i] / 1000;
+        int b = 0;
+        while(us > 1 && b < Buckets - 1)
+        {
+            us >>= 1;
+            b++;
+        }
+        st.histogram[b]++;
+    }
+    int last = (historyHead[stage] + historySize - 1) % historySize;
+    st.last = h[qMin(last, h.size() - 1)] / 1e3;
+    st.mean = sum / 1e3 / h.size();
+    st.p50 = sorted[(sorted.size() - 1) / 2] / 1e3;
+    st.p95 = sorted[(sorted.size() - 1) * 95 / 100] / 1e3;
+    st.max = sorted.last() / 1e3;
+    return st;
+}
+
+const char *Profiler::stageName(Stage stage)
+{
+    static const char *names[StageCount] = {
+        "Send", "Instrument", "Transfer", "Parse", "Math", "Smith", "Replot", "Cycle"
+    };
+    return names[stage];
+}
+
+QString Profiler::summary() const
+//one line per stage, times in ms, histogram from 1 us to 1 s in log2 steps
+{
+    static const char levels[] = " .:-=+*#@";
+    QString text = QString("%1 %2 %3 %4 %5  1us..1s\n")
+            .arg("stage", -10).arg("last", 8).arg("p50", 8).arg("p95", 8).arg("max", 8);
+    for(int s = 0; s < StageCount; s++)
+    {
+        Stats st = stats(Stage(s));
+        int peak = 0;
+        for(int b = 0; b < Buckets; b++) peak = qMax(peak, st.histogram[b]);
+        QString bars;
+        for(int b = 0; b < Buckets; b++)
+            bars += QChar(levels[peak > 0 ? (st.histogram[b] * 8 + peak - 1) / peak : 0]);
+        text += QString("%1 %2 %3 %4 %5  %6\n").arg(stageName(Stage(s)), -10)
+                .arg(st.last / 1e3, 8, 'f', 2).arg(st.p50 / 1e3, 8, 'f', 2)
+                .arg(st.p95 / 1e3, 8, 'f', 2).arg(st.max / 1e3, 8, 'f', 2).arg(bars);
+    }
+    return text;
+}
+
+bool Profiler::exportTrace(const QString &fileName, QString *error) const
+//chrome trace event format, complete events in microseconds
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        if(error) *error = file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    //one row for the instrument and the link, one for the host, one for whole sweeps
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"KC901\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"host\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"sweep\"}}";
+    int first = (eventHead - eventCount + eventSize) % eventSize;
+    for(int i = 0; i < eventCount; i++)
+    {
+        const Event &e = events[(first + i) % eventSize];
+        int tid = e.stage == Instrument || e.stage == Transfer ? 1 : 2;
+        if(e.stage == Cycle) tid = 3;
+        out << ",\n{\"name\":\"" << stageName(Stage(e.stage)) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << QString::number(e.begin / 1e3, 'f', 3)
+            << ",\"dur\":" << QString::number(e.duration / 1e3, 'f', 3) << "}";
+    }
+    out << "\n]}\n";
+    return true;
+}
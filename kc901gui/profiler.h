@@ -0,0 +1,124 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QString>
+
+/// Per stage timing of the sweep cycle
+/**
+Instrument time runs from the command write to the first reply byte,
+transfer from there to $end. Host stages (parse, math, Smith chart,
+replot) are timed with ProfileScope, a stage timed several times in one
+sweep is summed. endSweep() moves the sums into a rolling window of the
+last sweeps per stage, from which the percentiles and a log2 histogram
+are taken. Every span is also kept in an event ring for the Chrome
+trace export (chrome://tracing, ui.perfetto.dev).
+
+The replot is rate limited and may run after its sweep was closed.
+recordDeferred() then adds its time to that sweep and its cycle.
+
+When disabled every hook is a single branch.
+*/
+class Profiler
+{
+public:
+    enum Stage {
+        Send = 0,
+        Instrument,
+        Transfer,
+        Parse,
+        Math,
+        Smith,
+        Replot,
+        Cycle,
+        StageCount
+    };
+
+    /// log2 buckets of microseconds, the last one takes everything above
+    enum { Buckets = 21 };
+
+    struct Stats {
+        int count;
+        /// microseconds
+        qreal last, mean, p50, p95, max;
+        int histogram[Buckets];
+    };
+
+    Profiler();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+    void reset();
+
+    qint64 now() const { return clock.nsecsElapsed(); }
+    void record(Stage stage, qint64 begin, qint64 end);
+
+    /// Sweep command written between begin and end
+    void commandSent(qint64 begin, qint64 end);
+    void firstByte();
+    void replyEnd();
+    /// Close the sweep, called when its reply is fully handled
+    void endSweep();
+    /// Stage that may run after its sweep was closed, the deferred replot
+    /**
+    Counted in the open sweep if there is one, else added to the last
+    closed sweep and its cycle, once. Other spans only go to the trace.
+    */
+    void recordDeferred(Stage stage, qint64 begin, qint64 end);
+
+    Stats stats(Stage stage) const;
+    static const char *stageName(Stage stage);
+    /// Table of all stages for the profile dock
+    QString summary() const;
+
+    bool exportTrace(const QString &fileName, QString *error = 0) const;
+
+private:
+    struct Event {
+        qint64 begin;
+        qint64 duration;
+        int stage;
+    };
+
+    QElapsedTimer clock;
+    bool m_enabled;
+    qint64 sentAt, firstAt, cycleAt;
+    qint64 pending[StageCount];
+    bool touched[StageCount];
+    //the last closed sweep still takes a deferred stage
+    bool deferredOpen;
+
+    //rolling window of per sweep durations in ns
+    QVector<qint64> history[StageCount];
+    int historyHead[StageCount];
+
+    //ring of the latest spans
+    QVector<Event> events;
+    int eventHead;
+    int eventCount;
+};
+
+/// Times the enclosing block as one stage
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler *profiler, Profiler::Stage stage) :
+        p(profiler),
+        s(stage),
+        begin(profiler->isEnabled() ? profiler->now() : -1)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if(begin >= 0) p->record(s, begin, p->now());
+    }
+
+private:
+    Profiler *p;
+    Profiler::Stage s;
+    qint64 begin;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,94 @@
+#include "resonancetracker.h"
+
+ResonanceTracker::ResonanceTracker() :
+    m_state(Idle),
+    m_spanFactor(4.0),
+    m_minSpan(10e3),
+    m_minDepth(3.0),
+    m_lockPts(201),
+    m_lost(0),
+    searchCent(0),
+    searchSpan(0),
+    searchPts(0),
+    m_cent(0),
+    m_span(0),
+    m_pts(0)
+{
+}
+
+QString ResonanceTracker::stateName() const
+{
+    switch(m_state)
+    {
+    case Searching: return "Searching";
+    case Acquiring: return "Acquiring";
+    case Locked: return "Locked";
+    default: return "Idle";
+    }
+}
+
+void ResonanceTracker::start(qreal cent, qreal span, int pts)
+{
+    searchCent = cent;
+    searchSpan = span;
+    searchPts = pts;
+    m_lost = 0;
+    search();
+}
+
+void ResonanceTracker::stop()
+{
+    m_state = Idle;
+}
+
+void ResonanceTracker::search()
+{
+    m_state = Searching;
+    m_cent = searchCent;
+    m_span = searchSpan;
+    m_pts = searchPts;
+}
+
+void ResonanceTracker::update(const PeakSearch::Result &r, qreal cent, qreal span, int pts)
+{
+    if(m_state == Idle) return;
+
+    //a resonance on the first / last 5% of the sweep may be outside of it
+    int edge = qMax(1, pts / 20);
+    bool found = r.valid
+            && r.maxValue - r.minValue >= m_minDepth
+            && r.index >= edge && r.index < pts - edge;
+
+    if(!found)
+    {
+        m_lost++;
+        if(m_state != Searching && m_lost == 1)
+        {
+            //lost once: look around the last position with a wider span
+            m_state = Acquiring;
+            m_cent = cent;
+            m_span = qMin(span * 4, searchSpan);
+        }
+        else
+        {
+            search();
+            return;
+        }
+    }
+    else
+    {
+        m_lost = 0;
+        m_cent = r.freq;
+        qreal target = qMax(m_minSpan, r.bw3 > 0 ? r.bw3 * m_spanFactor : span / 4);
+        //narrow in steps so a fast moving resonance stays in the window
+        m_span = qMax(target, span / 4);
+        m_state = m_span <= target ? Locked : Acquiring;
+        m_pts = m_lockPts;
+    }
+
+    //stay inside the search window
+    qreal low = searchCent - searchSpan / 2;
+    qreal high = searchCent + searchSpan / 2;
+    m_span = qMin(m_span, searchSpan);
+    m_cent = qBound(low + m_span / 2, m_cent, high - m_span / 2);
+}
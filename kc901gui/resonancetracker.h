@@ -0,0 +1,68 @@
+#ifndef RESONANCETRACKER_H
+#define RESONANCETRACKER_H
+
+#include <QString>
+#include "peaksearch.h"
+
+/// Closed loop cent / span control that follows a resonance
+/**
+Starts from a wide search sweep. Every result re-centres the next sweep
+on the resonance and narrows the span towards a few 3 dB bandwidths,
+with the locked point count. A resonance that is too shallow or sits on
+the sweep edge counts as lost: the span is widened once around the last
+position, then the tracker falls back to the search sweep.
+*/
+class ResonanceTracker
+{
+public:
+    enum State {
+        Idle = 0,
+        Searching,
+        Acquiring,
+        Locked
+    };
+
+    ResonanceTracker();
+
+    /// Span is a multiple of the 3 dB bandwidth when locked
+    void setSpanFactor(qreal factor) { m_spanFactor = factor; }
+    /// Smallest span the tracker narrows to, in Hz
+    void setMinSpan(qreal span) { m_minSpan = span; }
+    /// Minimum max - min contrast in dB for a valid resonance
+    void setMinDepth(qreal depth) { m_minDepth = depth; }
+    /// Point count once the resonance is found
+    void setLockPoints(int pts) { m_lockPts = pts; }
+
+    void start(qreal cent, qreal span, int pts);
+    void stop();
+    bool isActive() const { return m_state != Idle; }
+    State state() const { return m_state; }
+    QString stateName() const;
+
+    /// Feed the search result of the sweep taken with cent / span
+    void update(const PeakSearch::Result &r, qreal cent, qreal span, int pts);
+
+    qreal cent() const { return m_cent; }
+    qreal span() const { return m_span; }
+    int pts() const { return m_pts; }
+
+private:
+    void search();
+
+    State m_state;
+    qreal m_spanFactor;
+    qreal m_minSpan;
+    qreal m_minDepth;
+    int m_lockPts;
+    int m_lost;
+
+    // wide search window
+    qreal searchCent, searchSpan;
+    int searchPts;
+
+    // next sweep
+    qreal m_cent, m_span;
+    int m_pts;
+};
+
+#endif // RESONANCETRACKER_H
@@ -0,0 +1,138 @@
+#include "ringpublisher.h"
+#include <QtGlobal>
+#include <QByteArray>
+#include <string.h>
+#include <errno.h>
+#ifdef Q_OS_UNIX
+#include "sweepring.h"
+#endif
+
+RingPublisher::RingPublisher() :
+    ring(0),
+    m_size(0),
+    m_published(0),
+    m_skipped(0)
+{
+}
+
+RingPublisher::~RingPublisher()
+{
+    close();
+}
+
+#ifdef Q_OS_UNIX
+
+bool RingPublisher::open(const QString &name, int slotCount, int maxPoints, QString *error)
+{
+    close();
+    QByteArray key = name.toLocal8Bit();
+    size_t size = kc_ring_size(slotCount, maxPoints);
+    int fd = shm_open(key.constData(), O_CREAT | O_RDWR, 0600);
+    if(fd < 0 || ftruncate(fd, size) < 0)
+    {
+        if(error) *error = QString::fromLocal8Bit(strerror(errno));
+        if(fd >= 0) ::close(fd);
+        return false;
+    }
+    void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(p == MAP_FAILED)
+    {
+        if(error) *error = QString::fromLocal8Bit(strerror(errno));
+        shm_unlink(key.constData());
+        return false;
+    }
+
+    //a fresh ring, readers check the magic last
+    ring = static_cast<KcRingHeader *>(p);
+    memset(ring, 0, sizeof(KcRingHeader));
+    ring->version = KC_RING_VERSION;
+    ring->slotCount = slotCount;
+    ring->maxPoints = maxPoints;
+    ring->slotSize = sizeof(KcSlotHeader) + 3 * sizeof(double) * maxPoints;
+    for(int i = 0; i < slotCount; i++)
+        memset(kc_ring_slot(ring, i + 1), 0, sizeof(KcSlotHeader));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(ring->magic, KC_RING_MAGIC, sizeof(ring->magic));
+
+    m_size = size;
+    m_name = name;
+    m_published = 0;
+    m_skipped = 0;
+    return true;
+}
+
+void RingPublisher::close()
+{
+    if(!ring) return;
+    munmap(ring, m_size);
+    shm_unlink(m_name.toLocal8Bit().constData());
+    ring = 0;
+    m_size = 0;
+}
+
+void RingPublisher::publish(const Sweep &sweep, qreal cent, qreal span, qint64 timestamp)
+{
+    if(!ring || sweep.isNull()) return;
+    int n = sweep.size();
+    if(n > (int)ring->maxPoints)
+    {
+        m_skipped++;
+        return;
+    }
+
+    KcSlotHeader *slot = kc_ring_slot(ring, m_published + 1);
+    kc_slot_write_begin(slot);
+    slot->number = m_published + 1;
+    slot->kind = sweep.kind();
+    slot->points = n;
+    slot->cent = cent;
+    slot->span = span;
+    slot->timestamp = timestamp;
+    double *freq = kc_slot_column(ring, slot, 0);
+    double *re = kc_slot_column(ring, slot, 1);
+    double *im = kc_slot_column(ring, slot, 2);
+    memcpy(freq, sweep.freq().constData(), n * sizeof(double));
+    if(sweep.kind() == Sweep::Ri)
+    {
+        //split the interleaved pairs into the two columns
+        const QPointF *ri = sweep.ri().constData();
+        for(int i = 0; i < n; i++)
+        {
+            re[i] = ri[i].x();
+            im[i] = ri[i].y();
+        }
+    }
+    else
+    {
+        memcpy(re, sweep.value().constData(), n * sizeof(double));
+        memset(im, 0, n * sizeof(double));
+    }
+    kc_slot_write_end(ring, slot);
+    m_published++;
+}
+
+#else
+
+bool RingPublisher::open(const QString &name, int slotCount, int maxPoints, QString *error)
+{
+    Q_UNUSED(name);
+    Q_UNUSED(slotCount);
+    Q_UNUSED(maxPoints);
+    if(error) *error = "POSIX shared memory only";
+    return false;
+}
+
+void RingPublisher::close()
+{
+}
+
+void RingPublisher::publish(const Sweep &sweep, qreal cent, qreal span, qint64 timestamp)
+{
+    Q_UNUSED(sweep);
+    Q_UNUSED(cent);
+    Q_UNUSED(span);
+    Q_UNUSED(timestamp);
+}
+
+#endif
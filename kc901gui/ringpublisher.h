@@ -0,0 +1,40 @@
+#ifndef RINGPUBLISHER_H
+#define RINGPUBLISHER_H
+
+#include <QString>
+#include "sweep.h"
+
+struct KcRingHeader;
+
+/// Writes finished sweeps into the shared memory ring of sweepring.h
+/**
+Creates the POSIX shared memory object, sized for a fixed number of
+slots of maxPoints samples, and copies each sweep into the next slot
+under the slot's seqlock. Readers in other processes map the same
+object and use the arrays in place. Sweeps longer than maxPoints are
+skipped. Only available on POSIX systems.
+*/
+class RingPublisher
+{
+public:
+    RingPublisher();
+    ~RingPublisher();
+
+    bool open(const QString &name, int slotCount, int maxPoints, QString *error = 0);
+    void close();
+    bool isOpen() const { return ring != 0; }
+
+    void publish(const Sweep &sweep, qreal cent, qreal span, qint64 timestamp);
+
+    quint64 published() const { return m_published; }
+    int skipped() const { return m_skipped; }
+
+private:
+    KcRingHeader *ring;
+    size_t m_size;
+    QString m_name;
+    quint64 m_published;
+    int m_skipped;
+};
+
+#endif // RINGPUBLISHER_H
@@ -58,6 +58,7 @@ SmithChart::SmithChart(QWidget * parent) : QWidget(parent)
     scaleColor = QColor(Qt::black);
     pointDataPen = QPen(QColor("red"), 4.0, Qt::SolidLine, Qt::RoundCap);
     lineDataPen = QPen(QColor("blue"), 1.0);
+    markerPen = QPen(QColor("red"), 2.0);
 
     textFont = QFont("consolas", 8, QFont::Light);
     textFont.setStyleStrategy(QFont::PreferAntialias);
@@ -75,7 +76,8 @@ SmithChart::~SmithChart()
 
 void SmithChart::clear()
 {
-    dataVector.clear();
+    //keep the capacity for the next sweep
+    dataVector.resize(0);
     update();
 }
 
@@ -294,6 +296,12 @@ void SmithChart::draw(QPainter * painter)
         for(int i=1; i < dataVector.size(); i++)
             painter->drawLine(dataVector.at(i-1), dataVector.at(i));
     }
+
+    // Draw the markers
+    painter->setPen(markerPen);
+    painter->setBrush(Qt::NoBrush);
+    for(int i=0; i < markerVector.size(); i++)
+        painter->drawEllipse(markerVector.at(i), 12.0, 12.0);
 }
 
 void SmithChart::setZ(const double & real, const double & imaginary)
@@ -317,8 +325,9 @@ void SmithChart::setZ(const QVector<QPointF> ZVector)
     update();
 }
 
-void SmithChart::setReflection(const QVector<QPointF> L)
+void SmithChart::setReflection(const QVector<QPointF> &L)
 {
+    dataVector.reserve(dataVector.size() + L.size());
     for(int i=0; i < L.size(); i++)
     {
         QPointF point = calculateXY(L.at(i).x(), L.at(i).y());
@@ -328,6 +337,15 @@ void SmithChart::setReflection(const QVector<QPointF> L)
     update();
 }
 
+void SmithChart::setMarkers(const QVector<QPointF> &L)
+{
+    markerVector.resize(0);
+    for(int i=0; i < L.size(); i++)
+        markerVector.append(calculateXY(L.at(i).x(), L.at(i).y()));
+
+    update();
+}
+
 void SmithChart::setStyle(QBrush background, QColor scale, QPen datapoint, QPen dataline)
 {
     backgroundBrush = background;
@@ -58,7 +58,13 @@ public:
 	*/
     void setZ(const QVector<QPointF> ZVector);
 
-    void setReflection(const QVector<QPointF> L);
+    void setReflection(const QVector<QPointF> &L);
+
+    /// Sets the marker points, given as reflection coefficients
+    /**
+    An empty vector removes the markers. The markers are kept by clear().
+    */
+    void setMarkers(const QVector<QPointF> &L);
 
     void setStyle(QBrush background, QColor scale = QColor(Qt::black), QPen datapoint = QPen(Qt::red, 4.0, Qt::SolidLine, Qt::RoundCap), QPen dataline = QPen(Qt::blue, 1.0));
 
@@ -109,6 +115,9 @@ private:
 	/// The data vector
 	QVector<QPointF> dataVector;
 
+	/// The marker vector
+	QVector<QPointF> markerVector;
+
 	/// A done flag
 	bool arcsCalculated;
 
@@ -125,6 +134,8 @@ private:
 	QPen pointDataPen;
 	/// Pen for the lines interpolating the data points
 	QPen lineDataPen;
+	/// Pen for the markers
+	QPen markerPen;
 
 	/// Path for the thin arcs
 	QPainterPath thinArcsPath;
@@ -0,0 +1,194 @@
+#include "streamserver.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QStringList>
+#include <QRegExp>
+#include <string.h>
+
+// a client further behind than this loses frames
+static const qint64 MaxPending = 8 * 1024 * 1024;
+static const int MaxRequests = 64;
+static const int HeaderSize = 24;
+
+StreamServer::StreamServer(QObject *parent) :
+    QObject(parent),
+    m_dropped(0)
+{
+    server = new QTcpServer(this);
+    connect(server, SIGNAL(newConnection()), this, SLOT(acceptClient()));
+}
+
+StreamServer::~StreamServer()
+{
+    close();
+}
+
+bool StreamServer::listen(quint16 port, QString *error)
+{
+    close();
+    if(!server->listen(QHostAddress::LocalHost, port))
+    {
+        if(error) *error = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void StreamServer::close()
+{
+    server->close();
+    for(int i = 0; i < clients.size(); i++)
+    {
+        clients[i].socket->disconnect(this);
+        clients[i].socket->abort();
+        clients[i].socket->deleteLater();
+    }
+    clients.clear();
+    requests.clear();
+    emit clientsChanged(0);
+}
+
+bool StreamServer::isListening() const
+{
+    return server->isListening();
+}
+
+quint16 StreamServer::port() const
+{
+    return server->serverPort();
+}
+
+void StreamServer::acceptClient()
+{
+    while(server->hasPendingConnections())
+    {
+        Client client;
+        client.socket = server->nextPendingConnection();
+        client.paused = false;
+        connect(client.socket, SIGNAL(readyRead()), this, SLOT(readClient()));
+        connect(client.socket, SIGNAL(disconnected()), this, SLOT(removeClient()));
+        clients.append(client);
+    }
+    emit clientsChanged(clients.size());
+}
+
+void StreamServer::removeClient()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    int i = clientIndex(socket);
+    if(i < 0) return;
+    clients.remove(i);
+    socket->deleteLater();
+    emit clientsChanged(clients.size());
+}
+
+int StreamServer::clientIndex(QTcpSocket *socket) const
+{
+    for(int i = 0; i < clients.size(); i++)
+        if(clients[i].socket == socket) return i;
+    return -1;
+}
+
+void StreamServer::readClient()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    int i = clientIndex(socket);
+    if(i < 0) return;
+
+    while(socket->canReadLine())
+    {
+        QString line = QString::fromLatin1(socket->readLine()).trimmed();
+        QStringList fields = line.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts);
+        if(fields.isEmpty()) continue;
+        QString command = fields[0].toLower();
+
+        if(command == "pause" || command == "resume")
+        {
+            clients[i].paused = command == "pause";
+            reply(socket, "ok");
+            continue;
+        }
+        if(command == "id")
+        {
+            reply(socket, "kc901gui stream 1");
+            continue;
+        }
+
+        Request request;
+        bool ok = fields.size() == 4;
+        if(command == "ri") request.kind = Sweep::Ri;
+        else if(command == "vswr") request.kind = Sweep::Vswr;
+        else if(command == "s21") request.kind = Sweep::S21;
+        else ok = false;
+        if(ok) request.cent = fields[1].toDouble(&ok);
+        if(ok) request.span = fields[2].toDouble(&ok);
+        if(ok) request.pts = fields[3].toInt(&ok);
+        if(!ok || request.cent <= 0 || request.span <= 0 || request.pts <= 0)
+        {
+            reply(socket, "error " + line.toLatin1());
+            continue;
+        }
+        if(requests.size() >= MaxRequests)
+        {
+            reply(socket, "error queue full");
+            continue;
+        }
+        requests.enqueue(request);
+        reply(socket, QString("queued %1").arg(requests.size()).toLatin1());
+        emit requestQueued();
+    }
+}
+
+void StreamServer::beginFrame(quint16 kind, quint64 serial, quint32 points)
+//header into the reused frame buffer
+{
+    quint16 version = 1;
+    quint32 reserved = 0;
+    char *p = frame.data();
+    memcpy(p, "KCSW", 4);
+    memcpy(p + 4, &version, 2);
+    memcpy(p + 6, &kind, 2);
+    memcpy(p + 8, &serial, 8);
+    memcpy(p + 16, &points, 4);
+    memcpy(p + 20, &reserved, 4);
+}
+
+void StreamServer::reply(QTcpSocket *socket, const QByteArray &text)
+{
+    frame.resize(HeaderSize + text.size());
+    beginFrame(TextFrame, 0, text.size());
+    memcpy(frame.data() + HeaderSize, text.constData(), text.size());
+    socket->write(frame);
+}
+
+void StreamServer::publish(const Sweep &sweep)
+{
+    if(clients.isEmpty() || sweep.isNull()) return;
+
+    //build the frame once for all clients
+    int n = sweep.size();
+    bool ri = sweep.kind() == Sweep::Ri;
+    int columns = ri ? 3 : 2;
+    frame.resize(HeaderSize + columns * n * sizeof(double));
+    beginFrame(sweep.kind(), sweep.serial(), n);
+    char *p = frame.data() + HeaderSize;
+    memcpy(p, sweep.freq().constData(), n * sizeof(double));
+    p += n * sizeof(double);
+    if(ri)
+        memcpy(p, sweep.ri().constData(), 2 * n * sizeof(double));
+    else
+        memcpy(p, sweep.value().constData(), n * sizeof(double));
+
+    for(int i = 0; i < clients.size(); i++)
+    {
+        if(clients[i].paused) continue;
+        QTcpSocket *socket = clients[i].socket;
+        if(socket->bytesToWrite() > MaxPending)
+        {
+            m_dropped++;
+            continue;
+        }
+        socket->write(frame);
+    }
+}
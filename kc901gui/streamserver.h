@@ -0,0 +1,97 @@
+#ifndef STREAMSERVER_H
+#define STREAMSERVER_H
+
+#include <QObject>
+#include <QVector>
+#include <QQueue>
+#include <QByteArray>
+#include "sweep.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+/// Localhost server streaming every parsed sweep to other processes
+/**
+Listens on 127.0.0.1. Every connected client receives each sweep as one
+binary frame, native (little endian) byte order:
+
+    offset  0  char[4]  "KCSW"
+            4  quint16  version, 1
+            6  quint16  kind: 0 text, 1 vswr, 2 ri, 3 s21 (Sweep::Kind)
+            8  quint64  sweep serial
+           16  quint32  points, byte count for text frames
+           20  quint32  reserved, 0
+           24  double   freq[points]
+               double   value[points]      vswr / s21 sweeps
+               double   ri[2 * points]     ri sweeps, re and im interleaved
+
+Clients send text lines on the same connection:
+
+    ri|vswr|s21 cent span pts   queue a sweep, sent like the GUI would
+    pause / resume              stop / restart the sweep frames
+    id                          server name and version
+
+and get a text frame in reply. A frame is built once per sweep and only
+when somebody listens. A client that does not keep up loses frames
+instead of growing its buffer, so subscribers never slow the sweeps.
+*/
+class StreamServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum FrameKind {
+        TextFrame = 0
+    };
+
+    struct Request {
+        Sweep::Kind kind;
+        qreal cent, span;
+        int pts;
+    };
+
+    explicit StreamServer(QObject *parent = 0);
+    ~StreamServer();
+
+    bool listen(quint16 port, QString *error = 0);
+    void close();
+    bool isListening() const;
+    quint16 port() const;
+
+    int clientCount() const { return clients.size(); }
+    /// Frames dropped for slow clients since start
+    int dropped() const { return m_dropped; }
+
+    /// Send a sweep to every subscribed client
+    void publish(const Sweep &sweep);
+
+    bool hasRequest() const { return !requests.isEmpty(); }
+    Request takeRequest() { return requests.dequeue(); }
+
+signals:
+    void requestQueued();
+    void clientsChanged(int count);
+
+private slots:
+    void acceptClient();
+    void readClient();
+    void removeClient();
+
+private:
+    struct Client {
+        QTcpSocket *socket;
+        bool paused;
+    };
+
+    int clientIndex(QTcpSocket *socket) const;
+    void reply(QTcpSocket *socket, const QByteArray &text);
+    void beginFrame(quint16 kind, quint64 serial, quint32 points);
+
+    QTcpServer *server;
+    QVector<Client> clients;
+    QQueue<Request> requests;
+    QByteArray frame;
+    int m_dropped;
+};
+
+#endif // STREAMSERVER_H
@@ -0,0 +1,259 @@
+#include "sweep.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInteger>
+#include <qmath.h>
+#include <algorithm>
+
+// floor of the dB column, -200 dB
+static const qreal MinPower = 1e-20;
+static const qreal MinMagnitude = 1e-10;
+
+// serial of the next sweep, outside of the pool lock
+static QAtomicInteger<quint64> serials;
+
+/// Free list of sweep storages, the columns keep their capacity
+class SweepPool
+{
+public:
+    SweepPool()
+    {
+        free.reserve(8);
+    }
+
+    ~SweepPool()
+    {
+        qDeleteAll(free);
+    }
+
+    Sweep::Data *acquire()
+    {
+        QMutexLocker lock(&mutex);
+        Sweep::Data *data;
+        if(free.isEmpty())
+            data = new Sweep::Data;
+        else
+        {
+            data = free.last();
+            free.removeLast();
+        }
+        data->ref.store(1);
+        data->serial = serials.fetchAndAddRelaxed(1) + 1;
+        return data;
+    }
+
+    void recycle(Sweep::Data *data)
+    {
+        QMutexLocker lock(&mutex);
+        //a few sweeps in flight are enough, drop the rest
+        if(free.size() >= 8)
+        {
+            delete data;
+            return;
+        }
+        free.append(data);
+    }
+
+    QMutex mutex;
+    QVector<Sweep::Data *> free;
+};
+
+static SweepPool *pool()
+{
+    static SweepPool instance;
+    return &instance;
+}
+
+Sweep::Sweep() :
+    d(0)
+{
+}
+
+Sweep::Sweep(const Sweep &other) :
+    d(other.d)
+{
+    if(d) d->ref.ref();
+}
+
+Sweep::~Sweep()
+{
+    release();
+}
+
+Sweep &Sweep::operator=(const Sweep &other)
+{
+    if(other.d) other.d->ref.ref();
+    release();
+    d = other.d;
+    return *this;
+}
+
+void Sweep::release()
+{
+    if(d && !d->ref.deref())
+        pool()->recycle(d);
+    d = 0;
+}
+
+Sweep Sweep::create(Kind kind, int points)
+{
+    Data *data = pool()->acquire();
+    data->kind = kind;
+    //resize keeps the capacity of a recycled storage
+    data->freq.resize(points);
+    data->value.resize(kind == Ri ? 0 : points);
+    data->ri.resize(kind == Ri ? points : 0);
+    //derived columns are resized when they are computed
+    data->columns = 0;
+    return Sweep(data);
+}
+
+void Sweep::recreate(Kind kind, int points)
+//a batch worker refills its own sweeps, the pool mutex is not taken per sweep
+{
+    if(!d || d->ref.load() != 1)
+    {
+        *this = create(kind, points);
+        return;
+    }
+    d->kind = kind;
+    d->serial = serials.fetchAndAddRelaxed(1) + 1;
+    d->freq.resize(points);
+    d->value.resize(kind == Ri ? 0 : points);
+    d->ri.resize(kind == Ri ? points : 0);
+    d->columns = 0;
+}
+
+const QVector<qreal> &Sweep::freq() const
+{
+    static const QVector<qreal> empty;
+    return d ? d->freq : empty;
+}
+
+const QVector<qreal> &Sweep::value() const
+{
+    static const QVector<qreal> empty;
+    return d ? d->value : empty;
+}
+
+const QVector<QPointF> &Sweep::ri() const
+{
+    static const QVector<QPointF> empty;
+    return d ? d->ri : empty;
+}
+
+void Sweep::materialize(Column column) const
+{
+    QMutexLocker lock(&d->lock);
+    if(d->columns & column) return;
+
+    int n = d->freq.size();
+    const qreal *v = d->value.constData();
+    const QPointF *ri = d->ri.constData();
+    switch(column)
+    {
+    case DbColumn:
+        d->db.resize(n);
+        //a perfect match is -200 dB, not -inf, the searches interpolate on it
+        for(int i = 0; i < n; i++)
+        {
+            if(d->kind == Ri)
+                d->db[i] = 10*log10(qMax(ri[i].x()*ri[i].x() + ri[i].y()*ri[i].y(), MinPower));
+            else if(d->kind == Vswr)
+                d->db[i] = 20*log10(qMax((v[i]-1)/(v[i]+1), MinMagnitude));
+            else
+                d->db[i] = v[i];
+        }
+        break;
+    case VswrColumn:
+        d->vswr.resize(d->kind == S21 ? 0 : n);
+        if(d->kind == Vswr)
+        {
+            //copied, sharing value would detach it on the next create()
+            std::copy(v, v + n, d->vswr.begin());
+            break;
+        }
+        for(int i = 0; i < d->vswr.size(); i++)
+        {
+            qreal mag = sqrt(ri[i].x()*ri[i].x() + ri[i].y()*ri[i].y());
+            d->vswr[i] = (1+mag)/(1-mag);
+        }
+        break;
+    case PhaseColumn:
+        d->phase.resize(d->kind == Ri ? n : 0);
+        for(int i = 0; i < d->phase.size(); i++)
+            d->phase[i] = qRadiansToDegrees(atan2(ri[i].y(), ri[i].x()));
+        break;
+    case ZColumn:
+        d->z.resize(d->kind == Ri ? n : 0);
+        for(int i = 0; i < d->z.size(); i++)
+        {
+            //z = (1 + G) / (1 - G)
+            qreal a = 1 - ri[i].x();
+            qreal b = -ri[i].y();
+            qreal den = a*a + b*b;
+            qreal re = 1 + ri[i].x();
+            qreal im = ri[i].y();
+            d->z[i] = QPointF((re*a + im*b) / den, (im*a - re*b) / den);
+        }
+        break;
+    }
+    d->columns |= column;
+}
+
+const QVector<qreal> &Sweep::db() const
+{
+    static const QVector<qreal> empty;
+    if(!d) return empty;
+    materialize(DbColumn);
+    return d->db;
+}
+
+const QVector<qreal> &Sweep::vswr() const
+{
+    static const QVector<qreal> empty;
+    if(!d) return empty;
+    materialize(VswrColumn);
+    return d->vswr;
+}
+
+const QVector<qreal> &Sweep::phase() const
+{
+    static const QVector<qreal> empty;
+    if(!d) return empty;
+    materialize(PhaseColumn);
+    return d->phase;
+}
+
+const QVector<QPointF> &Sweep::z() const
+{
+    static const QVector<QPointF> empty;
+    if(!d) return empty;
+    materialize(ZColumn);
+    return d->z;
+}
+
+int Sweep::columns() const
+{
+    if(!d) return 0;
+    QMutexLocker lock(&d->lock);
+    return d->columns;
+}
+
+qreal *Sweep::freqData()
+{
+    Q_ASSERT(d && d->ref.load() == 1);
+    return d->freq.data();
+}
+
+qreal *Sweep::valueData()
+{
+    Q_ASSERT(d && d->ref.load() == 1);
+    return d->value.data();
+}
+
+QPointF *Sweep::riData()
+{
+    Q_ASSERT(d && d->ref.load() == 1);
+    return d->ri.data();
+}
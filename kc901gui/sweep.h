@@ -0,0 +1,109 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <QVector>
+#include <QPointF>
+#include <QAtomicInt>
+#include <QMutex>
+
+/// Shared, immutable result of one sweep
+/**
+Columns are kept as separate arrays: the frequency grid, a scalar column
+(VSWR or S21 dB, as sent by the instrument) and the complex reflection
+(RI sweeps). The parser fills a fresh sweep through the *Data()
+accessors, after that the sweep is only read. Copies share the same
+storage through an intrusive reference count, so display, Smith chart
+and analysis all hold the parsed arrays without copying them.
+
+Derived columns (dB, VSWR, phase, impedance) are computed on first use
+and cached with the sweep, so each is computed at most once per sweep
+and only when a view or an analysis asks for it. columns() tells which
+ones are materialized.
+
+Storage comes from a small pool: when the last handle goes away the
+columns are handed back with their capacity and reused by the next
+sweep, so continuous sweeping on a fixed grid allocates nothing.
+*/
+class Sweep
+{
+public:
+    enum Kind {
+        None = 0,
+        Vswr,
+        Ri,
+        S21
+    };
+
+    enum Column {
+        DbColumn = 0x1,
+        VswrColumn = 0x2,
+        PhaseColumn = 0x4,
+        ZColumn = 0x8
+    };
+
+    Sweep();
+    Sweep(const Sweep &other);
+    ~Sweep();
+    Sweep &operator=(const Sweep &other);
+
+    /// New sweep of points samples from the pool, columns of kind sized
+    static Sweep create(Kind kind, int points);
+    /// Like create(), but refills this storage without the pool while it is the single handle
+    void recreate(Kind kind, int points);
+
+    bool isNull() const { return d == 0; }
+    Kind kind() const { return d ? d->kind : None; }
+    int size() const { return d ? d->freq.size() : 0; }
+    /// Increases with every created sweep
+    quint64 serial() const { return d ? d->serial : 0; }
+
+    const QVector<qreal> &freq() const;
+    /// VSWR / S21 sweeps
+    const QVector<qreal> &value() const;
+    /// RI sweeps
+    const QVector<QPointF> &ri() const;
+
+    /// |S11| or |S21| in dB, return loss for VSWR sweeps
+    const QVector<qreal> &db() const;
+    /// VSWR of S11 sweeps
+    const QVector<qreal> &vswr() const;
+    /// Wrapped phase in degrees, RI sweeps
+    const QVector<qreal> &phase() const;
+    /// Impedance normalized to the reference, RI sweeps
+    const QVector<QPointF> &z() const;
+    /// Materialized derived columns, or of Column
+    int columns() const;
+
+    /// Write access for the parser, only while this is the single handle
+    qreal *freqData();
+    qreal *valueData();
+    QPointF *riData();
+
+private:
+    struct Data {
+        QAtomicInt ref;
+        Kind kind;
+        quint64 serial;
+        QVector<qreal> freq;
+        QVector<qreal> value;
+        QVector<QPointF> ri;
+
+        //derived, guarded by lock
+        QMutex lock;
+        int columns;
+        QVector<qreal> db;
+        QVector<qreal> vswr;
+        QVector<qreal> phase;
+        QVector<QPointF> z;
+    };
+
+    explicit Sweep(Data *data) : d(data) {}
+    void release();
+    void materialize(Column column) const;
+
+    Data *d;
+
+    friend class SweepPool;
+};
+
+#endif // SWEEP_H
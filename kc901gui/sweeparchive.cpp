@@ -0,0 +1,605 @@
+#include "sweeparchive.h"
+#include <QFile>
+#include <QDataStream>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <string.h>
+
+static const char Magic[8] = "KCARCH1";
+static const char IndexMagic[8] = "KCIDX1";
+static const int BlockSweeps = 64;
+static const int RecordHeader = 5;
+
+static quint64 toBits(qreal v)
+{
+    double d = v;
+    quint64 b;
+    memcpy(&b, &d, sizeof(b));
+    return b;
+}
+
+static qreal fromBits(quint64 b)
+{
+    double d;
+    memcpy(&d, &b, sizeof(d));
+    return d;
+}
+
+static void putBits(QByteArray &out, quint64 &acc, int &used, quint64 v, int n)
+//n low bits of v, most significant first
+{
+    if(n > 32)
+    {
+        putBits(out, acc, used, v >> 32, n - 32);
+        n = 32;
+    }
+    acc = (acc << n) | (v & ((Q_UINT64_C(1) << n) - 1));
+    used += n;
+    while(used >= 8)
+    {
+        used -= 8;
+        out.append(char(acc >> used));
+    }
+}
+
+// bit packed samples of a block
+struct BitReader {
+    const uchar *p, *end;
+    quint64 acc;
+    int avail;
+
+    quint64 get(int n)
+    {
+        if(n > 32)
+        {
+            quint64 high = get(n - 32);
+            return (high << 32) | get(32);
+        }
+        while(avail < n)
+        {
+            //past the end reads zeros, a damaged block decodes to garbage, not a crash
+            acc = (acc << 8) | (p < end ? *p++ : 0);
+            avail += 8;
+        }
+        avail -= n;
+        return (acc >> avail) & ((Q_UINT64_C(1) << n) - 1);
+    }
+};
+
+static void unpackSamples(const uchar *packed, const uchar *end, int count, int n, int cols, qreal *out)
+//count sweeps of cols columns of n samples, the inverse of append / flushBlock
+{
+    BitReader reader;
+    reader.p = packed;
+    reader.end = end;
+    reader.acc = 0;
+    reader.avail = 0;
+    int lead = 64, trail = 64;
+    int stride = cols * n;
+    for(int s = 0; s < count; s++)
+    {
+        for(int k = 0; k < stride; k++)
+        {
+            quint64 x = 0;
+            if(reader.get(1))
+            {
+                if(reader.get(1))
+                {
+                    lead = reader.get(5);
+                    int length = reader.get(6) + 1;
+                    trail = 64 - lead - length;
+                    x = reader.get(length) << trail;
+                }
+                else
+                    x = reader.get(64 - lead - trail) << trail;
+            }
+            //same reference as the encoder: the neighbour in the first sweep, read back from out
+            quint64 reference = s == 0 ? (k % n > 0 ? toBits(out[-1]) : 0) : toBits(out[-stride]);
+            *out++ = fromBits(x ^ reference);
+        }
+    }
+}
+
+SweepArchive::SweepArchive() :
+    file(0),
+    mapped(0),
+    mappedSize(0),
+    writing(false),
+    m_count(0),
+    m_rawBytes(0),
+    blockGrid(-1),
+    bitAcc(0),
+    bitCount(0),
+    windowLead(64),
+    windowTrail(64),
+    cachedBlock(-1)
+{
+}
+
+SweepArchive::~SweepArchive()
+{
+    close();
+}
+
+bool SweepArchive::create(const QString &fileName, QString *error)
+{
+    close();
+    file = new QFile(fileName);
+    if(!file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if(error) *error = file->errorString();
+        delete file;
+        file = 0;
+        return false;
+    }
+    file->write(Magic, sizeof(Magic));
+    writing = true;
+    return true;
+}
+
+int SweepArchive::gridFor(const Sweep &sweep, qreal cent, qreal span)
+//grid of a sweep, a new configuration is written before its first block
+{
+    const QVector<qreal> &freq = sweep.freq();
+    for(int g = grids.size() - 1; g >= 0; g--)
+    {
+        const Grid &grid = grids[g];
+        if(grid.kind == sweep.kind() && grid.freq.size() == freq.size() && grid.cent == cent
+                && grid.span == span && (freq.isEmpty() || (grid.freq.first() == freq.first()
+                                                             && grid.freq.last() == freq.last())))
+            return g;
+    }
+
+    Grid grid;
+    grid.offset = file->pos();
+    grid.id = grids.size();
+    grid.kind = sweep.kind();
+    grid.cent = cent;
+    grid.span = span;
+    grid.freq = freq;
+    QDataStream out(file);
+    out << quint8('G') << quint32(4 + 2 + 4 + 16 + 8 * freq.size());
+    out << grid.id << quint16(grid.kind) << quint32(freq.size()) << double(cent) << double(span);
+    for(int i = 0; i < freq.size(); i++)
+        out << double(freq[i]);
+    grids.append(grid);
+    return grids.size() - 1;
+}
+
+void SweepArchive::append(const Sweep &sweep, qreal cent, qreal span, qint64 timestamp)
+{
+    if(!writing || sweep.isNull()) return;
+    int g = gridFor(sweep, cent, span);
+    if(g != blockGrid || blockTimes.size() >= BlockSweeps)
+        flushBlock();
+    blockGrid = g;
+
+    bool first = blockTimes.isEmpty();
+    blockTimes.append(timestamp);
+    int n = sweep.size();
+    int cols = columns(grids[g]);
+    previous.resize(cols * n);
+    quint64 *prev = previous.data();
+    for(int c = 0; c < cols; c++)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            qreal v;
+            if(grids[g].kind == Sweep::Ri)
+                v = c == 0 ? sweep.ri()[i].x() : sweep.ri()[i].y();
+            else
+                v = sweep.value()[i];
+            quint64 b = toBits(v);
+            //against the previous sweep, the first one of a block against its neighbour
+            quint64 &slot = prev[c * n + i];
+            quint64 x = b ^ (first ? (i > 0 ? prev[c * n + i - 1] : 0) : slot);
+            slot = b;
+
+            if(x == 0)
+            {
+                putBits(bits, bitAcc, bitCount, 0, 1);
+                continue;
+            }
+            int lead = qMin<int>(qCountLeadingZeroBits(x), 31);
+            int trail = qCountTrailingZeroBits(x);
+            if(lead >= windowLead && trail >= windowTrail)
+            {
+                putBits(bits, bitAcc, bitCount, 2, 2);
+                putBits(bits, bitAcc, bitCount, x >> windowTrail, 64 - windowLead - windowTrail);
+                continue;
+            }
+            windowLead = lead;
+            windowTrail = trail;
+            int length = 64 - lead - trail;
+            putBits(bits, bitAcc, bitCount, 3, 2);
+            putBits(bits, bitAcc, bitCount, lead, 5);
+            putBits(bits, bitAcc, bitCount, length - 1, 6);
+            putBits(bits, bitAcc, bitCount, x >> trail, length);
+        }
+    }
+    m_count++;
+    m_rawBytes += 8 + 8 * (1 + cols) * n;
+}
+
+void SweepArchive::flushBlock()
+{
+    if(blockTimes.isEmpty()) return;
+    if(bitCount > 0)
+        bits.append(char(bitAcc << (8 - bitCount)));
+
+    Block block;
+    block.offset = file->pos();
+    block.grid = blockGrid;
+    block.first = m_count - blockTimes.size();
+    block.count = blockTimes.size();
+    block.firstTime = blockTimes.first();
+    block.lastTime = blockTimes.last();
+    blocks.append(block);
+
+    QDataStream out(file);
+    out << quint8('B') << quint32(4 + 2 + 8 * blockTimes.size() + bits.size());
+    out << quint32(grids[blockGrid].id) << quint16(blockTimes.size());
+    for(int i = 0; i < blockTimes.size(); i++)
+        out << blockTimes[i];
+    out.writeRawData(bits.constData(), bits.size());
+    //a crash loses at most the block being filled
+    file->flush();
+
+    blockTimes.resize(0);
+    bits.resize(0);
+    bitAcc = 0;
+    bitCount = 0;
+    windowLead = 64;
+    windowTrail = 64;
+}
+
+void SweepArchive::close()
+{
+    if(file && writing)
+    {
+        flushBlock();
+        qint64 indexOffset = file->pos();
+        QDataStream out(file);
+        out << quint8('I') << quint32(4 + 8 * grids.size() + 4 + 34 * blocks.size());
+        out << quint32(grids.size());
+        for(int g = 0; g < grids.size(); g++)
+            out << qint64(grids[g].offset);
+        out << quint32(blocks.size());
+        for(int b = 0; b < blocks.size(); b++)
+        {
+            const Block &block = blocks[b];
+            out << qint64(block.offset) << quint32(block.grid) << quint32(block.first) << quint16(block.count)
+                << block.firstTime << block.lastTime;
+        }
+        out << qint64(indexOffset);
+        out.writeRawData(IndexMagic, sizeof(IndexMagic));
+    }
+    if(file)
+    {
+        //closing the file unmaps it
+        mapped = 0;
+        mappedSize = 0;
+        file->close();
+        delete file;
+        file = 0;
+    }
+    writing = false;
+    grids.clear();
+    blocks.clear();
+    m_count = 0;
+    m_rawBytes = 0;
+    blockGrid = -1;
+    blockTimes.clear();
+    previous.clear();
+    bits.clear();
+    bitAcc = 0;
+    bitCount = 0;
+    windowLead = 64;
+    windowTrail = 64;
+    cachedBlock = -1;
+}
+
+qint64 SweepArchive::fileBytes() const
+{
+    return file ? file->size() : 0;
+}
+
+bool SweepArchive::open(const QString &fileName, QString *error)
+{
+    close();
+    file = new QFile(fileName);
+    if(!file->open(QIODevice::ReadOnly))
+    {
+        if(error) *error = file->errorString();
+        close();
+        return false;
+    }
+    char magic[sizeof(Magic)];
+    if(file->read(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, Magic, sizeof(Magic)) != 0)
+    {
+        if(error) *error = "not a sweep archive";
+        close();
+        return false;
+    }
+    //the index of a cleanly closed archive, else a scan of the records
+    if(!readIndex() && !readRecords(error))
+    {
+        close();
+        return false;
+    }
+    for(int b = 0; b < blocks.size(); b++)
+    {
+        const Grid &grid = grids[blocks[b].grid];
+        m_count = blocks[b].first + blocks[b].count;
+        m_rawBytes += blocks[b].count * (8 + 8 * (1 + columns(grid)) * grid.freq.size());
+    }
+    return true;
+}
+
+bool SweepArchive::readGrid(qint64 offset)
+{
+    file->seek(offset);
+    QDataStream in(file);
+    quint8 type;
+    quint32 length, id, points;
+    quint16 kind;
+    double cent, span;
+    in >> type >> length >> id >> kind >> points >> cent >> span;
+    if(in.status() != QDataStream::Ok || type != 'G' || id != quint32(grids.size())
+            || length != 4 + 2 + 4 + 16 + 8 * points)
+        return false;
+
+    Grid grid;
+    grid.offset = offset;
+    grid.id = id;
+    grid.kind = Sweep::Kind(kind);
+    grid.cent = cent;
+    grid.span = span;
+    grid.freq.resize(points);
+    for(quint32 i = 0; i < points; i++)
+    {
+        double f;
+        in >> f;
+        grid.freq[i] = f;
+    }
+    if(in.status() != QDataStream::Ok) return false;
+    grids.append(grid);
+    return true;
+}
+
+bool SweepArchive::readIndex()
+{
+    qint64 size = file->size();
+    if(size < qint64(sizeof(Magic)) + 16) return false;
+    file->seek(size - 16);
+    QDataStream in(file);
+    qint64 indexOffset;
+    char magic[sizeof(IndexMagic)];
+    in >> indexOffset;
+    if(in.readRawData(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, IndexMagic, sizeof(magic)) != 0
+            || indexOffset < qint64(sizeof(Magic)) || indexOffset >= size - 16)
+        return false;
+
+    file->seek(indexOffset);
+    quint8 type;
+    quint32 length, gridCount, blockCount;
+    in >> type >> length >> gridCount;
+    if(in.status() != QDataStream::Ok || type != 'I') return false;
+    QVector<qint64> gridOffsets(gridCount);
+    for(quint32 g = 0; g < gridCount; g++)
+        in >> gridOffsets[g];
+    in >> blockCount;
+    for(quint32 b = 0; b < blockCount && in.status() == QDataStream::Ok; b++)
+    {
+        Block block;
+        quint32 grid, first;
+        quint16 count;
+        in >> block.offset >> grid >> first >> count >> block.firstTime >> block.lastTime;
+        block.grid = grid;
+        block.first = first;
+        block.count = count;
+        blocks.append(block);
+    }
+    bool ok = in.status() == QDataStream::Ok;
+    for(quint32 g = 0; ok && g < gridCount; g++)
+        ok = readGrid(gridOffsets[g]);
+    for(int b = 0; ok && b < blocks.size(); b++)
+        ok = blocks[b].grid < grids.size();
+    if(!ok)
+    {
+        grids.clear();
+        blocks.clear();
+    }
+    return ok;
+}
+
+bool SweepArchive::readRecords(QString *error)
+//walk the record headers, a record cut short at the end is dropped
+{
+    qint64 size = file->size();
+    qint64 pos = sizeof(Magic);
+    int sweeps = 0;
+    while(pos + RecordHeader <= size)
+    {
+        file->seek(pos);
+        QDataStream in(file);
+        quint8 type;
+        quint32 length;
+        in >> type >> length;
+        qint64 next = pos + RecordHeader + length;
+        if(next > size) break;
+
+        if(type == 'G')
+        {
+            if(!readGrid(pos))
+            {
+                if(error) *error = QString("bad grid at %1").arg(pos);
+                return false;
+            }
+        }
+        else if(type == 'B')
+        {
+            quint32 grid;
+            quint16 count;
+            in >> grid >> count;
+            if(count == 0 || grid >= quint32(grids.size())) break;
+            Block block;
+            block.offset = pos;
+            block.grid = grid;
+            block.first = sweeps;
+            block.count = count;
+            in >> block.firstTime;
+            file->seek(pos + RecordHeader + 4 + 2 + 8 * (count - 1));
+            in >> block.lastTime;
+            blocks.append(block);
+            sweeps += count;
+        }
+        else if(type != 'I')
+            break;
+        pos = next;
+    }
+    return true;
+}
+
+int SweepArchive::blockOf(int index) const
+{
+    int lo = 0, hi = blocks.size() - 1;
+    while(lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if(blocks[mid].first <= index) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+bool SweepArchive::decodeBlock(int b)
+{
+    if(b == cachedBlock) return true;
+    const Block &block = blocks[b];
+    file->seek(block.offset);
+    QDataStream in(file);
+    quint8 type;
+    quint32 length, gridId;
+    quint16 count;
+    in >> type >> length >> gridId >> count;
+    if(in.status() != QDataStream::Ok || int(gridId) != block.grid) return false;
+    cacheTimes.resize(count);
+    for(int i = 0; i < count; i++)
+        in >> cacheTimes[i];
+    QByteArray packed = file->read(length - 4 - 2 - 8 * count);
+
+    const Grid &grid = grids[gridId];
+    int n = grid.freq.size();
+    cache.resize(count * columns(grid) * n);
+    const uchar *p = reinterpret_cast<const uchar *>(packed.constData());
+    unpackSamples(p, p + packed.size(), count, n, columns(grid), cache.data());
+    cachedBlock = b;
+    return true;
+}
+
+bool SweepArchive::map()
+{
+    if(!file || writing) return false;
+    if(!mapped)
+    {
+        mappedSize = file->size();
+        mapped = file->map(0, mappedSize);
+    }
+    return mapped != 0;
+}
+
+bool SweepArchive::readBlock(int b, QVector<Sweep> *sweeps, QVector<qint64> *times, QVector<qreal> *samples) const
+//straight from the mapping, no file position or cache is touched
+{
+    if(!mapped || b < 0 || b >= blocks.size()) return false;
+    const Block &block = blocks[b];
+    const uchar *p = mapped + block.offset;
+    const uchar *end = mapped + mappedSize;
+    if(end - p < RecordHeader + 6) return false;
+    quint32 length = qFromBigEndian<quint32>(p + 1);
+    quint32 gridId = qFromBigEndian<quint32>(p + RecordHeader);
+    int count = qFromBigEndian<quint16>(p + RecordHeader + 4);
+    const uchar *packed = p + RecordHeader + 6 + 8 * count;
+    const uchar *packedEnd = p + RecordHeader + length;
+    if(p[0] != 'B' || int(gridId) != block.grid || packedEnd > end || packed > packedEnd) return false;
+
+    const Grid &grid = grids[gridId];
+    int n = grid.freq.size();
+    int cols = columns(grid);
+    samples->resize(count * cols * n);
+    unpackSamples(packed, packedEnd, count, n, cols, samples->data());
+
+    //the sweeps of the caller are refilled, not taken from the pool again
+    sweeps->resize(count);
+    times->resize(count);
+    for(int s = 0; s < count; s++)
+    {
+        (*times)[s] = qFromBigEndian<qint64>(p + RecordHeader + 6 + 8 * s);
+        Sweep &sweep = (*sweeps)[s];
+        sweep.recreate(grid.kind, n);
+        memcpy(sweep.freqData(), grid.freq.constData(), n * sizeof(qreal));
+        const qreal *column = samples->constData() + s * cols * n;
+        if(grid.kind == Sweep::Ri)
+        {
+            QPointF *ri = sweep.riData();
+            for(int i = 0; i < n; i++)
+                ri[i] = QPointF(column[i], column[n + i]);
+        }
+        else
+            memcpy(sweep.valueData(), column, n * sizeof(qreal));
+    }
+    return true;
+}
+
+Sweep SweepArchive::read(int index, qint64 *timestamp)
+{
+    if(writing || index < 0 || index >= m_count) return Sweep();
+    int b = blockOf(index);
+    if(!decodeBlock(b)) return Sweep();
+
+    const Grid &grid = grids[blocks[b].grid];
+    int n = grid.freq.size();
+    int cols = columns(grid);
+    int s = index - blocks[b].first;
+    if(timestamp) *timestamp = cacheTimes[s];
+
+    Sweep sweep = Sweep::create(grid.kind, n);
+    memcpy(sweep.freqData(), grid.freq.constData(), n * sizeof(qreal));
+    const qreal *column = cache.constData() + s * cols * n;
+    if(grid.kind == Sweep::Ri)
+    {
+        QPointF *ri = sweep.riData();
+        for(int i = 0; i < n; i++)
+            ri[i] = QPointF(column[i], column[n + i]);
+    }
+    else
+        memcpy(sweep.valueData(), column, n * sizeof(qreal));
+    return sweep;
+}
+
+qint64 SweepArchive::firstTime() const
+{
+    return blocks.isEmpty() ? 0 : blocks.first().firstTime;
+}
+
+qint64 SweepArchive::lastTime() const
+{
+    return blocks.isEmpty() ? 0 : blocks.last().lastTime;
+}
+
+int SweepArchive::find(qint64 timestamp)
+{
+    //first block that ends at or after timestamp, then the sweep inside it
+    int lo = 0, hi = blocks.size();
+    while(lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if(blocks[mid].lastTime < timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo >= blocks.size() || writing || !decodeBlock(lo)) return m_count;
+    int s = 0;
+    while(s < cacheTimes.size() - 1 && cacheTimes[s] < timestamp) s++;
+    return blocks[lo].first + s;
+}
@@ -0,0 +1,129 @@
+#ifndef SWEEPARCHIVE_H
+#define SWEEPARCHIVE_H
+
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+#include "sweep.h"
+
+class QFile;
+
+/// Compressed columnar recording of sweeps for long archives
+/**
+The frequency grid is stored once per (kind, cent, span, points)
+configuration. Sweeps on one grid are grouped into blocks of up to 64,
+every block can be decoded on its own. Inside a block each sample is
+XORed with the same sample of the previous sweep (the first sweep with
+its neighbour) and the XOR is bit packed as in Gorilla: a 0 bit for an
+unchanged value, otherwise the meaningful bits within a leading /
+trailing zero window. Sweeps that barely change cost a few bits per
+sample, and decoding is a shift and an XOR per sample.
+
+File layout, QDataStream (big endian) integers:
+
+    "KCARCH1\0"
+    records: quint8 type, quint32 length, payload
+      'G' grid:  quint32 id, quint16 kind, quint32 points,
+                 double cent, double span, double freq[points]
+      'B' block: quint32 grid, quint16 count, qint64 time[count] (ms),
+                 bit packed samples (value, or re then im per sweep)
+      'I' index: quint32 grids, quint64 offset[grids],
+                 quint32 blocks, per block quint64 offset, quint32 grid,
+                 quint32 first sweep, quint16 count, qint64 first and
+                 last time
+    trailer: quint64 index offset, "KCIDX1\0\0"
+
+The index is written on close. An archive cut short by a crash is
+opened by scanning the record headers instead, losing at most the block
+that was being filled.
+
+Batch readers map the archive and decode whole blocks with readBlock,
+which only reads the mapping and the index, so any number of threads
+can decode blocks at once without a shared lock.
+*/
+class SweepArchive
+{
+public:
+    SweepArchive();
+    ~SweepArchive();
+
+    // writing
+    bool create(const QString &fileName, QString *error = 0);
+    void append(const Sweep &sweep, qreal cent, qreal span, qint64 timestamp);
+    bool isWriting() const { return writing; }
+
+    // reading
+    bool open(const QString &fileName, QString *error = 0);
+    int count() const { return m_count; }
+    qint64 firstTime() const;
+    qint64 lastTime() const;
+    /// First sweep at or after timestamp, count() past the end
+    int find(qint64 timestamp);
+    /// Sweep number index, decodes its block unless it is the cached one
+    Sweep read(int index, qint64 *timestamp = 0);
+
+    void close();
+
+    /// Maps the open archive for readBlock
+    bool map();
+    int blockCount() const { return blocks.size(); }
+    int blockFirst(int block) const { return blocks[block].first; }
+    /// All sweeps of a block from the mapped file, safe to call from several threads
+    /// with buffers of their own: kept between blocks, they are refilled without the Sweep pool
+    bool readBlock(int block, QVector<Sweep> *sweeps, QVector<qint64> *times, QVector<qreal> *samples) const;
+
+    /// Bytes the sweeps would take as raw doubles, and the file size
+    qint64 rawBytes() const { return m_rawBytes; }
+    qint64 fileBytes() const;
+
+private:
+    struct Grid {
+        qint64 offset;
+        quint32 id;
+        Sweep::Kind kind;
+        qreal cent, span;
+        QVector<qreal> freq;
+    };
+    struct Block {
+        qint64 offset;
+        int grid;
+        int first;
+        int count;
+        qint64 firstTime, lastTime;
+    };
+
+    int columns(const Grid &grid) const { return grid.kind == Sweep::Ri ? 2 : 1; }
+    int gridFor(const Sweep &sweep, qreal cent, qreal span);
+    void flushBlock();
+    bool readRecords(QString *error);
+    bool readIndex();
+    bool readGrid(qint64 offset);
+    bool decodeBlock(int block);
+    int blockOf(int index) const;
+
+    QFile *file;
+    const uchar *mapped;
+    // length of the mapping, readBlock never asks the file
+    qint64 mappedSize;
+    bool writing;
+    QVector<Grid> grids;
+    QVector<Block> blocks;
+    int m_count;
+    qint64 m_rawBytes;
+
+    // block being written
+    int blockGrid;
+    QVector<qint64> blockTimes;
+    QVector<quint64> previous;
+    QByteArray bits;
+    quint64 bitAcc;
+    int bitCount;
+    int windowLead, windowTrail;
+
+    // last decoded block
+    int cachedBlock;
+    QVector<qreal> cache;
+    QVector<qint64> cacheTimes;
+};
+
+#endif // SWEEPARCHIVE_H
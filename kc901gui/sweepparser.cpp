@@ -0,0 +1,178 @@
+#include "sweepparser.h"
+#include <string.h>
+#include <math.h>
+
+static inline bool separator(char c)
+{
+    return c == '$' || c == '\n' || c == '\r';
+}
+
+static bool nextLine(const char *&p, const char *end, const char **begin, const char **stop)
+//next non empty line, false at the end of the data
+{
+    while(p < end && separator(*p)) p++;
+    if(p >= end) return false;
+    *begin = p;
+    while(p < end && !separator(*p)) p++;
+    *stop = p;
+    return true;
+}
+
+static bool equals(const char *begin, const char *stop, const char *text)
+{
+    int n = strlen(text);
+    return stop - begin == n && memcmp(begin, text, n) == 0;
+}
+
+SweepParser::Reply SweepParser::type(const QByteArray &data)
+{
+    if(!data.contains("$end")) return Incomplete;
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    const char *begin, *stop;
+    if(!nextLine(p, end, &begin, &stop)) return OtherReply;
+
+    //the reply has to end with the end line
+    const char *last = end;
+    while(last > p && separator(last[-1])) last--;
+    if(last - p < 3 || memcmp(last - 3, "end", 3) != 0
+            || (last - 3 > p && !separator(last[-4])))
+        return OtherReply;
+
+    if(equals(begin, stop, "start,s11,vswr")) return VswrReply;
+    if(equals(begin, stop, "start,s11,ri")) return RiReply;
+    if(equals(begin, stop, "start,s21")) return S21Reply;
+    if(equals(begin, stop, "start,id")) return IdReply;
+    return OtherReply;
+}
+
+const char *SweepParser::header(Reply reply)
+{
+    switch(reply)
+    {
+    case VswrReply: return "start,s11,vswr";
+    case RiReply: return "start,s11,ri";
+    case S21Reply: return "start,s21";
+    case IdReply: return "start,id";
+    default: return "";
+    }
+}
+
+qreal SweepParser::number(const char *&p, const char *end, bool *ok)
+{
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    while(p < end && *p == ' ') p++;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    //up to 19 significant digits in the mantissa, the rest in the exponent
+    quint64 mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for(; p < end && *p >= '0' && *p <= '9'; p++, any = true)
+    {
+        if(digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa) digits++;
+        }
+        else
+            exponent++;
+    }
+    if(p < end && *p == '.')
+    {
+        for(p++; p < end && *p >= '0' && *p <= '9'; p++, any = true)
+        {
+            if(digits >= 19) continue;
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa) digits++;
+            exponent--;
+        }
+    }
+    if(any && p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool expNegative = false;
+        if(q < end && (*q == '-' || *q == '+')) expNegative = *q++ == '-';
+        if(q < end && *q >= '0' && *q <= '9')
+        {
+            int e = 0;
+            for(; q < end && *q >= '0' && *q <= '9'; q++)
+                if(e < 10000) e = e * 10 + (*q - '0');
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+    while(p < end && *p == ' ') p++;
+    if(ok) *ok = any;
+    if(!any) return 0;
+
+    //exact for up to 15 digits and |exponent| <= 22
+    double value = double(mantissa);
+    if(exponent < 0)
+        value = exponent >= -22 ? value / powers[-exponent] : value * pow(10.0, exponent);
+    else if(exponent > 0)
+        value = exponent <= 22 ? value * powers[exponent] : value * pow(10.0, exponent);
+    return negative ? -value : value;
+}
+
+Sweep SweepParser::parse(const QByteArray &data)
+{
+    Reply reply = type(data);
+    Sweep::Kind kind;
+    int fields;
+    switch(reply)
+    {
+    case VswrReply: kind = Sweep::Vswr; fields = 2; break;
+    case RiReply: kind = Sweep::Ri; fields = 3; break;
+    case S21Reply: kind = Sweep::S21; fields = 3; break;
+    default: return Sweep();
+    }
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    const char *begin, *stop;
+    nextLine(p, end, &begin, &stop);
+    const char *first = p;
+
+    //lines between the header and the end line
+    int lines = 0;
+    while(nextLine(p, end, &begin, &stop)) lines++;
+    int points = qMax(0, lines - 1);
+
+    Sweep sweep = Sweep::create(kind, points);
+    qreal *f = sweep.freqData();
+    qreal *v = kind == Sweep::Ri ? 0 : sweep.valueData();
+    QPointF *ri = kind == Sweep::Ri ? sweep.riData() : 0;
+
+    p = first;
+    for(int i = 0; i < points && nextLine(p, end, &begin, &stop); i++)
+    {
+        //a field that is not a plain number reads as 0, a short line as all 0
+        qreal x[3] = { 0, 0, 0 };
+        int n = 0;
+        const char *q = begin;
+        while(q <= stop && n < 3)
+        {
+            const char *field = q;
+            const char *fieldEnd = (const char *)memchr(field, ',', stop - field);
+            if(!fieldEnd) fieldEnd = stop;
+            bool ok;
+            x[n] = number(field, fieldEnd, &ok);
+            if(!ok || field != fieldEnd) x[n] = 0;
+            n++;
+            q = fieldEnd + 1;
+        }
+        if(n < fields) x[0] = x[1] = x[2] = 0;
+
+        f[i] = x[0];
+        if(v) v[i] = x[1];
+        if(ri) ri[i] = QPointF(x[1], x[2]);
+    }
+    return sweep;
+}
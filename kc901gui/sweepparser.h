@@ -0,0 +1,41 @@
+#ifndef SWEEPPARSER_H
+#define SWEEPPARSER_H
+
+#include <QByteArray>
+#include "sweep.h"
+
+/// Parses instrument replies straight from the receive buffer
+/**
+A reply is a header line ("start,s11,vswr", "start,s11,ri", "start,s21",
+"start,id"), one line per sample and "end", lines separated by '$' or
+newlines. The parser walks the raw bytes twice, once to count the
+samples and once to convert them into a pooled Sweep, without building
+strings or lists: with the pool warm a sweep costs no heap allocation.
+Numbers are read with a locale independent decimal parser.
+*/
+class SweepParser
+{
+public:
+    enum Reply {
+        Incomplete = 0,
+        VswrReply,
+        RiReply,
+        S21Reply,
+        IdReply,
+        OtherReply
+    };
+
+    /// Type of a complete reply, Incomplete until data holds "$end"
+    static Reply type(const QByteArray &data);
+
+    /// Sweep of a VSWR / RI / S21 reply, a null sweep for anything else
+    static Sweep parse(const QByteArray &data);
+
+    /// Header line of a reply type
+    static const char *header(Reply reply);
+
+    /// Decimal number at p, advances p past it
+    static qreal number(const char *&p, const char *end, bool *ok);
+};
+
+#endif // SWEEPPARSER_H
@@ -0,0 +1,189 @@
+#ifndef SWEEPRING_H
+#define SWEEPRING_H
+
+/* Shared memory sweep ring: layout and a header only reader
+ *
+ * The GUI publishes every finished sweep into a POSIX shared memory
+ * object (default "/kc901gui_sweeps"). Plain C, no Qt, so an analysis
+ * process only needs this file (gcc / clang, POSIX).
+ *
+ *   KcRingHeader                      64 bytes
+ *   slot 0 .. slotCount-1, slotSize each:
+ *       KcSlotHeader                  64 bytes
+ *       double freq[maxPoints]
+ *       double re[maxPoints]          VSWR / S21 sweeps: the value
+ *       double im[maxPoints]          VSWR / S21 sweeps: 0
+ *
+ * Sweep n (1 based, ring->published is the latest) sits in slot
+ * (n - 1) % slotCount. Every slot is a seqlock: seq is odd while the writer
+ * is inside, a reader takes the pointers from kc_ring_begin(), uses the
+ * arrays in place and then asks kc_ring_end() whether the slot was
+ * overwritten meanwhile (a torn read). Nothing is copied.
+ *
+ *     KcRing ring;
+ *     KcSweepView view;
+ *     if(kc_ring_open(&ring, "/kc901gui_sweeps") == 0)
+ *     {
+ *         uint64_t n = kc_ring_published(&ring);
+ *         if(n > 0 && kc_ring_begin(&ring, n, &view))
+ *         {
+ *             ... view.freq[i], view.re[i], view.im[i] ...
+ *             if(!kc_ring_end(&view)) ... torn, drop the results ...
+ *         }
+ *         kc_ring_close(&ring);
+ *     }
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define KC_RING_MAGIC "KCRING1"
+#define KC_RING_VERSION 1
+#define KC_RING_NAME "/kc901gui_sweeps"
+
+typedef struct KcRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t maxPoints;
+    uint32_t slotSize;       /* bytes, header and the three columns */
+    uint64_t published;      /* sweeps written so far */
+    char reserved[32];
+} KcRingHeader;
+
+typedef struct KcSlotHeader {
+    uint64_t seq;            /* odd while being written */
+    uint64_t number;         /* sweep number held by the slot */
+    uint32_t kind;           /* 1 vswr, 2 ri, 3 s21 */
+    uint32_t points;
+    double cent, span;       /* Hz, as requested */
+    int64_t timestamp;       /* ms since the epoch */
+    char reserved[16];
+} KcSlotHeader;
+
+typedef struct {
+    KcRingHeader *ring;
+    size_t size;
+} KcRing;
+
+typedef struct {
+    const KcSlotHeader *slot;
+    uint64_t seq;
+    uint64_t number;
+    uint32_t kind;
+    uint32_t points;
+    double cent, span;
+    int64_t timestamp;
+    const double *freq, *re, *im;
+} KcSweepView;
+
+static inline size_t kc_ring_size(uint32_t slotCount, uint32_t maxPoints)
+{
+    return sizeof(KcRingHeader) + (size_t)slotCount * (sizeof(KcSlotHeader) + 3 * sizeof(double) * (size_t)maxPoints);
+}
+
+static inline KcSlotHeader *kc_ring_slot(KcRingHeader *ring, uint64_t number)
+{
+    return (KcSlotHeader *)((char *)ring + sizeof(KcRingHeader)
+                            + (size_t)((number - 1) % ring->slotCount) * ring->slotSize);
+}
+
+static inline double *kc_slot_column(KcRingHeader *ring, KcSlotHeader *slot, int column)
+{
+    return (double *)((char *)slot + sizeof(KcSlotHeader)) + (size_t)column * ring->maxPoints;
+}
+
+/* writer side, used by the GUI */
+static inline void kc_slot_write_begin(KcSlotHeader *slot)
+{
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+    /* the odd seq is visible before any data store */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void kc_slot_write_end(KcRingHeader *ring, KcSlotHeader *slot)
+{
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->published, slot->number, __ATOMIC_RELEASE);
+}
+
+/* reader side */
+static inline int kc_ring_open(KcRing *r, const char *name)
+{
+    struct stat st;
+    int fd = shm_open(name, O_RDONLY, 0);
+    r->ring = 0;
+    r->size = 0;
+    if(fd < 0) return -1;
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(KcRingHeader))
+    {
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) return -1;
+
+    KcRingHeader *ring = (KcRingHeader *)p;
+    const char magic[8] = KC_RING_MAGIC;
+    int i;
+    for(i = 0; i < 8; i++)
+        if(ring->magic[i] != magic[i]) break;
+    if(i < 8 || ring->version != KC_RING_VERSION || ring->slotCount == 0
+            || kc_ring_size(ring->slotCount, ring->maxPoints) > (size_t)st.st_size)
+    {
+        munmap(p, st.st_size);
+        return -1;
+    }
+    r->ring = ring;
+    r->size = st.st_size;
+    return 0;
+}
+
+static inline void kc_ring_close(KcRing *r)
+{
+    if(r->ring) munmap(r->ring, r->size);
+    r->ring = 0;
+    r->size = 0;
+}
+
+/* number of the latest complete sweep, 0 before the first */
+static inline uint64_t kc_ring_published(const KcRing *r)
+{
+    return __atomic_load_n(&r->ring->published, __ATOMIC_ACQUIRE);
+}
+
+/* 1 and the view of sweep number if its slot still holds it, else 0 */
+static inline int kc_ring_begin(const KcRing *r, uint64_t number, KcSweepView *view)
+{
+    if(number == 0) return 0;
+    KcSlotHeader *slot = kc_ring_slot(r->ring, number);
+    uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if(seq & 1) return 0;
+    view->slot = slot;
+    view->seq = seq;
+    view->number = slot->number;
+    view->kind = slot->kind;
+    view->points = slot->points;
+    view->cent = slot->cent;
+    view->span = slot->span;
+    view->timestamp = slot->timestamp;
+    view->freq = kc_slot_column(r->ring, slot, 0);
+    view->re = kc_slot_column(r->ring, slot, 1);
+    view->im = kc_slot_column(r->ring, slot, 2);
+    if(view->number != number || view->points > r->ring->maxPoints) return 0;
+    return 1;
+}
+
+/* 1 if nothing read through view was overwritten since kc_ring_begin */
+static inline int kc_ring_end(const KcSweepView *view)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&view->slot->seq, __ATOMIC_RELAXED) == view->seq;
+}
+
+#endif /* SWEEPRING_H */
@@ -0,0 +1,35 @@
+#include "sweepseriesdata.h"
+#include <string.h>
+
+SweepSeriesData::SweepSeriesData(const Sweep &sweep, const QVector<qreal> &y)
+{
+    setSamples(sweep, y);
+}
+
+void SweepSeriesData::setSamples(const Sweep &sweep, const QVector<qreal> &y)
+{
+    //copy into the own buffer, it keeps its capacity from sweep to sweep
+    m_y.resize(y.size());
+    if(!y.isEmpty())
+        memcpy(m_y.data(), y.constData(), y.size() * sizeof(qreal));
+    m_sweep = sweep;
+    d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+}
+
+size_t SweepSeriesData::size() const
+{
+    return qMin(m_sweep.size(), m_y.size());
+}
+
+QPointF SweepSeriesData::sample(size_t i) const
+{
+    return QPointF(m_sweep.freq().at(i), m_y.at(i));
+}
+
+QRectF SweepSeriesData::boundingRect() const
+{
+    //computed once, the data never changes
+    if(d_boundingRect.width() < 0.0)
+        d_boundingRect = qwtBoundingRect(*this);
+    return d_boundingRect;
+}
@@ -0,0 +1,32 @@
+#ifndef SWEEPSERIESDATA_H
+#define SWEEPSERIESDATA_H
+
+#include <QVector>
+#include "qwt_series_data.h"
+#include "sweep.h"
+
+/// Curve data reading x from the frequency column of a shared sweep
+/**
+Replaces QwtPointArrayData for the sweep curves: the curve keeps a
+handle on the sweep and copies the y values into its own buffer. The
+y values mostly live in the reused buffers of the trace processors,
+sharing them would make the next sweep detach them.
+*/
+class SweepSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    SweepSeriesData(const Sweep &sweep, const QVector<qreal> &y);
+
+    /// Point the data at the next sweep, the object is kept by the curve
+    void setSamples(const Sweep &sweep, const QVector<qreal> &y);
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    Sweep m_sweep;
+    QVector<qreal> m_y;
+};
+
+#endif // SWEEPSERIESDATA_H
@@ -0,0 +1,119 @@
+#include "tdigest.h"
+#include <qnumeric.h>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+TDigest::TDigest(qreal compression) :
+    m_compression(qMax(compression, qreal(10))),
+    m_count(0),
+    m_min(0),
+    m_max(0)
+{
+}
+
+void TDigest::clear()
+{
+    m_count = 0;
+    //keeps the buffers, a cleared digest is refilled without allocating
+    centroids.resize(0);
+    merged.resize(0);
+    buffer.resize(0);
+}
+
+void TDigest::add(qreal x)
+{
+    if(qIsNaN(x)) return;
+    if(m_count == 0 || x < m_min) m_min = x;
+    if(m_count == 0 || x > m_max) m_max = x;
+    m_count++;
+    //the buffers are allocated once, a full one is merged
+    if(buffer.capacity() == 0)
+    {
+        buffer.reserve(int(4 * m_compression));
+        centroids.reserve(int(m_compression) + 2);
+        merged.reserve(int(m_compression) + 2);
+    }
+    buffer.append(x);
+    if(buffer.size() >= int(4 * m_compression))
+        compress();
+}
+
+qreal TDigest::limit(qreal q) const
+//quantile one unit of k1(q) = compression / (2 pi) asin(2q - 1) above q
+{
+    qreal scale = m_compression / (2 * M_PI);
+    qreal k = scale * asin(qBound(qreal(-1), 2 * q - 1, qreal(1))) + 1;
+    if(k >= m_compression / 4) return 1;
+    return (sin(k / scale) + 1) / 2;
+}
+
+void TDigest::compress()
+{
+    if(buffer.isEmpty()) return;
+    //the centroids are sorted already, only the buffer needs sorting
+    std::sort(buffer.begin(), buffer.end());
+    //merged into the spare list, the two lists swap and keep their capacity
+    QVector<Centroid> &old = centroids;
+    merged.resize(0);
+
+    //greedy merge from the left while the centroid spans at most one unit of k1
+    int c = 0, b = 0;
+    Centroid current = { 0, 0 };
+    qreal before = 0;
+    qreal end = limit(0);
+    while(c < old.size() || b < buffer.size())
+    {
+        Centroid next;
+        if(b >= buffer.size() || (c < old.size() && old[c].mean < buffer[b]))
+            next = old[c++];
+        else
+        {
+            next.mean = buffer[b++];
+            next.weight = 1;
+        }
+        if(current.weight > 0 && before + current.weight + next.weight <= end * m_count)
+        {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+            continue;
+        }
+        if(current.weight > 0)
+        {
+            merged.append(current);
+            before += current.weight;
+            end = limit(before / m_count);
+        }
+        current = next;
+    }
+    merged.append(current);
+    centroids.swap(merged);
+    buffer.resize(0);
+}
+
+qreal TDigest::quantile(qreal q)
+{
+    if(m_count == 0) return std::numeric_limits<qreal>::quiet_NaN();
+    compress();
+    int n = centroids.size();
+    if(n == 1) return centroids[0].mean;
+
+    //linear between the centroid midpoints, the extremes at the ends
+    qreal target = qBound(qreal(0), q, qreal(1)) * m_count;
+    qreal cumulative = 0;
+    for(int i = 0; i < n; i++)
+    {
+        qreal mid = cumulative + centroids[i].weight / 2;
+        if(target < mid)
+        {
+            if(i == 0)
+                return m_min + (centroids[0].mean - m_min) * target / mid;
+            qreal previous = cumulative - centroids[i - 1].weight / 2;
+            return centroids[i - 1].mean
+                    + (centroids[i].mean - centroids[i - 1].mean) * (target - previous) / (mid - previous);
+        }
+        cumulative += centroids[i].weight;
+    }
+    qreal last = m_count - centroids[n - 1].weight / 2;
+    return centroids[n - 1].mean + (m_max - centroids[n - 1].mean) * (target - last) / (m_count - last);
+}
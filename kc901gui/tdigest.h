@@ -0,0 +1,52 @@
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+#include <QVector>
+
+/// Streaming quantile sketch of bounded size (merging t-digest)
+/**
+Values are buffered and merged into weighted centroids sorted by mean.
+Centroid sizes follow the k1 scale k(q) = compression / (2 pi) asin(2q - 1):
+a centroid spans at most one unit of k, so there are at most about
+compression centroids whatever the number of values, and they are small
+near the tails, which keeps p1 and p99 as accurate as the median.
+Adding a value appends it to the buffer, and a full buffer costs a sort
+of the buffer and one pass over the centroids, into a second list that
+is swapped with the first. A digest allocates its buffers with the
+first value and then keeps them.
+*/
+class TDigest
+{
+public:
+    explicit TDigest(qreal compression = 100);
+
+    void add(qreal x);
+    void clear();
+    quint64 count() const { return m_count; }
+
+    /// Quantile q in [0, 1], NaN when empty
+    qreal quantile(qreal q);
+    /// Folds the buffer into the centroids, quantile() does it when needed
+    void compress();
+    /// Centroids after the last compress(), at most about compression
+    int centroidCount() const { return centroids.size(); }
+
+private:
+    qreal limit(qreal q) const;
+
+    struct Centroid {
+        qreal mean;
+        qreal weight;
+        bool operator<(const Centroid &other) const { return mean < other.mean; }
+    };
+
+    qreal m_compression;
+    quint64 m_count;
+    qreal m_min, m_max;
+    QVector<Centroid> centroids;
+    // merge target of compress(), swapped with centroids
+    QVector<Centroid> merged;
+    QVector<qreal> buffer;
+};
+
+#endif // TDIGEST_H
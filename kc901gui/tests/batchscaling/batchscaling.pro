@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Sweeps per second of the batch analysis against the thread count
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_batchscaling
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_batchscaling.cpp \
+    ../../sweep.cpp \
+    ../../sweeparchive.cpp \
+    ../../limitmask.cpp \
+    ../../kpiextractor.cpp \
+    ../../batchanalysis.cpp
+
+HEADERS += ../../sweep.h \
+    ../../sweeparchive.h \
+    ../../limitmask.h \
+    ../../kpiextractor.h \
+    ../../batchanalysis.h
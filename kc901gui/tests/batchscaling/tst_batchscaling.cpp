@@ -0,0 +1,118 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <math.h>
+#include "sweep.h"
+#include "sweeparchive.h"
+#include "batchanalysis.h"
+
+static const int Sweeps = 16384;
+static const int Points = 401;
+
+/// Runs the batch analysis of one generated archive on 1, 2, 4, ... threads
+/**
+Prints sweeps/s and the speedup over one thread for every count up to
+twice the cores, run it on the machine whose scaling is of interest.
+The reports must not depend on the thread count.
+*/
+class TestBatchScaling : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void scaling_data();
+    void scaling();
+
+private:
+    QString run(int threads, qint64 *elapsed);
+
+    QTemporaryDir dir;
+    QString archive, limits;
+    QString reference;
+    qreal single;
+};
+
+void TestBatchScaling::initTestCase()
+//resonators wandering around 150 MHz, on one grid like a production run
+{
+    QVERIFY(dir.isValid());
+    archive = dir.path() + "/batch.kca";
+    limits = dir.path() + "/batch.lim";
+    SweepArchive writer;
+    QString error;
+    QVERIFY2(writer.create(archive, &error), qPrintable(error));
+    for(int s = 0; s < Sweeps; s++)
+    {
+        Sweep sweep = Sweep::create(Sweep::Ri, Points);
+        qreal *freq = sweep.freqData();
+        QPointF *ri = sweep.riData();
+        qreal f0 = 150e6 + 2e6 * sin(s * 0.37);
+        for(int i = 0; i < Points; i++)
+        {
+            freq[i] = 100e6 + 100e6 * i / (Points - 1);
+            qreal x = (freq[i] - f0) / 5e6;
+            qreal mag = 0.05 + 0.9 * x * x / (1 + x * x);
+            qreal phase = -2 * M_PI * freq[i] * 2e-9;
+            ri[i] = QPointF(mag * cos(phase), mag * sin(phase));
+        }
+        writer.append(sweep, 150e6, 100e6, qint64(s) * 100);
+    }
+    writer.close();
+
+    QFile mask(limits);
+    QVERIFY(mask.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream(&mask) << "unit db\nupper 145e6 -10 155e6 -10\n";
+    single = 0;
+}
+
+void TestBatchScaling::scaling_data()
+{
+    QTest::addColumn<int>("threads");
+    int most = 2 * QThread::idealThreadCount();
+    for(int t = 1; t <= most; t *= 2)
+        QTest::newRow(qPrintable(QString("%1 threads").arg(t))) << t;
+}
+
+QString TestBatchScaling::run(int threads, qint64 *elapsed)
+//report without its first line, which has the timing
+{
+    BatchAnalysis::Options options;
+    options.archive = archive;
+    options.limits = limits;
+    options.threads = threads;
+    options.bins = 20;
+    BatchAnalysis analysis;
+    QString error;
+    QElapsedTimer timer;
+    timer.start();
+    if(!analysis.run(options, &error)) return error;
+    *elapsed = timer.nsecsElapsed();
+    QString text;
+    QTextStream out(&text);
+    analysis.report(out);
+    return text.mid(text.indexOf('\n') + 1);
+}
+
+void TestBatchScaling::scaling()
+{
+    QFETCH(int, threads);
+    qint64 elapsed = 0;
+    QString report = run(threads, &elapsed);
+    QVERIFY(elapsed > 0);
+    qreal rate = Sweeps * 1e9 / elapsed;
+    if(threads == 1)
+    {
+        single = rate;
+        reference = report;
+    }
+    qDebug("%2d threads: %8.0f sweeps/s, speedup %.2f", threads, rate, single > 0 ? rate / single : 0.0);
+    QCOMPARE(report, reference);
+}
+
+QTEST_GUILESS_MAIN(TestBatchScaling)
+
+#include "tst_batchscaling.moc"
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Score and shift estimate of the golden unit comparison
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_goldenscore
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_goldenscore.cpp \
+    ../../sweep.cpp \
+    ../../traceresampler.cpp \
+    ../../goldenscore.cpp
+
+HEADERS += ../../sweep.h \
+    ../../traceresampler.h \
+    ../../goldenscore.h
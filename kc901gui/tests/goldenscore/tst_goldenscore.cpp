@@ -0,0 +1,155 @@
+#include <QtTest>
+#include <math.h>
+#include "sweep.h"
+#include "goldenscore.h"
+
+static const int Points = 801;
+static const qreal Start = 800e6, Stop = 1000e6;
+static const qreal Step = (Stop - Start) / (Points - 1);
+
+static qreal filterDb(qreal f, qreal f0)
+//band pass around f0, 20 MHz wide, 40 dB down outside
+{
+    qreal x = (f - f0) / 10e6;
+    return -40 + 39 / (1 + x * x * x * x);
+}
+
+static Sweep s21Sweep(qreal shift, qreal scale, qreal offset)
+//the filter moved up by shift, its dB trace scaled and lifted
+{
+    Sweep sweep = Sweep::create(Sweep::S21, Points);
+    qreal *freq = sweep.freqData();
+    qreal *value = sweep.valueData();
+    for(int i = 0; i < Points; i++)
+    {
+        freq[i] = Start + Step * i;
+        value[i] = scale * filterDb(freq[i], 900e6 + shift) + offset;
+    }
+    return sweep;
+}
+
+static Sweep riSweep(qreal shift, qreal gain)
+//resonator dip at 900 MHz moved up by shift, the reflection times gain
+{
+    Sweep sweep = Sweep::create(Sweep::Ri, Points);
+    qreal *freq = sweep.freqData();
+    QPointF *ri = sweep.riData();
+    for(int i = 0; i < Points; i++)
+    {
+        freq[i] = Start + Step * i;
+        qreal x = (freq[i] - 900e6 - shift) / 5e6;
+        qreal mag = gain * (0.05 + 0.9 * x * x / (1 + x * x));
+        qreal phase = -2 * M_PI * freq[i] * 1e-9;
+        ri[i] = QPointF(mag * cos(phase), mag * sin(phase));
+    }
+    return sweep;
+}
+
+class TestGoldenScore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void identical();
+    void shift_data();
+    void shift();
+    void complexShift_data();
+    void complexShift();
+    void beyondReach();
+    void bands();
+};
+
+void TestGoldenScore::identical()
+{
+    GoldenScore score;
+    score.setGolden(s21Sweep(0, 1, 0));
+    QVERIFY(score.compare(s21Sweep(0, 1, 0)));
+    QCOMPARE(score.distance(), 0.0);
+    const GoldenScore::BandResult &r = score.bandResults().first();
+    QVERIFY(qAbs(r.shift) < 1e-3 * Step);
+    QVERIFY(r.correlation > 1 - 1e-9);
+    QVERIFY(!r.atLimit);
+}
+
+void TestGoldenScore::shift_data()
+{
+    QTest::addColumn<qreal>("shift");
+    QTest::addColumn<qreal>("scale");
+    QTest::addColumn<qreal>("offset");
+    QTest::newRow("up") << 1.3e6 << 1.0 << 0.0;
+    QTest::newRow("down, lifted") << -2.6e6 << 1.0 << 5.0;
+    QTest::newRow("up, scaled") << 12.1e6 << 1.5 << -2.0;
+    QTest::newRow("down, flattened") << -30.05e6 << 0.7 << 3.0;
+}
+
+void TestGoldenScore::shift()
+//level and scale of the dB trace do not move the shift
+{
+    QFETCH(qreal, shift);
+    QFETCH(qreal, scale);
+    QFETCH(qreal, offset);
+    GoldenScore score;
+    score.setGolden(s21Sweep(0, 1, 0));
+    QVERIFY(score.compare(s21Sweep(shift, scale, offset)));
+    QVERIFY(score.distance() > 0);
+    const GoldenScore::BandResult &r = score.bandResults().first();
+    QVERIFY2(qAbs(r.shift - shift) < 0.1 * Step, qPrintable(QString::number(r.shift)));
+    QVERIFY(r.correlation > 0.99);
+    QVERIFY(!r.atLimit);
+}
+
+void TestGoldenScore::complexShift_data()
+{
+    QTest::addColumn<qreal>("shift");
+    QTest::addColumn<qreal>("gain");
+    QTest::newRow("up") << 3.3e6 << 1.0;
+    QTest::newRow("down, lower") << -7.9e6 << 0.8;
+}
+
+void TestGoldenScore::complexShift()
+{
+    QFETCH(qreal, shift);
+    QFETCH(qreal, gain);
+    GoldenScore score;
+    score.setGolden(riSweep(0, 1));
+    QVERIFY(score.isComplex());
+    QVERIFY(score.compare(riSweep(shift, gain)));
+    const GoldenScore::BandResult &r = score.bandResults().first();
+    QVERIFY2(qAbs(r.shift - shift) < 0.1 * Step, qPrintable(QString::number(r.shift)));
+    QVERIFY(r.correlation > 0.99);
+    //an S21 sweep is not scored against an S11 golden
+    QVERIFY(!score.compare(s21Sweep(0, 1, 0)));
+}
+
+void TestGoldenScore::beyondReach()
+//a quarter of the sweep is the most the search looks
+{
+    GoldenScore score;
+    score.setGolden(s21Sweep(0, 1, 0));
+    QVERIFY(score.compare(s21Sweep(70e6, 1, 0)));
+    QVERIFY(score.bandResults().first().atLimit);
+}
+
+void TestGoldenScore::bands()
+//per band figures, the weights only count for the whole score
+{
+    GoldenScore score;
+    QString error;
+    QVERIFY(!score.parseBands("880 870\n", &error));
+    QVERIFY(!score.parseBands("880 920\n , ,\n", &error));
+    QVERIFY2(error.startsWith("line 2: , ,"), qPrintable(error));
+    QVERIFY(score.parseBands("# passband, upper skirt\n880 920\n905 935 2\n", &error));
+    QCOMPARE(score.bands().size(), 2);
+    score.setGolden(s21Sweep(0, 1, 0));
+    QVERIFY(score.compare(s21Sweep(1.7e6, 1, 0)));
+    QCOMPARE(score.bandResults().size(), 2);
+    foreach(const GoldenScore::BandResult &r, score.bandResults())
+    {
+        QVERIFY(r.rms > 0);
+        QVERIFY2(qAbs(r.shift - 1.7e6) < 0.1 * Step, qPrintable(QString::number(r.shift)));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestGoldenScore)
+
+#include "tst_goldenscore.moc"
@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Impedance quantities from normalized impedance and reflection
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_impedance
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_impedance.cpp \
+    ../../impedancecalculator.cpp
+
+HEADERS += ../../impedancecalculator.h
@@ -0,0 +1,85 @@
+#include <QtTest>
+#include <math.h>
+#include "impedancecalculator.h"
+
+static const int Points = 5;
+
+class TestImpedance : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void partialMask();
+    void quantities();
+    void fromReflection();
+};
+
+static QVector<qreal> grid()
+{
+    QVector<qreal> freq;
+    for(int i = 0; i < Points; i++)
+        freq.append(100e6 * (i + 1));
+    return freq;
+}
+
+void TestImpedance::partialMask()
+//only the quantities of the mask are sized and written, also after a wider mask
+{
+    QVector<qreal> freq = grid();
+    QVector<QPointF> z(Points, QPointF(1, 0.5));
+    ImpedanceCalculator calc;
+    calc.compute(freq, z, (1 << ImpedanceCalculator::QuantityCount) - 1);
+    for(int q = 0; q < ImpedanceCalculator::QuantityCount; q++)
+        QCOMPARE(calc.values(ImpedanceCalculator::Quantity(q)).size(), Points);
+
+    int mask = 1 << ImpedanceCalculator::Resistance | 1 << ImpedanceCalculator::Reactance;
+    calc.compute(freq, z, mask);
+    for(int q = 0; q < ImpedanceCalculator::QuantityCount; q++)
+        QCOMPARE(calc.values(ImpedanceCalculator::Quantity(q)).size(), mask & (1 << q) ? Points : 0);
+    QCOMPARE(calc.values(ImpedanceCalculator::Resistance).first(), 50.0);
+    QCOMPARE(calc.values(ImpedanceCalculator::Reactance).first(), 25.0);
+
+    //a fresh calculator with a partial mask never had the other buffers
+    ImpedanceCalculator fresh;
+    fresh.compute(freq, z, 1 << ImpedanceCalculator::Magnitude);
+    for(int q = 0; q < ImpedanceCalculator::QuantityCount; q++)
+        QCOMPARE(fresh.values(ImpedanceCalculator::Quantity(q)).size(), q == ImpedanceCalculator::Magnitude ? Points : 0);
+}
+
+void TestImpedance::quantities()
+//25 + j50 ohm against 50 ohm
+{
+    QVector<qreal> freq = grid();
+    QVector<QPointF> z(Points, QPointF(0.5, 1));
+    ImpedanceCalculator calc;
+    calc.compute(freq, z, (1 << ImpedanceCalculator::QuantityCount) - 1);
+    qreal r = 25, x = 50, mag2 = r*r + x*x;
+    for(int i = 0; i < Points; i++)
+    {
+        qreal w = 2 * M_PI * freq[i];
+        QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::Magnitude)[i], sqrt(mag2)));
+        QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::Conductance)[i], 1e3 * r / mag2));
+        QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::Susceptance)[i], -1e3 * x / mag2));
+        QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::SeriesL)[i], 1e9 * x / w));
+        QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::SeriesC)[i], -1e12 / (w * x)));
+    }
+}
+
+void TestImpedance::fromReflection()
+//G = 1/3 is 100 ohm, G = j is j50 ohm
+{
+    QVector<qreal> freq = grid();
+    QVector<QPointF> ri(Points, QPointF(1.0 / 3, 0));
+    ri[1] = QPointF(0, 1);
+    ImpedanceCalculator calc;
+    calc.computeFromReflection(freq, ri, 1 << ImpedanceCalculator::Resistance | 1 << ImpedanceCalculator::Reactance);
+    QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::Resistance)[0], 100.0));
+    QVERIFY(qAbs(calc.values(ImpedanceCalculator::Reactance)[0]) < 1e-9);
+    QVERIFY(qAbs(calc.values(ImpedanceCalculator::Resistance)[1]) < 1e-9);
+    QVERIFY(qFuzzyCompare(calc.values(ImpedanceCalculator::Reactance)[1], 50.0));
+    QCOMPARE(calc.values(ImpedanceCalculator::SeriesC).size(), 0);
+}
+
+QTEST_APPLESS_MAIN(TestImpedance)
+
+#include "tst_impedance.moc"
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Circuit and rational fits of sweeps made from known models
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+greaterThan(QT_MAJOR_VERSION, 4): QT += concurrent
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_modelfitter
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_modelfitter.cpp \
+    ../../sweep.cpp \
+    ../../modelfitter.cpp
+
+HEADERS += ../../sweep.h \
+    ../../modelfitter.h
@@ -0,0 +1,247 @@
+#include <QtTest>
+#include <complex>
+#include <math.h>
+#include "sweep.h"
+#include "modelfitter.h"
+
+typedef std::complex<qreal> Complex;
+
+static const qreal Z0 = 50;
+
+/// Circuit and rational fits of sweeps made from known models
+/**
+RI and S21 sweeps of a series RLC and a Butterworth-van Dyke resonator,
+noise free and with noise of 1e-3 in Gamma or 0.01 dB, and an RI sweep
+of a rational function with two complex pole pairs. The fits must
+return the element values, the resonances and the poles they were made
+from. A second fit of the same model on a drifted sweep of the same
+grid starts from the first solution: it takes at most 3 steps for the
+series RLC and 6 for the crystal, and vector fitting its 2 iterations.
+*/
+class TestModelFitter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void seriesRlc_data();
+    void seriesRlc();
+    void bvd_data();
+    void bvd();
+    void rational();
+    void warmRational();
+    void rejected();
+
+private:
+    static Sweep circuitSweep(bool s21, ModelFitter::Model model, const qreal *values,
+                              qreal start, qreal stop, int points, qreal noise = 0);
+    static Sweep rationalSweep(qreal scale, int points);
+    static qreal value(const ModelFitter::Result &result, const QString &name);
+};
+
+Sweep TestModelFitter::circuitSweep(bool s21, ModelFitter::Model model, const qreal *values,
+                                    qreal start, qreal stop, int points, qreal noise)
+//r, l, c and for BVD c0, uniform noise of rms noise in Gamma or dB
+{
+    quint32 seed = 12345;
+    qreal scale = noise * sqrt(12.0);
+    Sweep sweep = Sweep::create(s21 ? Sweep::S21 : Sweep::Ri, points);
+    for(int i = 0; i < points; i++)
+    {
+        qreal f = start + (stop - start) * i / (points - 1);
+        qreal w = 2 * M_PI * f;
+        Complex z(values[0], w * values[1] - 1 / (w * values[2]));
+        if(model == ModelFitter::Bvd)
+            z = 1.0 / (1.0 / z + Complex(0, w * values[3]));
+        sweep.freqData()[i] = f;
+        qreal u[2];
+        for(int k = 0; k < 2; k++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            u[k] = scale * (seed / 4294967296.0 - 0.5);
+        }
+        if(s21)
+            sweep.valueData()[i] = 20 * log10(abs(2 * Z0 / (2 * Z0 + z))) + u[0];
+        else
+        {
+            Complex g = (z - Z0) / (z + Z0);
+            sweep.riData()[i] = QPointF(g.real() + u[0], g.imag() + u[1]);
+        }
+    }
+    return sweep;
+}
+
+qreal TestModelFitter::value(const ModelFitter::Result &result, const QString &name)
+{
+    for(int k = 0; k < result.names.size(); k++)
+        if(result.names[k] == name) return result.values[k];
+    return qQNaN();
+}
+
+static void circuitRows()
+//noise and the tolerances it leaves on the element values and the resonance
+{
+    QTest::addColumn<bool>("s21");
+    QTest::addColumn<qreal>("noise");
+    QTest::addColumn<qreal>("elements");
+    QTest::addColumn<qreal>("resonance");
+    QTest::newRow("RI") << false << 0.0 << 1e-5 << 1e-8;
+    QTest::newRow("S21") << true << 0.0 << 1e-5 << 1e-8;
+    //the series RLC has a Q of 20, its resonance is the least sharp
+    QTest::newRow("RI, noise") << false << 1e-3 << 2e-2 << 1e-3;
+    QTest::newRow("S21, noise") << true << 1e-2 << 2e-2 << 1e-3;
+}
+
+void TestModelFitter::seriesRlc_data()
+{
+    circuitRows();
+}
+
+void TestModelFitter::seriesRlc()
+//5 ohm, 100 nH, 10 pF: 159 MHz, Q 20
+{
+    QFETCH(bool, s21);
+    QFETCH(qreal, noise);
+    QFETCH(qreal, elements);
+    QFETCH(qreal, resonance);
+    const qreal rlc[] = { 5, 100e-9, 10e-12 };
+    ModelFitter fitter;
+    fitter.setModel(ModelFitter::SeriesRlc);
+    const ModelFitter::Result &result = fitter.fit(circuitSweep(s21, ModelFitter::SeriesRlc, rlc, 120e6, 200e6, 401, noise));
+    QVERIFY2(result.valid, qPrintable(result.error));
+    qDebug("cold: %d iterations, rms %g, R %g L %g C %g f0 %g", result.iterations, result.rms,
+           value(result, "R") / rlc[0] - 1, value(result, "L") / rlc[1] - 1, value(result, "C") / rlc[2] - 1,
+           value(result, "f0") * 2 * M_PI * sqrt(rlc[1] * rlc[2]) - 1);
+    QVERIFY(fabs(value(result, "R") / rlc[0] - 1) < elements);
+    QVERIFY(fabs(value(result, "L") / rlc[1] - 1) < elements);
+    QVERIFY(fabs(value(result, "C") / rlc[2] - 1) < elements);
+    QVERIFY(fabs(value(result, "f0") * 2 * M_PI * sqrt(rlc[1] * rlc[2]) - 1) < resonance);
+    QVERIFY(result.rms < 1e-6 + 1.1 * noise);
+
+    //the resonance moves by 0.2%, the same grid: a warm start
+    const qreal drifted[] = { 5.1, 100e-9, 9.96e-12 };
+    const ModelFitter::Result &warm = fitter.fit(circuitSweep(s21, ModelFitter::SeriesRlc, drifted, 120e6, 200e6, 401, noise));
+    QVERIFY2(warm.valid, qPrintable(warm.error));
+    qDebug("warm: %d iterations", warm.iterations);
+    QVERIFY(warm.iterations <= 3);
+    QVERIFY(fabs(value(warm, "R") / drifted[0] - 1) < elements);
+    QVERIFY(fabs(value(warm, "C") / drifted[2] - 1) < elements);
+    QVERIFY(fabs(value(warm, "f0") * 2 * M_PI * sqrt(drifted[1] * drifted[2]) - 1) < resonance);
+}
+
+void TestModelFitter::bvd_data()
+{
+    circuitRows();
+}
+
+void TestModelFitter::bvd()
+//a 10 MHz crystal: Rm 200 ohm, Lm 10 mH, Cm for fs, C0 5 pF; fp is 25 kHz above fs
+{
+    QFETCH(bool, s21);
+    QFETCH(qreal, noise);
+    QFETCH(qreal, elements);
+    QFETCH(qreal, resonance);
+    qreal ws = 2 * M_PI * 10e6;
+    const qreal rlcc[] = { 200, 10e-3, 1 / (ws * ws * 10e-3), 5e-12 };
+    qreal fp = 10e6 * sqrt(1 + rlcc[2] / rlcc[3]);
+    ModelFitter fitter;
+    fitter.setModel(ModelFitter::Bvd);
+    const ModelFitter::Result &result = fitter.fit(circuitSweep(s21, ModelFitter::Bvd, rlcc, 9.98e6, 10.05e6, 701, noise));
+    QVERIFY2(result.valid, qPrintable(result.error));
+    qDebug("cold: %d iterations, rms %g, Rm %g Lm %g Cm %g C0 %g fs %g fp %g", result.iterations, result.rms,
+           value(result, "Rm") / rlcc[0] - 1, value(result, "Lm") / rlcc[1] - 1, value(result, "Cm") / rlcc[2] - 1,
+           value(result, "C0") / rlcc[3] - 1, value(result, "fs") / 10e6 - 1, value(result, "fp") / fp - 1);
+    QVERIFY(fabs(value(result, "Rm") / rlcc[0] - 1) < elements);
+    QVERIFY(fabs(value(result, "Lm") / rlcc[1] - 1) < elements);
+    QVERIFY(fabs(value(result, "Cm") / rlcc[2] - 1) < elements);
+    QVERIFY(fabs(value(result, "C0") / rlcc[3] - 1) < elements);
+    QVERIFY(fabs(value(result, "fs") / 10e6 - 1) < resonance);
+    QVERIFY(fabs(value(result, "fp") / fp - 1) < resonance);
+
+    //a crystal warming up, fs 100 Hz lower
+    qreal wd = 2 * M_PI * (10e6 - 100);
+    const qreal drifted[] = { 200, 10e-3, 1 / (wd * wd * 10e-3), 5e-12 };
+    const ModelFitter::Result &warm = fitter.fit(circuitSweep(s21, ModelFitter::Bvd, drifted, 9.98e6, 10.05e6, 701, noise));
+    QVERIFY2(warm.valid, qPrintable(warm.error));
+    qDebug("warm: %d iterations", warm.iterations);
+    QVERIFY(warm.iterations <= 6);
+    QVERIFY(fabs(value(warm, "fs") / (10e6 - 100) - 1) < resonance);
+}
+
+Sweep TestModelFitter::rationalSweep(qreal scale, int points)
+//two pole pairs, 120 MHz Q 30 and 170 MHz Q 50, scale moves both
+{
+    const qreal f[] = { 120e6 * scale, 170e6 * scale };
+    const qreal q[] = { 30, 50 };
+    const Complex residue[] = { Complex(2e6, 1e6), Complex(-1e6, 3e6) };
+    Sweep sweep = Sweep::create(Sweep::Ri, points);
+    for(int i = 0; i < points; i++)
+    {
+        qreal freq = 100e6 + 100e6 * i / (points - 1);
+        Complex s(0, 2 * M_PI * freq);
+        Complex g(0.1, 0);
+        for(int k = 0; k < 2; k++)
+        {
+            qreal w = 2 * M_PI * f[k];
+            Complex pole(-w / (2 * q[k]), w * sqrt(1 - 1 / (4 * q[k] * q[k])));
+            g += residue[k] / (s - pole) + conj(residue[k]) / (s - conj(pole));
+        }
+        sweep.freqData()[i] = freq;
+        sweep.riData()[i] = QPointF(g.real(), g.imag());
+    }
+    return sweep;
+}
+
+void TestModelFitter::rational()
+{
+    ModelFitter fitter;
+    fitter.setModel(ModelFitter::Rational, 4);
+    const ModelFitter::Result &result = fitter.fit(rationalSweep(1, 401));
+    QVERIFY2(result.valid, qPrintable(result.error));
+    qDebug("rational: %d iterations, rms %g", result.iterations, result.rms);
+    QVERIFY(result.rms < 1e-8);
+    QCOMPARE(result.names.size(), 4);
+    //the pairs in either order
+    qreal f1 = value(result, "f1"), f2 = value(result, "f2");
+    qreal q1 = value(result, "Q1"), q2 = value(result, "Q2");
+    if(f1 > f2)
+    {
+        qSwap(f1, f2);
+        qSwap(q1, q2);
+    }
+    //f is the imaginary part of the pole, sqrt(1 - 1 / 4 Q^2) of the resonance
+    QVERIFY(fabs(f1 / (120e6 * sqrt(1 - 1 / 3600.0)) - 1) < 1e-6);
+    QVERIFY(fabs(f2 / (170e6 * sqrt(1 - 1 / 10000.0)) - 1) < 1e-6);
+    QVERIFY(fabs(q1 / 30 - 1) < 1e-5);
+    QVERIFY(fabs(q2 / 50 - 1) < 1e-5);
+    QCOMPARE(fitter.modelRi().size(), 401);
+}
+
+void TestModelFitter::warmRational()
+{
+    ModelFitter fitter;
+    fitter.setModel(ModelFitter::Rational, 4);
+    QVERIFY(fitter.fit(rationalSweep(1, 401)).valid);
+    //the poles of the last sweep start the fit of the next
+    const ModelFitter::Result &warm = fitter.fit(rationalSweep(1.002, 401));
+    QVERIFY2(warm.valid, qPrintable(warm.error));
+    QVERIFY(warm.iterations <= 2);
+    QVERIFY(warm.rms < 1e-8);
+    qreal f1 = qMin(value(warm, "f1"), value(warm, "f2"));
+    QVERIFY(fabs(f1 / (120.24e6 * sqrt(1 - 1 / 3600.0)) - 1) < 1e-6);
+}
+
+void TestModelFitter::rejected()
+{
+    ModelFitter fitter;
+    //too short, and a parallel RLC from |S21|
+    const qreal rlc[] = { 5, 100e-9, 10e-12 };
+    QVERIFY(!fitter.fit(circuitSweep(false, ModelFitter::SeriesRlc, rlc, 120e6, 200e6, 5)).valid);
+    fitter.setModel(ModelFitter::ParallelRlc);
+    QVERIFY(!fitter.fit(circuitSweep(true, ModelFitter::SeriesRlc, rlc, 120e6, 200e6, 101)).valid);
+    fitter.setModel(ModelFitter::Rational, 4);
+    QVERIFY(!fitter.fit(circuitSweep(true, ModelFitter::SeriesRlc, rlc, 120e6, 200e6, 101)).valid);
+}
+
+QTEST_APPLESS_MAIN(TestModelFitter)
+
+#include "tst_modelfitter.moc"
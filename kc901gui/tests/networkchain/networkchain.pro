@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# De-embedding, reference conversion and matching of the network chain
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_networkchain
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_networkchain.cpp \
+    ../../sweep.cpp \
+    ../../networkchain.cpp
+
+HEADERS += ../../sweep.h \
+    ../../networkchain.h
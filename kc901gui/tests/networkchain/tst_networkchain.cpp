@@ -0,0 +1,269 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QTextStream>
+#include <complex>
+#include <math.h>
+#include "sweep.h"
+#include "networkchain.h"
+
+typedef std::complex<qreal> Complex;
+
+static const int Points = 51;
+
+// two-ports written as fixture files
+enum Fixture {
+    Lossy,
+    Thru,
+    SeriesInductor
+};
+
+/// Chains whose result is known without the chain
+/**
+A fixture embedded and de-embedded again leaves the sweep as it was,
+in the reference of the chain and in one of its own. An ideal thru is
+a thru in any reference, and a series inductor read from a file in any
+reference is the same as the "series l" element. The L section of synthesize(), parsed and
+applied to its load, brings the load to the reference; its values are
+printed with 4 digits, so Gamma is close to 0, not 0.
+*/
+class TestNetworkChain : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void embedDeembed_data();
+    void embedDeembed();
+    void thru();
+    void reference_data();
+    void reference();
+    void synthesize_data();
+    void synthesize();
+    void parse_data();
+    void parse();
+
+private:
+    bool writeFixture(const QString &name, qreal z0, Fixture fixture);
+    static Sweep spiral();
+    static Sweep sweep(const QVector<qreal> &freq, const QVector<QPointF> &g);
+    static qreal distance(const Sweep &a, const Sweep &b);
+
+    QTemporaryDir dir;
+};
+
+bool TestNetworkChain::writeFixture(const QString &name, qreal z0, Fixture fixture)
+//50 to 250 MHz in 1 MHz steps, every point of the test sweeps is a row
+{
+    QFile file(dir.path() + "/" + name);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    QTextStream out(&file);
+    out << "! generated fixture\n";
+    out << "# MHz S RI R " << z0 << "\n";
+    for(int i = 0; i <= 200; i++)
+    {
+        qreal f = 50 + i;
+        qreal t = f / 250;
+        Complex s11(0.1 + 0.05 * t, -0.08 * t);
+        Complex s21 = 0.9 * std::polar(1.0, -2 * M_PI * t);
+        Complex s22(-0.05, 0.12 * t);
+        if(fixture == Thru)
+        {
+            s11 = s22 = 0;
+            s21 = 1;
+        }
+        else if(fixture == SeriesInductor)
+        {
+            //12 nH, s11 = z / (z + 2 z0), s21 = 2 z0 / (z + 2 z0)
+            Complex z(0, 2 * M_PI * f * 1e6 * 12e-9);
+            s11 = s22 = z / (z + 2 * z0);
+            s21 = 2 * z0 / (z + 2 * z0);
+        }
+        Complex s[4] = { s11, s21, s21, s22 };
+        out << f;
+        for(int k = 0; k < 4; k++)
+            out << " " << s[k].real() << " " << s[k].imag();
+        out << "\n";
+    }
+    return true;
+}
+
+Sweep TestNetworkChain::sweep(const QVector<qreal> &freq, const QVector<QPointF> &g)
+{
+    Sweep s = Sweep::create(Sweep::Ri, freq.size());
+    for(int i = 0; i < freq.size(); i++)
+    {
+        s.freqData()[i] = freq[i];
+        s.riData()[i] = g[i];
+    }
+    return s;
+}
+
+qreal TestNetworkChain::distance(const Sweep &a, const Sweep &b)
+//largest |Gamma a - Gamma b| over the sweep
+{
+    qreal most = 0;
+    for(int i = 0; i < a.size(); i++)
+    {
+        QPointF d = a.ri()[i] - b.ri()[i];
+        most = qMax(most, sqrt(d.x() * d.x() + d.y() * d.y()));
+    }
+    return most;
+}
+
+void TestNetworkChain::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFixture("fixture50.s2p", 50, Lossy));
+    QVERIFY(writeFixture("fixture25.s2p", 25, Lossy));
+    QVERIFY(writeFixture("thru25.s2p", 25, Thru));
+    QVERIFY(writeFixture("inductor25.s2p", 25, SeriesInductor));
+    QVERIFY(writeFixture("inductor50.s2p", 50, SeriesInductor));
+    QVERIFY(writeFixture("inductor100.s2p", 100, SeriesInductor));
+}
+
+Sweep TestNetworkChain::spiral()
+//a load circling the chart between 100 and 200 MHz
+{
+    QVector<qreal> freq(Points);
+    QVector<QPointF> g(Points);
+    for(int i = 0; i < Points; i++)
+    {
+        freq[i] = 100e6 + 2e6 * i;
+        qreal mag = 0.2 + 0.7 * i / (Points - 1);
+        g[i] = QPointF(mag * cos(0.4 * i), mag * sin(0.4 * i));
+    }
+    return sweep(freq, g);
+}
+
+void TestNetworkChain::embedDeembed_data()
+{
+    QTest::addColumn<QString>("fixture");
+    QTest::addColumn<qreal>("reference");
+    QTest::newRow("fixture in the chain reference") << QString("fixture50.s2p") << 50.0;
+    QTest::newRow("fixture in 25 ohm, chain in 50") << QString("fixture25.s2p") << 50.0;
+    QTest::newRow("fixture in 50 ohm, chain in 75") << QString("fixture50.s2p") << 75.0;
+}
+
+void TestNetworkChain::embedDeembed()
+{
+    QFETCH(QString, fixture);
+    QFETCH(qreal, reference);
+    NetworkChain chain;
+    chain.setReference(reference);
+    QString error;
+    QVERIFY2(chain.parse(QString("embed %1\ndeembed %1\n").arg(fixture), dir.path(), &error), qPrintable(error));
+    QCOMPARE(chain.size(), 2);
+
+    Sweep load = spiral();
+    Sweep through = chain.apply(load);
+    QCOMPARE(through.size(), load.size());
+    QVERIFY(distance(through, load) < 1e-9);
+
+    //the fixture alone does change the sweep
+    QVERIFY(chain.parse(QString("embed %1\n").arg(fixture), dir.path(), &error));
+    QVERIFY(distance(chain.apply(load), load) > 0.05);
+}
+
+void TestNetworkChain::thru()
+{
+    NetworkChain chain;
+    QString error;
+    QVERIFY2(chain.parse("embed thru25.s2p\n", dir.path(), &error), qPrintable(error));
+    QCOMPARE(chain.reference(), 50.0);
+    Sweep load = spiral();
+    QVERIFY(distance(chain.apply(load), load) < 1e-9);
+    QVERIFY(chain.parse("deembed thru25.s2p\n", dir.path(), &error));
+    QVERIFY(distance(chain.apply(load), load) < 1e-9);
+}
+
+void TestNetworkChain::reference_data()
+{
+    QTest::addColumn<QString>("fixture");
+    QTest::newRow("25 ohm file") << QString("inductor25.s2p");
+    QTest::newRow("50 ohm file") << QString("inductor50.s2p");
+    QTest::newRow("100 ohm file") << QString("inductor100.s2p");
+}
+
+void TestNetworkChain::reference()
+//the renormalisation of the file, a wrong one would not cancel like embed / deembed
+{
+    QFETCH(QString, fixture);
+    NetworkChain file, element;
+    QString error;
+    QVERIFY2(file.parse(QString("embed %1\n").arg(fixture), dir.path(), &error), qPrintable(error));
+    QVERIFY(element.parse("series l 12\n", QString(), &error));
+    Sweep load = spiral();
+    Sweep a = file.apply(load);
+    Sweep b = element.apply(load);
+    //the file has 6 digits
+    QVERIFY(distance(a, b) < 1e-5);
+    QVERIFY(distance(a, load) > 0.05);
+}
+
+void TestNetworkChain::synthesize_data()
+{
+    QTest::addColumn<qreal>("r");
+    QTest::addColumn<qreal>("x");
+    QTest::newRow("r above z0, capacitive") << 120.0 << -40.0;
+    QTest::newRow("r above z0, inductive") << 300.0 << 150.0;
+    QTest::newRow("r below z0, inductive") << 20.0 << 35.0;
+    QTest::newRow("r below z0, capacitive") << 10.0 << -25.0;
+    QTest::newRow("r at z0") << 50.0 << 30.0;
+}
+
+void TestNetworkChain::synthesize()
+{
+    QFETCH(qreal, r);
+    QFETCH(qreal, x);
+    const qreal z0 = 50;
+    const qreal freq = 145e6;
+    Complex z(r, x);
+    Complex g = (z - z0) / (z + z0);
+    QString text = NetworkChain::synthesize(freq, QPointF(g.real(), g.imag()), z0);
+    QVERIFY(!text.isEmpty());
+
+    NetworkChain chain;
+    QString error;
+    QVERIFY2(chain.parse(text, QString(), &error), qPrintable(error));
+    QVERIFY(chain.size() >= 1 && chain.size() <= 2);
+    Sweep matched = chain.apply(sweep(QVector<qreal>(1, freq), QVector<QPointF>(1, QPointF(g.real(), g.imag()))));
+    QPointF m = matched.ri()[0];
+    qreal mag = sqrt(m.x() * m.x() + m.y() * m.y());
+    qDebug("%g%+gj ohm: |Gamma| %g after\n%s", r, x, mag, qPrintable(text));
+    QVERIFY(mag < 2e-3);
+}
+
+void TestNetworkChain::parse_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<QString>("error");
+    QTest::newRow("elements") << QString("# comment\nseries l 12\nshunt c 3.3\nline 25 vf 0.66 z0 75\n") << 3 << QString();
+    QTest::newRow("commas") << QString("series, l, 12\n") << 1 << QString();
+    QTest::newRow("separators only") << QString(",\n") << 0 << QString("line 1: ,");
+    QTest::newRow("separators after an element") << QString("series l 12\n , ,\n") << 0 << QString("line 2: , ,");
+    QTest::newRow("unknown part") << QString("series r 12\n") << 0 << QString("line 1: series r 12");
+    QTest::newRow("negative value") << QString("shunt c -1\n") << 0 << QString("line 1: shunt c -1");
+    QTest::newRow("line key without value") << QString("line 25 vf\n") << 0 << QString("line 1: line 25 vf");
+    QTest::newRow("missing fixture") << QString("embed none.s2p\n") << 0 << QString("line 1: none.s2p");
+}
+
+void TestNetworkChain::parse()
+{
+    QFETCH(QString, text);
+    QFETCH(int, size);
+    QFETCH(QString, error);
+    NetworkChain chain;
+    QString message;
+    bool ok = chain.parse(text, dir.path(), &message);
+    QCOMPARE(ok, error.isEmpty());
+    if(ok)
+        QCOMPARE(chain.size(), size);
+    else
+        QVERIFY2(message.startsWith(error), qPrintable(message));
+}
+
+QTEST_APPLESS_MAIN(TestNetworkChain)
+
+#include "tst_networkchain.moc"
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Bit exact round trip of the sweep archive codec
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_sweeparchive
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_sweeparchive.cpp \
+    ../../sweep.cpp \
+    ../../sweeparchive.cpp
+
+HEADERS += ../../sweep.h \
+    ../../sweeparchive.h
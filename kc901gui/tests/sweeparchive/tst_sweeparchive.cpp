@@ -0,0 +1,264 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QtEndian>
+#include <math.h>
+#include <string.h>
+#include "sweep.h"
+#include "sweeparchive.h"
+
+static const int RiPoints = 101;
+static const int ScalarPoints = 24;
+
+static quint64 toBits(qreal v)
+{
+    double d = v;
+    quint64 b;
+    memcpy(&b, &d, sizeof(b));
+    return b;
+}
+
+static qreal fromBits(quint64 b)
+{
+    double d;
+    memcpy(&d, &b, sizeof(d));
+    return d;
+}
+
+/// Writes an archive of every case of the codec and reads it back bit by bit
+/**
+The recording is, in this order:
+    64 RI sweeps, exactly one full block
+    70 RI sweeps on the same grid, a full block and 6 more
+    10 VSWR sweeps of special values, the grid changes mid-block
+    5 RI sweeps, back on the first grid
+    3 S21 sweeps on a grid of their own
+The special values are +-0, NaNs, denormals, infinities and values whose
+XOR with their reference sets bit 63 and bit 0, the 64 bit window.
+*/
+class TestSweepArchive : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void read();
+    void readBlock();
+    void find();
+    void withoutIndex();
+    void cutBlock();
+
+private:
+    void record(Sweep::Kind kind, int points, int count, qreal cent, qreal span);
+    QString copy(qint64 bytes, const QString &name);
+    QString compare(const Sweep &sweep, int index);
+
+    QTemporaryDir dir;
+    QString archive;
+    QVector<Sweep> sweeps;
+    QVector<qint64> times;
+    QVector<int> blockSizes;
+    SweepArchive writer;
+};
+
+void TestSweepArchive::record(Sweep::Kind kind, int points, int count, qreal cent, qreal span)
+{
+    //xor of the first two with their neighbour is 0x8000000000000001, the others cover the bit patterns
+    const qreal special[] = { 0.0, fromBits(Q_UINT64_C(0x8000000000000001)), -0.0, qQNaN(),
+                              fromBits(Q_UINT64_C(0x7ff8000000000123)), fromBits(Q_UINT64_C(0xfff0000000000001)),
+                              fromBits(1), fromBits(Q_UINT64_C(0x000fffffffffffff)), qInf(), -qInf(),
+                              1.0, fromBits(~toBits(1.0)), 1e308, -1e-308 };
+    const int specials = sizeof(special) / sizeof(special[0]);
+    for(int c = 0; c < count; c++)
+    {
+        int s = sweeps.size();
+        Sweep sweep = Sweep::create(kind, points);
+        qreal *freq = sweep.freqData();
+        for(int i = 0; i < points; i++)
+            freq[i] = cent - span / 2 + span * i / (points - 1);
+        if(kind == Sweep::Ri)
+        {
+            //slow drift, most samples share the window of the one before
+            QPointF *ri = sweep.riData();
+            for(int i = 0; i < points; i++)
+                ri[i] = QPointF(0.5 * cos(i * 0.1 + s * 0.01), 0.5 * sin(i * 0.1 + s * 0.013));
+        }
+        else if(kind == Sweep::Vswr)
+        {
+            //rotated every sweep, so each special value is XORed against the others
+            qreal *value = sweep.valueData();
+            for(int i = 0; i < points; i++)
+                value[i] = i < specials ? special[(i + c) % specials] : 1.5 + 0.001 * s * i;
+        }
+        else
+        {
+            qreal *value = sweep.valueData();
+            for(int i = 0; i < points; i++)
+                value[i] = -40 + i * 0.25 - s * 1e-9;
+        }
+        qint64 t = 1000 + 10 * s;
+        writer.append(sweep, cent, span, t);
+        sweeps.append(sweep);
+        times.append(t);
+    }
+}
+
+void TestSweepArchive::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    archive = dir.path() + "/codec.kca";
+    QString error;
+    QVERIFY2(writer.create(archive, &error), qPrintable(error));
+    record(Sweep::Ri, RiPoints, 64, 150e6, 100e6);
+    record(Sweep::Ri, RiPoints, 70, 150e6, 100e6);
+    record(Sweep::Vswr, ScalarPoints, 10, 433e6, 20e6);
+    record(Sweep::Ri, RiPoints, 5, 150e6, 100e6);
+    record(Sweep::S21, ScalarPoints, 3, 433e6, 10e6);
+    writer.close();
+    blockSizes << 64 << 64 << 6 << 10 << 5 << 3;
+}
+
+QString TestSweepArchive::compare(const Sweep &sweep, int index)
+//first difference to the recorded sweep, empty when every bit matches
+{
+    const Sweep &expected = sweeps[index];
+    if(sweep.kind() != expected.kind() || sweep.size() != expected.size())
+        return QString("sweep %1: kind or size").arg(index);
+    for(int i = 0; i < sweep.size(); i++)
+    {
+        bool same = toBits(sweep.freq()[i]) == toBits(expected.freq()[i]);
+        if(sweep.kind() == Sweep::Ri)
+            same = same && toBits(sweep.ri()[i].x()) == toBits(expected.ri()[i].x())
+                    && toBits(sweep.ri()[i].y()) == toBits(expected.ri()[i].y());
+        else
+            same = same && toBits(sweep.value()[i]) == toBits(expected.value()[i]);
+        if(!same)
+            return QString("sweep %1: sample %2").arg(index).arg(i);
+    }
+    return QString();
+}
+
+QString TestSweepArchive::copy(qint64 bytes, const QString &name)
+//the archive cut after bytes, as a crash would leave it
+{
+    QFile in(archive);
+    if(!in.open(QIODevice::ReadOnly)) return QString();
+    QByteArray data = in.readAll();
+    QString fileName = dir.path() + "/" + name;
+    QFile out(fileName);
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) return QString();
+    out.write(data.constData(), qMin<qint64>(bytes, data.size()));
+    return fileName;
+}
+
+void TestSweepArchive::read()
+{
+    SweepArchive reader;
+    QString error;
+    QVERIFY2(reader.open(archive, &error), qPrintable(error));
+    QCOMPARE(reader.count(), sweeps.size());
+    QCOMPARE(reader.blockCount(), blockSizes.size());
+    //backwards too, every block is decoded on its own
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(int k = 0; k < sweeps.size(); k++)
+        {
+            int index = pass == 0 ? k : sweeps.size() - 1 - k;
+            qint64 t = 0;
+            QString mismatch = compare(reader.read(index, &t), index);
+            QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+            QCOMPARE(t, times[index]);
+        }
+    }
+}
+
+void TestSweepArchive::readBlock()
+{
+    SweepArchive reader;
+    QVERIFY(reader.open(archive));
+    QVERIFY(reader.map());
+    //one set of buffers for all blocks, as a batch worker keeps them
+    QVector<Sweep> decoded;
+    QVector<qint64> decodedTimes;
+    QVector<qreal> samples;
+    for(int b = 0; b < reader.blockCount(); b++)
+    {
+        QVERIFY(reader.readBlock(b, &decoded, &decodedTimes, &samples));
+        QCOMPARE(decoded.size(), blockSizes[b]);
+        for(int s = 0; s < decoded.size(); s++)
+        {
+            int index = reader.blockFirst(b) + s;
+            QString mismatch = compare(decoded[s], index);
+            QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+            QCOMPARE(decodedTimes[s], times[index]);
+        }
+    }
+}
+
+void TestSweepArchive::find()
+{
+    SweepArchive reader;
+    QVERIFY(reader.open(archive));
+    QCOMPARE(reader.firstTime(), times.first());
+    QCOMPARE(reader.lastTime(), times.last());
+    QCOMPARE(reader.find(0), 0);
+    QCOMPARE(reader.find(times.last() + 1), reader.count());
+    //exact times and the gaps between them, in every block
+    for(int i = 0; i < times.size(); i++)
+    {
+        QCOMPARE(reader.find(times[i]), i);
+        QCOMPARE(reader.find(times[i] - 5), i);
+    }
+}
+
+void TestSweepArchive::withoutIndex()
+{
+    //everything before the index record, the state of a crash after the last block
+    QFile file(archive);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    QVERIFY(data.size() > 16);
+    qint64 indexOffset = qFromBigEndian<qint64>(reinterpret_cast<const uchar *>(data.constData()) + data.size() - 16);
+    QString fileName = copy(indexOffset, "noindex.kca");
+    QVERIFY(!fileName.isEmpty());
+
+    SweepArchive reader;
+    QString error;
+    QVERIFY2(reader.open(fileName, &error), qPrintable(error));
+    QCOMPARE(reader.count(), sweeps.size());
+    QCOMPARE(reader.blockCount(), blockSizes.size());
+    for(int i = 0; i < sweeps.size(); i++)
+    {
+        QString mismatch = compare(reader.read(i), i);
+        QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+    }
+    for(int i = 0; i < times.size(); i++)
+        QCOMPARE(reader.find(times[i]), i);
+}
+
+void TestSweepArchive::cutBlock()
+{
+    //the last block is cut short by a byte and dropped, the rest reads as written
+    QFile file(archive);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    qint64 indexOffset = qFromBigEndian<qint64>(reinterpret_cast<const uchar *>(data.constData()) + data.size() - 16);
+    QString fileName = copy(indexOffset - 1, "cut.kca");
+    QVERIFY(!fileName.isEmpty());
+
+    SweepArchive reader;
+    QVERIFY(reader.open(fileName));
+    int kept = sweeps.size() - blockSizes.last();
+    QCOMPARE(reader.count(), kept);
+    QCOMPARE(reader.blockCount(), blockSizes.size() - 1);
+    for(int i = 0; i < kept; i++)
+    {
+        QString mismatch = compare(reader.read(i), i);
+        QVERIFY2(mismatch.isEmpty(), qPrintable(mismatch));
+    }
+    QCOMPARE(reader.find(times[kept]), kept);
+}
+
+QTEST_APPLESS_MAIN(TestSweepArchive)
+
+#include "tst_sweeparchive.moc"
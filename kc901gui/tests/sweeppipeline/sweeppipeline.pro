@@ -0,0 +1,45 @@
+#-------------------------------------------------
+#
+# Heap allocations of the sweep pipeline in steady state
+#
+#-------------------------------------------------
+
+QT       += core gui testlib
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+unix {
+    include (/usr/local/qwt-6.1.3/features/qwt.prf)
+}
+
+win32 {
+    include (C:/qwt-6.1.3/features/qwt.prf)
+}
+
+TARGET = tst_sweeppipeline
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_sweeppipeline.cpp \
+    ../../sweep.cpp \
+    ../../sweepparser.cpp \
+    ../../sweepseriesdata.cpp \
+    ../../traceprocessor.cpp \
+    ../../phaseprocessor.cpp \
+    ../../peaksearch.cpp \
+    ../../kpiextractor.cpp \
+    ../../tdigest.cpp \
+    ../../productionstats.cpp
+
+HEADERS += ../../sweep.h \
+    ../../sweepparser.h \
+    ../../sweepseriesdata.h \
+    ../../traceprocessor.h \
+    ../../phaseprocessor.h \
+    ../../peaksearch.h \
+    ../../kpiextractor.h \
+    ../../tdigest.h \
+    ../../productionstats.h
@@ -0,0 +1,221 @@
+#include <QtTest>
+#include <stdlib.h>
+#include <new>
+#include <math.h>
+#include "sweep.h"
+#include "sweepparser.h"
+#include "sweepseriesdata.h"
+#include "traceprocessor.h"
+#include "phaseprocessor.h"
+#include "peaksearch.h"
+#include "kpiextractor.h"
+#include "productionstats.h"
+
+//heap allocations while counting is on
+static QAtomicInt allocationCount;
+static bool counting = false;
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+//Qt containers allocate with malloc, so it is counted here and operator new ends up here too
+extern "C" void *malloc(size_t size)
+{
+    if(counting) allocationCount.ref();
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if(counting) allocationCount.ref();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    if(counting) allocationCount.ref();
+    return __libc_realloc(p, size);
+}
+#endif
+
+void *operator new(size_t size)
+{
+#ifndef __GLIBC__
+    if(counting) allocationCount.ref();
+#endif
+    void *p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+void operator delete[](void *p) Q_DECL_NOTHROW
+{
+    free(p);
+}
+
+static const int Points = 401;
+static const qreal Start = 100e6, Stop = 200e6;
+
+static QByteArray reply(Sweep::Kind kind, int variant)
+//instrument reply with a resonance at 150 MHz, the variant moves it a little
+{
+    QByteArray data;
+    data += kind == Sweep::Vswr ? "$start,s11,vswr\n" : kind == Sweep::Ri ? "$start,s11,ri\n" : "$start,s21\n";
+    qreal f0 = 150e6 + variant * 50e3;
+    for(int i = 0; i < Points; i++)
+    {
+        qreal f = Start + (Stop - Start) * i / (Points - 1);
+        qreal x = (f - f0) / 5e6;
+        qreal mag = 0.05 + 0.6 * x * x / (1 + x * x);
+        qreal phase = -2 * M_PI * f * 2e-9;
+        data += QByteArray::number(f, 'f', 0);
+        if(kind == Sweep::Vswr)
+            data += "," + QByteArray::number((1 + mag) / (1 - mag), 'f', 6);
+        else if(kind == Sweep::Ri)
+            data += "," + QByteArray::number(mag * cos(phase), 'f', 6) + "," + QByteArray::number(mag * sin(phase), 'f', 6);
+        else
+            data += "," + QByteArray::number(-20 + 15 / (1 + x * x), 'f', 4) + ",0";
+        data += "\n";
+    }
+    data += "$end\n";
+    return data;
+}
+
+/// The sweep path of MainWindow::processReceived, without the widgets
+class Pipeline
+{
+public:
+    Pipeline() : s11curve(Sweep(), QVector<qreal>()), proccurve(Sweep(), QVector<qreal>()),
+        delaycurve(Sweep(), QVector<qreal>())
+    {
+        scalarproc.setMode(TraceProcessor::ExpAverage);
+        scalarproc.setCount(8);
+        s11proc.setMode(TraceProcessor::ExpAverage);
+        s11proc.setCount(8);
+        phaseproc.setAperture(5);
+        phaseproc.setSmoothing(3);
+        peaksearch.setNotchCount(3);
+        QString error;
+        kpis.parse("resonance\nminvswr 140 160\nbandwidth 10\nmeanrl 120 180\n", &error);
+        spc.setKpis(kpis.names());
+    }
+
+    void run(const QByteArray &data)
+    {
+        Sweep sweep = SweepParser::parse(data);
+        const QVector<qreal> &freq = sweep.freq();
+        switch(sweep.kind())
+        {
+        case Sweep::Vswr:
+            peaksearch.search(freq, sweep.db());
+            proccurve.setSamples(sweep, phaseproc.smooth(scalarproc.process(freq, sweep.value())));
+            s11curve.setSamples(sweep, phaseproc.smooth(sweep.value()));
+            spc.add(sweep, kpis.extract(sweep), -1);
+            break;
+        case Sweep::Ri:
+            peaksearch.search(freq, sweep.db());
+            proccurve.setSamples(sweep, phaseproc.smooth(phaseproc.unwrappedPhase(s11proc.process(freq, sweep.ri()))));
+            delaycurve.setSamples(sweep, phaseproc.smooth(phaseproc.groupDelay(freq, sweep.ri())));
+            s11curve.setSamples(sweep, phaseproc.smooth(sweep.vswr()));
+            sweep.z();
+            spc.add(sweep, kpis.extract(sweep), -1);
+            break;
+        case Sweep::S21:
+            peaksearch.search(freq, sweep.value());
+            proccurve.setSamples(sweep, phaseproc.smooth(scalarproc.process(freq, sweep.value())));
+            s11curve.setSamples(sweep, phaseproc.smooth(sweep.value()));
+            spc.add(sweep, QVector<qreal>(), -1);
+            break;
+        default:
+            break;
+        }
+        //the window keeps the latest sweep, the curves the one they show
+        lastSweep = sweep;
+    }
+
+    ProductionStats spc;
+
+private:
+    SweepSeriesData s11curve, proccurve, delaycurve;
+    TraceProcessor scalarproc, s11proc;
+    PhaseProcessor phaseproc;
+    PeakSearch peaksearch;
+    KpiExtractor kpis;
+    Sweep lastSweep;
+};
+
+class TestSweepPipeline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void steadyState_data();
+    void steadyState();
+};
+
+void TestSweepPipeline::parse_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::newRow("vswr") << int(Sweep::Vswr);
+    QTest::newRow("ri") << int(Sweep::Ri);
+    QTest::newRow("s21") << int(Sweep::S21);
+}
+
+void TestSweepPipeline::parse()
+{
+    QFETCH(int, kind);
+    Sweep sweep = SweepParser::parse(reply(Sweep::Kind(kind), 0));
+    QCOMPARE(int(sweep.kind()), kind);
+    QCOMPARE(sweep.size(), Points);
+    QCOMPARE(sweep.freq().first(), Start);
+    QCOMPARE(sweep.freq().last(), Stop);
+    //deepest match at the resonance
+    if(kind != Sweep::S21)
+        QVERIFY(qAbs(sweep.db()[Points / 2] - 20 * log10(0.05)) < 1e-3);
+}
+
+void TestSweepPipeline::steadyState_data()
+{
+    parse_data();
+}
+
+void TestSweepPipeline::steadyState()
+//continuous sweeps on a fixed grid allocate nothing once the buffers are sized
+{
+    QFETCH(int, kind);
+    QVector<QByteArray> replies;
+    for(int v = 0; v < 4; v++)
+        replies.append(reply(Sweep::Kind(kind), v));
+
+    Pipeline pipeline;
+    //warm up: pool, columns, processor buffers and every envelope digest merged a few times
+    for(int i = 0; i < 400; i++)
+        pipeline.run(replies[i % replies.size()]);
+
+    allocationCount.store(0);
+    counting = true;
+    for(int i = 0; i < 2000; i++)
+        pipeline.run(replies[i % replies.size()]);
+    counting = false;
+
+    QCOMPARE(allocationCount.load(), 0);
+    QCOMPARE(pipeline.spc.units(), quint64(2400));
+}
+
+QTEST_APPLESS_MAIN(TestSweepPipeline)
+
+#include "tst_sweeppipeline.moc"
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Seqlock of the shared memory sweep ring under write load
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_sweepring
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+linux {
+    LIBS += -lrt
+}
+
+SOURCES += tst_sweepring.cpp \
+    ../../sweep.cpp \
+    ../../ringpublisher.cpp
+
+HEADERS += ../../sweep.h \
+    ../../sweepring.h \
+    ../../ringpublisher.h
@@ -0,0 +1,209 @@
+#include <QtTest>
+#include <QThread>
+#include <QCoreApplication>
+#include "sweep.h"
+#include "ringpublisher.h"
+#ifdef Q_OS_UNIX
+#include "sweepring.h"
+#endif
+
+static const int Slots = 4;
+static const int MaxPoints = 512;
+//sweeps the writer cycles through, not a multiple of the slots so a slot never gets the same one twice running
+static const int Patterns = 7;
+
+static int patternPoints(int k)
+{
+    return 101 + 50 * k;
+}
+
+static Sweep::Kind patternKind(int k)
+{
+    return k % 2 ? Sweep::Vswr : Sweep::Ri;
+}
+
+static Sweep pattern(int k)
+//every sample tells which pattern it belongs to
+{
+    int n = patternPoints(k);
+    Sweep sweep = Sweep::create(patternKind(k), n);
+    qreal *freq = sweep.freqData();
+    for(int i = 0; i < n; i++)
+        freq[i] = k * 1e6 + i;
+    if(sweep.kind() == Sweep::Ri)
+    {
+        QPointF *ri = sweep.riData();
+        for(int i = 0; i < n; i++)
+            ri[i] = QPointF(k, -k);
+    }
+    else
+    {
+        qreal *value = sweep.valueData();
+        for(int i = 0; i < n; i++)
+            value[i] = k;
+    }
+    return sweep;
+}
+
+/// Publishes the patterns as fast as it can, the sweep number as cent
+class RingWriter : public QThread
+{
+public:
+    RingWriter(RingPublisher *publisher, const QVector<Sweep> &sweeps)
+        : publisher(publisher), sweeps(sweeps)
+    {
+    }
+
+    void stop() { stopped.store(1); }
+
+protected:
+    void run()
+    {
+        while(!stopped.load())
+        {
+            quint64 n = publisher->published() + 1;
+            publisher->publish(sweeps[(n - 1) % sweeps.size()], n, 0, 0);
+        }
+    }
+
+private:
+    RingPublisher *publisher;
+    QVector<Sweep> sweeps;
+    QAtomicInt stopped;
+};
+
+class TestSweepRing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void singleThread();
+    void concurrentReads();
+
+private:
+    QByteArray ringName() const;
+};
+
+QByteArray TestSweepRing::ringName() const
+{
+    return "/kc901gui_test_" + QByteArray::number(QCoreApplication::applicationPid());
+}
+
+#ifdef Q_OS_UNIX
+
+//0 if the view holds exactly the sweep its number says, else what is wrong
+static const char *checkView(const KcSweepView &view)
+{
+    if(view.cent != double(view.number)) return "header of another sweep";
+    int k = (view.number - 1) % Patterns;
+    if(view.kind != uint32_t(patternKind(k))) return "kind of another sweep";
+    if(view.points != uint32_t(patternPoints(k))) return "size of another sweep";
+    double im = patternKind(k) == Sweep::Ri ? -k : 0;
+    for(uint32_t i = 0; i < view.points; i++)
+    {
+        if(view.freq[i] != k * 1e6 + i) return "freq of another sweep";
+        if(view.re[i] != k || view.im[i] != im) return "samples of another sweep";
+    }
+    return 0;
+}
+
+void TestSweepRing::singleThread()
+{
+    QVector<Sweep> sweeps;
+    for(int k = 0; k < Patterns; k++)
+        sweeps.append(pattern(k));
+    RingPublisher publisher;
+    QString error;
+    QVERIFY2(publisher.open(QString::fromLatin1(ringName()), Slots, MaxPoints, &error), qPrintable(error));
+
+    KcRing ring;
+    QCOMPARE(kc_ring_open(&ring, ringName().constData()), 0);
+    QCOMPARE(kc_ring_published(&ring), uint64_t(0));
+    for(int n = 1; n <= 3 * Patterns; n++)
+    {
+        publisher.publish(sweeps[(n - 1) % Patterns], n, 0, 0);
+        QCOMPARE(kc_ring_published(&ring), uint64_t(n));
+        KcSweepView view;
+        QVERIFY(kc_ring_begin(&ring, n, &view));
+        const char *bad = checkView(view);
+        QVERIFY2(!bad, bad);
+        QVERIFY(kc_ring_end(&view));
+        //the slot of the oldest sweep has been reused
+        if(n > Slots)
+            QVERIFY(!kc_ring_begin(&ring, n - Slots, &view));
+    }
+    kc_ring_close(&ring);
+}
+
+void TestSweepRing::concurrentReads()
+//a reader behind a writer at full rate never accepts a torn or mixed buffer
+{
+    QVector<Sweep> sweeps;
+    for(int k = 0; k < Patterns; k++)
+        sweeps.append(pattern(k));
+    RingPublisher publisher;
+    QString error;
+    QVERIFY2(publisher.open(QString::fromLatin1(ringName()), Slots, MaxPoints, &error), qPrintable(error));
+    KcRing ring;
+    QCOMPARE(kc_ring_open(&ring, ringName().constData()), 0);
+
+    RingWriter writer(&publisher, sweeps);
+    writer.start();
+
+    int accepted = 0, torn = 0, missed = 0;
+    const char *failure = 0;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while(elapsed.elapsed() < 1000 && !failure)
+    {
+        //the latest and the oldest slot, the oldest is the next one overwritten
+        uint64_t latest = kc_ring_published(&ring);
+        uint64_t numbers[2] = { latest, latest >= uint64_t(Slots) ? latest - Slots + 1 : 0 };
+        for(int j = 0; j < 2 && !failure; j++)
+        {
+            KcSweepView view;
+            if(!kc_ring_begin(&ring, numbers[j], &view))
+            {
+                missed++;
+                continue;
+            }
+            const char *bad = checkView(view);
+            if(!kc_ring_end(&view))
+            {
+                torn++;
+                continue;
+            }
+            if(bad)
+                failure = bad;
+            else
+                accepted++;
+        }
+    }
+    writer.stop();
+    writer.wait();
+    kc_ring_close(&ring);
+
+    qDebug("%llu sweeps written, %d reads accepted, %d torn, %d overwritten before the read",
+           (unsigned long long)publisher.published(), accepted, torn, missed);
+    QVERIFY2(!failure, failure);
+    QVERIFY(accepted > 0);
+    QVERIFY(publisher.published() > quint64(Slots));
+}
+
+#else
+
+void TestSweepRing::singleThread()
+{
+    QSKIP("POSIX shared memory only");
+}
+
+void TestSweepRing::concurrentReads()
+{
+    QSKIP("POSIX shared memory only");
+}
+
+#endif
+
+QTEST_GUILESS_MAIN(TestSweepRing)
+
+#include "tst_sweepring.moc"
@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Quantile accuracy and size of the t-digest
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_tdigest
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_tdigest.cpp \
+    ../../tdigest.cpp
+
+HEADERS += ../../tdigest.h
@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# Unit tests, "make check" builds and runs them
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += sweeppipeline \
+    sweepring \
+    goldenscore \
+    impedance \
+    batchscaling \
+    sweeparchive \
+    tdigest \
+    networkchain \
+    traceresampler \
+    tracemath \
+    modelfitter
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Data and memory math on known traces
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_tracemath
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_tracemath.cpp \
+    ../../sweep.cpp \
+    ../../traceresampler.cpp \
+    ../../tracemath.cpp
+
+HEADERS += ../../sweep.h \
+    ../../traceresampler.h \
+    ../../tracemath.h
@@ -0,0 +1,253 @@
+#include <QtTest>
+#include <complex>
+#include <math.h>
+#include "sweep.h"
+#include "tracemath.h"
+
+typedef std::complex<qreal> Complex;
+
+static const int Points = 21;
+
+static Sweep riSweep(const QVector<qreal> &freq, const QVector<Complex> &g)
+{
+    Sweep sweep = Sweep::create(Sweep::Ri, freq.size());
+    for(int i = 0; i < freq.size(); i++)
+    {
+        sweep.freqData()[i] = freq[i];
+        sweep.riData()[i] = QPointF(g[i].real(), g[i].imag());
+    }
+    return sweep;
+}
+
+static Sweep scalarSweep(Sweep::Kind kind, const QVector<qreal> &values)
+{
+    Sweep sweep = Sweep::create(kind, values.size());
+    for(int i = 0; i < values.size(); i++)
+    {
+        sweep.freqData()[i] = 100e6 + 1e6 * i;
+        sweep.valueData()[i] = values[i];
+    }
+    return sweep;
+}
+
+static QVector<qreal> grid(int points)
+{
+    QVector<qreal> freq(points);
+    for(int i = 0; i < points; i++)
+        freq[i] = 100e6 + 100e6 * i / (points - 1);
+    return freq;
+}
+
+/// The results of the class documentation on traces with known answers
+/**
+RI sweeps: G - Gm, G / Gm and -G / Gm. Scalar sweeps: |a - b| and a / b
+of the linear magnitudes, in VSWR and in dB. A VSWR ratio at or above 1
+leaves the data unchanged and is counted by rejected().
+*/
+class TestTraceMath : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void complex_data();
+    void complex();
+    void normalizeShort();
+    void vswr_data();
+    void vswr();
+    void s21_data();
+    void s21();
+    void vswrRejected();
+    void inactive();
+    void otherGrid();
+};
+
+void TestTraceMath::complex_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::newRow("subtract") << int(TraceMath::Subtract);
+    QTest::newRow("divide") << int(TraceMath::Divide);
+    QTest::newRow("normalize") << int(TraceMath::Normalize);
+}
+
+void TestTraceMath::complex()
+{
+    QFETCH(int, mode);
+    QVector<qreal> freq = grid(Points);
+    QVector<Complex> data(Points), memory(Points);
+    for(int i = 0; i < Points; i++)
+    {
+        data[i] = std::polar(0.1 + 0.04 * i, 0.3 * i);
+        memory[i] = std::polar(0.9 - 0.02 * i, -0.2 * i);
+    }
+    TraceMath math;
+    math.setMode(TraceMath::Mode(mode));
+    math.setMemory(riSweep(freq, memory));
+    QVERIFY(math.isActive());
+    Sweep out = math.apply(riSweep(freq, data));
+    QCOMPARE(out.kind(), Sweep::Ri);
+    QCOMPARE(out.size(), Points);
+    QCOMPARE(math.coverage(), 1.0);
+    for(int i = 0; i < Points; i++)
+    {
+        Complex expected;
+        if(mode == TraceMath::Subtract) expected = data[i] - memory[i];
+        else if(mode == TraceMath::Divide) expected = data[i] / memory[i];
+        else expected = -data[i] / memory[i];
+        QPointF g = out.ri()[i];
+        QVERIFY(abs(Complex(g.x(), g.y()) - expected) < 1e-12);
+        QCOMPARE(out.freq()[i], freq[i]);
+    }
+}
+
+void TestTraceMath::normalizeShort()
+//a short as the memory, normalizing gives the data back
+{
+    QVector<qreal> freq = grid(Points);
+    QVector<Complex> data(Points);
+    for(int i = 0; i < Points; i++)
+        data[i] = std::polar(0.5, 0.7 * i);
+    TraceMath math;
+    math.setMode(TraceMath::Normalize);
+    math.setMemory(riSweep(freq, QVector<Complex>(Points, Complex(-1))));
+    Sweep out = math.apply(riSweep(freq, data));
+    for(int i = 0; i < Points; i++)
+    {
+        QPointF g = out.ri()[i];
+        QVERIFY(abs(Complex(g.x(), g.y()) - data[i]) < 1e-12);
+    }
+}
+
+void TestTraceMath::vswr_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<qreal>("data");
+    QTest::addColumn<qreal>("memory");
+    QTest::addColumn<qreal>("result");
+    //|G| 0.5 and 0.2: |0.5 - 0.2| = 0.3 is VSWR 1.3 / 0.7
+    QTest::newRow("subtract") << int(TraceMath::Subtract) << 3.0 << 1.5 << 1.3 / 0.7;
+    //the other way round the magnitude of the difference is the same
+    QTest::newRow("subtract, memory larger") << int(TraceMath::Subtract) << 1.5 << 3.0 << 1.3 / 0.7;
+    //0.2 / 0.5 = 0.4 is VSWR 1.4 / 0.6
+    QTest::newRow("divide") << int(TraceMath::Divide) << 1.5 << 3.0 << 1.4 / 0.6;
+    QTest::newRow("normalize") << int(TraceMath::Normalize) << 1.5 << 3.0 << 1.4 / 0.6;
+    QTest::newRow("equal") << int(TraceMath::Subtract) << 2.0 << 2.0 << 1.0;
+}
+
+void TestTraceMath::vswr()
+{
+    QFETCH(int, mode);
+    QFETCH(qreal, data);
+    QFETCH(qreal, memory);
+    QFETCH(qreal, result);
+    TraceMath math;
+    math.setMode(TraceMath::Mode(mode));
+    math.setMemory(scalarSweep(Sweep::Vswr, QVector<qreal>(Points, memory)));
+    Sweep out = math.apply(scalarSweep(Sweep::Vswr, QVector<qreal>(Points, data)));
+    QCOMPARE(math.rejected(), 0);
+    QCOMPARE(out.kind(), Sweep::Vswr);
+    for(int i = 0; i < Points; i++)
+        QVERIFY(fabs(out.value()[i] - result) < 1e-12);
+}
+
+void TestTraceMath::s21_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<qreal>("data");
+    QTest::addColumn<qreal>("memory");
+    QTest::addColumn<qreal>("result");
+    //-6 dB against a -10 dB thru is +4 dB
+    QTest::newRow("divide") << int(TraceMath::Divide) << -6.0 << -10.0 << 4.0;
+    QTest::newRow("normalize") << int(TraceMath::Normalize) << -6.0 << -10.0 << 4.0;
+    //0 dB - 0 dB has no magnitude left, the floor is -300 dB
+    QTest::newRow("subtract equal") << int(TraceMath::Subtract) << 0.0 << 0.0 << -300.0;
+    //1 - 0.5 in magnitude is -6.02 dB
+    QTest::newRow("subtract") << int(TraceMath::Subtract) << 0.0 << 20 * log10(0.5) << 20 * log10(0.5);
+}
+
+void TestTraceMath::s21()
+{
+    QFETCH(int, mode);
+    QFETCH(qreal, data);
+    QFETCH(qreal, memory);
+    QFETCH(qreal, result);
+    TraceMath math;
+    math.setMode(TraceMath::Mode(mode));
+    math.setMemory(scalarSweep(Sweep::S21, QVector<qreal>(Points, memory)));
+    Sweep out = math.apply(scalarSweep(Sweep::S21, QVector<qreal>(Points, data)));
+    QCOMPARE(out.kind(), Sweep::S21);
+    for(int i = 0; i < Points; i++)
+        QVERIFY(fabs(out.value()[i] - result) < 1e-9);
+}
+
+void TestTraceMath::vswrRejected()
+{
+    //|G| 0.5 over 1 / 3 is a ratio of 1.5, one point is enough to leave the data as it was
+    QVector<qreal> values(Points, 1.5);
+    values[7] = 3.0;
+    Sweep data = scalarSweep(Sweep::Vswr, values);
+    TraceMath math;
+    math.setMode(TraceMath::Divide);
+    math.setMemory(scalarSweep(Sweep::Vswr, QVector<qreal>(Points, 2.0)));
+    Sweep out = math.apply(data);
+    QCOMPARE(math.rejected(), 1);
+    QCOMPARE(out.serial(), data.serial());
+
+    //a ratio of exactly 1 has no VSWR either
+    Sweep equal = scalarSweep(Sweep::Vswr, QVector<qreal>(Points, 2.0));
+    out = math.apply(equal);
+    QCOMPARE(math.rejected(), Points);
+    QCOMPARE(out.serial(), equal.serial());
+
+    //below the memory everywhere it is combined again, 0.2 / (1 / 3) = 0.6 is VSWR 4
+    out = math.apply(scalarSweep(Sweep::Vswr, QVector<qreal>(Points, 1.5)));
+    QCOMPARE(math.rejected(), 0);
+    QVERIFY(fabs(out.value()[0] - 4) < 1e-12);
+}
+
+void TestTraceMath::inactive()
+{
+    Sweep data = scalarSweep(Sweep::Vswr, QVector<qreal>(Points, 1.5));
+    TraceMath math;
+    QVERIFY(!math.isActive());
+    QCOMPARE(math.apply(data).serial(), data.serial());
+    //a memory but no mode
+    math.setMemory(scalarSweep(Sweep::Vswr, QVector<qreal>(Points, 2.0)));
+    QCOMPARE(math.apply(data).serial(), data.serial());
+    //a memory of another kind
+    math.setMode(TraceMath::Divide);
+    math.setMemory(scalarSweep(Sweep::S21, QVector<qreal>(Points, -3.0)));
+    QCOMPARE(math.apply(data).serial(), data.serial());
+    math.clearMemory();
+    QVERIFY(!math.isActive());
+}
+
+void TestTraceMath::otherGrid()
+//a memory of 11 points is resampled onto the 41 of the data, half of them outside
+{
+    QVector<qreal> memoryFreq(11), dataFreq(41);
+    QVector<Complex> memory(11), data(41, Complex(0.5, 0));
+    for(int i = 0; i < 11; i++)
+    {
+        memoryFreq[i] = 100e6 + 10e6 * i;
+        memory[i] = std::polar(0.5, 0.1 * i);
+    }
+    for(int i = 0; i < 41; i++)
+        dataFreq[i] = 150e6 + 2.5e6 * i;
+    TraceMath math;
+    math.setMode(TraceMath::Divide);
+    math.setMemory(riSweep(memoryFreq, memory));
+    Sweep out = math.apply(riSweep(dataFreq, data));
+    QCOMPARE(out.size(), 41);
+    QCOMPARE(math.coverage(), 21 / 41.0);
+    for(int i = 0; i < 41; i++)
+    {
+        //0.5 / (0.5 at the interpolated phase), the last memory point past its span
+        qreal phase = qMin(0.1 * (dataFreq[i] - 100e6) / 10e6, 1.0);
+        QPointF g = out.ri()[i];
+        QVERIFY(abs(Complex(g.x(), g.y()) - std::polar(1.0, -phase)) < 1e-9);
+    }
+}
+
+QTEST_APPLESS_MAIN(TestTraceMath)
+
+#include "tst_tracemath.moc"
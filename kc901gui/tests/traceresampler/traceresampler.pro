@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Resampling of traces between frequency grids
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=gnu++11
+
+TARGET = tst_traceresampler
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_traceresampler.cpp \
+    ../../traceresampler.cpp
+
+HEADERS += ../../traceresampler.h
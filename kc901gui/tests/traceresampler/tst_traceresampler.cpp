@@ -0,0 +1,178 @@
+#include <QtTest>
+#include <math.h>
+#include "traceresampler.h"
+
+static QVector<qreal> grid(qreal start, qreal stop, int points)
+{
+    QVector<qreal> freq(points);
+    for(int i = 0; i < points; i++)
+        freq[i] = start + (stop - start) * i / (points - 1);
+    return freq;
+}
+
+static qreal magnitude(const QPointF &p)
+{
+    return sqrt(p.x() * p.x() + p.y() * p.y());
+}
+
+/// Traces resampled onto their own grid, a finer one and a shifted one
+/**
+On its own grid a trace comes back unchanged. Between two source points
+a reflection turning by 90 degrees per point keeps its magnitude and
+takes the phase halfway, along the shorter arc across 180 degrees too.
+Targets past the source span take the end values and coverage() is
+the fraction inside.
+*/
+class TestTraceResampler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sameGrid();
+    void finerGrid();
+    void shorterArc();
+    void magnitudeLinear();
+    void offsetGrid();
+    void scalar();
+    void cachedTables();
+};
+
+void TestTraceResampler::sameGrid()
+{
+    QVector<qreal> freq = grid(100e6, 200e6, 101);
+    QVector<QPointF> ri(freq.size());
+    QVector<qreal> db(freq.size());
+    for(int i = 0; i < freq.size(); i++)
+    {
+        ri[i] = QPointF(0.8 * cos(i * 1.3), 0.8 * sin(i * 1.3));
+        db[i] = -20 + 0.37 * i;
+    }
+    TraceResampler resampler;
+    QVector<QPointF> outRi = resampler.resample(freq, ri, freq);
+    QCOMPARE(resampler.coverage(), 1.0);
+    QVector<qreal> outDb = resampler.resample(freq, db, freq);
+    QCOMPARE(outRi.size(), ri.size());
+    QCOMPARE(outDb.size(), db.size());
+    for(int i = 0; i < freq.size(); i++)
+    {
+        QCOMPARE(outRi[i], ri[i]);
+        QCOMPARE(outDb[i], db[i]);
+    }
+}
+
+void TestTraceResampler::finerGrid()
+//90 degrees per source point, re / im interpolation would fall to 0.71 of the magnitude
+{
+    QVector<qreal> from = grid(100e6, 200e6, 11);
+    QVector<QPointF> ri(from.size());
+    for(int i = 0; i < from.size(); i++)
+        ri[i] = QPointF(0.9 * cos(i * M_PI / 2), 0.9 * sin(i * M_PI / 2));
+    QVector<qreal> to = grid(100e6, 200e6, 41);
+    TraceResampler resampler;
+    QVector<QPointF> out = resampler.resample(from, ri, to);
+    QCOMPARE(out.size(), to.size());
+    QCOMPARE(resampler.coverage(), 1.0);
+    for(int i = 0; i < to.size(); i++)
+    {
+        QVERIFY(fabs(magnitude(out[i]) - 0.9) < 1e-12);
+        //a quarter of the way is 22.5 degrees further
+        qreal phase = atan2(out[i].y(), out[i].x());
+        qreal expected = remainder(i * M_PI / 8, 2 * M_PI);
+        QVERIFY(fabs(remainder(phase - expected, 2 * M_PI)) < 1e-9);
+    }
+}
+
+void TestTraceResampler::shorterArc()
+{
+    QVector<qreal> from = grid(0, 1, 2);
+    QVector<QPointF> ri;
+    ri << QPointF(cos(M_PI * 170 / 180), sin(M_PI * 170 / 180))
+       << QPointF(cos(-M_PI * 170 / 180), sin(-M_PI * 170 / 180));
+    TraceResampler resampler;
+    QVector<QPointF> out = resampler.resample(from, ri, QVector<qreal>(1, 0.5));
+    //halfway is -1 across 180 degrees, not +1 the long way round
+    QVERIFY(fabs(out[0].x() + 1) < 1e-12);
+    QVERIFY(fabs(out[0].y()) < 1e-12);
+}
+
+void TestTraceResampler::magnitudeLinear()
+{
+    QVector<qreal> from = grid(0, 1, 2);
+    QVector<QPointF> ri;
+    ri << QPointF(0.2, 0) << QPointF(0, 0.6);
+    TraceResampler resampler;
+    QVector<QPointF> out = resampler.resample(from, ri, grid(0, 1, 5));
+    for(int i = 0; i < 5; i++)
+    {
+        qreal w = i / 4.0;
+        QVERIFY(fabs(magnitude(out[i]) - (0.2 + 0.4 * w)) < 1e-12);
+        QVERIFY(fabs(atan2(out[i].y(), out[i].x()) - w * M_PI / 2) < 1e-12);
+    }
+}
+
+void TestTraceResampler::offsetGrid()
+//the target starts in the middle of the source and runs on as far again
+{
+    QVector<qreal> from = grid(100e6, 200e6, 101);
+    QVector<qreal> values(from.size());
+    for(int i = 0; i < from.size(); i++)
+        values[i] = 2 * i;
+    QVector<qreal> to = grid(150.5e6, 250.5e6, 101);
+    TraceResampler resampler;
+    QVector<qreal> out = resampler.resample(from, values, to);
+    //150.5 .. 199.5 MHz are inside
+    QCOMPARE(resampler.coverage(), 50 / 101.0);
+    for(int i = 0; i < to.size(); i++)
+    {
+        qreal expected = to[i] <= 200e6 ? 2 * (to[i] - 100e6) / 1e6 : values.last();
+        QVERIFY(fabs(out[i] - expected) < 1e-9);
+    }
+
+    //below the source span the first value is held
+    out = resampler.resample(from, values, grid(50e6, 100e6, 11));
+    QCOMPARE(resampler.coverage(), 1 / 11.0);
+    for(int i = 0; i < out.size(); i++)
+        QCOMPARE(out[i], values.first());
+
+    //disjoint spans
+    resampler.resample(from, values, grid(300e6, 400e6, 11));
+    QCOMPARE(resampler.coverage(), 0.0);
+}
+
+void TestTraceResampler::scalar()
+{
+    QVector<qreal> from = grid(100e6, 200e6, 3);
+    QVector<qreal> values;
+    values << -10 << -30 << -20;
+    TraceResampler resampler;
+    QVector<qreal> out = resampler.resample(from, values, grid(100e6, 200e6, 9));
+    qreal expected[] = { -10, -15, -20, -25, -30, -27.5, -25, -22.5, -20 };
+    for(int i = 0; i < 9; i++)
+        QVERIFY(fabs(out[i] - expected[i]) < 1e-12);
+    //sizes that do not match give nothing
+    QVERIFY(resampler.resample(from, QVector<qreal>(2, 0.0), from).isEmpty());
+}
+
+void TestTraceResampler::cachedTables()
+//alternating between more grids than are cached gives the same results
+{
+    QVector<qreal> from = grid(100e6, 200e6, 51);
+    QVector<qreal> values(from.size());
+    for(int i = 0; i < from.size(); i++)
+        values[i] = sin(i * 0.3);
+    TraceResampler resampler;
+    QVector<QVector<qreal> > targets;
+    QVector<QVector<qreal> > first;
+    for(int k = 0; k < 6; k++)
+    {
+        targets.append(grid(110e6 + k * 1e6, 190e6 - k * 2e6, 31 + 10 * k));
+        first.append(resampler.resample(from, values, targets[k]));
+    }
+    for(int pass = 0; pass < 3; pass++)
+        for(int k = 5; k >= 0; k--)
+            QVERIFY(resampler.resample(from, values, targets[k]) == first[k]);
+}
+
+QTEST_APPLESS_MAIN(TestTraceResampler)
+
+#include "tst_traceresampler.moc"
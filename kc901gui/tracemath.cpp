@@ -0,0 +1,123 @@
+#include "tracemath.h"
+#include <math.h>
+
+// scalar columns to a linear magnitude and back
+static qreal toMagnitude(Sweep::Kind kind, qreal v)
+{
+    if(kind == Sweep::Vswr) return (v - 1) / (v + 1);
+    return pow(10.0, v / 20);
+}
+
+static qreal fromMagnitude(Sweep::Kind kind, qreal m)
+{
+    if(kind == Sweep::Vswr) return (1 + m) / (1 - m);
+    return 20 * log10(qMax(m, 1e-15));
+}
+
+TraceMath::TraceMath() :
+    m_mode(Off),
+    m_serial(0),
+    m_points(0),
+    m_fstart(0),
+    m_fstop(0),
+    m_rejected(0)
+{
+}
+
+void TraceMath::setMemory(const Sweep &sweep)
+{
+    m_memory = sweep;
+    m_points = 0;
+}
+
+void TraceMath::clearMemory()
+{
+    m_memory = Sweep();
+    m_points = 0;
+    memRi.clear();
+    memMag.clear();
+    resampler.clear();
+}
+
+void TraceMath::prepare(const QVector<qreal> &freq)
+{
+    int n = freq.size();
+    if(m_serial == m_memory.serial() && n == m_points
+            && (n == 0 || (freq.first() == m_fstart && freq.last() == m_fstop)))
+        return;
+
+    if(m_memory.kind() == Sweep::Ri)
+    {
+        memRi = resampler.resample(m_memory.freq(), m_memory.ri(), freq);
+    }
+    else
+    {
+        Sweep::Kind kind = m_memory.kind();
+        memMag = resampler.resample(m_memory.freq(), m_memory.value(), freq);
+        for(int i = 0; i < memMag.size(); i++)
+            memMag[i] = toMagnitude(kind, memMag[i]);
+    }
+    m_serial = m_memory.serial();
+    m_points = n;
+    m_fstart = n > 0 ? freq.first() : 0;
+    m_fstop = n > 0 ? freq.last() : 0;
+}
+
+Sweep TraceMath::apply(const Sweep &data)
+{
+    m_rejected = 0;
+    if(!isActive() || data.kind() != m_memory.kind() || data.size() == 0) return data;
+
+    const QVector<qreal> &freq = data.freq();
+    int n = freq.size();
+    prepare(freq);
+
+    Sweep out = Sweep::create(data.kind(), n);
+    qreal *f = out.freqData();
+    for(int i = 0; i < n; i++)
+        f[i] = freq[i];
+
+    if(data.kind() == Sweep::Ri)
+    {
+        QPointF *g = out.riData();
+        const QPointF *in = data.ri().constData();
+        const QPointF *m = memRi.constData();
+        for(int i = 0; i < n; i++)
+        {
+            qreal gr = in[i].x(), gi = in[i].y();
+            qreal mr = m[i].x(), mi = m[i].y();
+            if(m_mode == Subtract)
+            {
+                g[i] = QPointF(gr - mr, gi - mi);
+                continue;
+            }
+            qreal den = mr*mr + mi*mi;
+            qreal sign = m_mode == Normalize ? -1 : 1;
+            g[i] = den > 0 ? QPointF(sign * (gr*mr + gi*mi) / den, sign * (gi*mr - gr*mi) / den) : QPointF(0, 0);
+        }
+        return out;
+    }
+
+    Sweep::Kind kind = data.kind();
+    qreal *v = out.valueData();
+    const qreal *in = data.value().constData();
+    const qreal *m = memMag.constData();
+    for(int i = 0; i < n; i++)
+    {
+        qreal a = toMagnitude(kind, in[i]);
+        if(m_mode == Subtract)
+        {
+            v[i] = fromMagnitude(kind, fabs(a - m[i]));
+            continue;
+        }
+        qreal ratio = m[i] > 0 ? a / m[i] : 0;
+        //a reflection above the memory has no vswr
+        if(kind == Sweep::Vswr && ratio >= 1)
+        {
+            m_rejected++;
+            continue;
+        }
+        v[i] = fromMagnitude(kind, ratio);
+    }
+    return m_rejected > 0 ? data : out;
+}
@@ -0,0 +1,73 @@
+#ifndef TRACEMATH_H
+#define TRACEMATH_H
+
+#include <QVector>
+#include <QPointF>
+#include "sweep.h"
+#include "traceresampler.h"
+
+/// Memory trace and data / memory math
+/**
+The memory is a stored sweep, it is resampled onto the grid of every
+live sweep so it stays usable after a span change, an auto refine or a
+recalled history entry. The resampled memory is kept until the grid or
+the memory changes, per sweep only the math pass itself is left.
+
+RI sweeps are combined as complex reflections:
+
+    Subtract     G - Gm        leakage, the difference of two DUTs
+    Divide       G / Gm        response relative to the memory
+    Normalize    -G / Gm       the memory is a short, G = -1
+
+Scalar sweeps only carry magnitudes. VSWR is taken to |G| and dB to a
+linear magnitude, subtracted as |a - b| or divided, and converted back;
+for an S21 sweep Normalize is the division with the memory as a thru.
+The result is a sweep of the same kind and grid, the views, the limit
+test and the analyses see it like a measured one. A VSWR ratio of |G|
+at or above 1 has no VSWR: such a sweep is not combined, it passes
+unchanged and rejected() counts the points.
+*/
+class TraceMath
+{
+public:
+    enum Mode {
+        Off = 0,
+        Subtract,
+        Divide,
+        Normalize
+    };
+
+    TraceMath();
+
+    void setMode(Mode mode) { m_mode = mode; }
+    Mode mode() const { return m_mode; }
+
+    void setMemory(const Sweep &sweep);
+    void clearMemory();
+    const Sweep &memory() const { return m_memory; }
+    bool isActive() const { return m_mode != Off && !m_memory.isNull(); }
+
+    /// Data combined with the memory, data itself when off or of another kind
+    Sweep apply(const Sweep &data);
+    /// Fraction of the last data grid covered by the memory
+    qreal coverage() const { return resampler.coverage(); }
+    /// Points of the last data without a VSWR for the ratio, 0 when it was combined
+    int rejected() const { return m_rejected; }
+
+private:
+    void prepare(const QVector<qreal> &freq);
+
+    Mode m_mode;
+    Sweep m_memory;
+    TraceResampler resampler;
+
+    // memory on the grid of the last sweep, linear magnitudes for scalar sweeps
+    quint64 m_serial;
+    int m_points;
+    qreal m_fstart, m_fstop;
+    QVector<QPointF> memRi;
+    QVector<qreal> memMag;
+    int m_rejected;
+};
+
+#endif // TRACEMATH_H
@@ -0,0 +1,187 @@
+#include "traceprocessor.h"
+
+TraceProcessor::TraceProcessor() :
+    m_mode(Off),
+    m_count(16),
+    m_sweeps(0),
+    m_complex(false),
+    m_points(0),
+    m_fstart(0),
+    m_fstop(0),
+    ringHead(0)
+{
+}
+
+void TraceProcessor::setMode(Mode mode)
+{
+    if(mode == m_mode) return;
+    m_mode = mode;
+    reset();
+}
+
+void TraceProcessor::setCount(int count)
+{
+    if(count < 1) count = 1;
+    if(count == m_count) return;
+    m_count = count;
+    reset();
+}
+
+void TraceProcessor::reset()
+{
+    //accumulators are cleared by the next prepare(), buffers are kept
+    m_sweeps = 0;
+}
+
+const QVector<QPointF> &TraceProcessor::process(const QVector<qreal> &freq, const QVector<QPointF> &data)
+{
+    prepare(freq, true);
+    //QPointF is two packed qreals, walk it as an interleaved re/im array
+    const qreal *p = reinterpret_cast<const qreal *>(data.constData());
+    accumulate(p, p + 1, 2);
+
+    for(int i = 0; i < m_points; i++)
+        outComplex[i] = QPointF(accRe[i], accIm[i]);
+    return outComplex;
+}
+
+const QVector<qreal> &TraceProcessor::process(const QVector<qreal> &freq, const QVector<qreal> &data)
+{
+    prepare(freq, false);
+    accumulate(data.constData(), 0, 1);
+
+    for(int i = 0; i < m_points; i++)
+        outScalar[i] = accRe[i];
+    return outScalar;
+}
+
+void TraceProcessor::prepare(const QVector<qreal> &freq, bool complex)
+{
+    int n = freq.size();
+    bool gridChanged = n != m_points
+            || (n > 0 && (freq.first() != m_fstart || freq.last() != m_fstop));
+    if(!gridChanged && complex == m_complex && m_sweeps > 0) return;
+
+    //new grid or restart: size the buffers, same size keeps the allocation
+    m_points = n;
+    m_fstart = n > 0 ? freq.first() : 0;
+    m_fstop = n > 0 ? freq.last() : 0;
+    m_complex = complex;
+    m_sweeps = 0;
+    ringHead = 0;
+
+    accRe.resize(n);
+    accIm.resize(n);
+    accIm.fill(0);
+    if(m_mode == BoxcarAverage)
+    {
+        sumRe.resize(n);
+        sumIm.resize(n);
+        sumRe.fill(0);
+        sumIm.fill(0);
+        ringRe.resize(n * m_count);
+        ringIm.resize(n * m_count);
+        ringRe.fill(0);
+        ringIm.fill(0);
+    }
+    if(complex)
+        outComplex.resize(n);
+    else
+        outScalar.resize(n);
+}
+
+void TraceProcessor::accumulate(const qreal *re, const qreal *im, int stride)
+{
+    const int n = m_points;
+    const int k = ++m_sweeps;
+    qreal *aRe = accRe.data();
+    qreal *aIm = accIm.data();
+
+    if(m_mode == Off || k == 1)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            aRe[i] = re[i * stride];
+            aIm[i] = im ? im[i * stride] : 0;
+        }
+        if(m_mode != BoxcarAverage) return;
+    }
+
+    switch(m_mode)
+    {
+    case ExpAverage:
+    {
+        //plain mean until the filter is full, then exponential with 1/count
+        qreal w = 1.0 / qMin(k, m_count);
+        for(int i = 0; i < n; i++)
+        {
+            aRe[i] += w * (re[i * stride] - aRe[i]);
+            if(im) aIm[i] += w * (im[i * stride] - aIm[i]);
+        }
+        break;
+    }
+    case BoxcarAverage:
+    {
+        //running sum over a ring of the last count sweeps
+        qreal *rRe = ringRe.data() + ringHead * n;
+        qreal *rIm = ringIm.data() + ringHead * n;
+        qreal *sRe = sumRe.data();
+        qreal *sIm = sumIm.data();
+        qreal w = 1.0 / qMin(k, m_count);
+        for(int i = 0; i < n; i++)
+        {
+            qreal xRe = re[i * stride];
+            qreal xIm = im ? im[i * stride] : 0;
+            sRe[i] += xRe - rRe[i];
+            sIm[i] += xIm - rIm[i];
+            rRe[i] = xRe;
+            rIm[i] = xIm;
+            aRe[i] = sRe[i] * w;
+            aIm[i] = sIm[i] * w;
+        }
+        ringHead = (ringHead + 1) % m_count;
+        //the running sum drifts, rebuild it once per ring turn (amortised O(points))
+        if(ringHead == 0 && k > m_count)
+            resumBoxcar();
+        break;
+    }
+    case MaxHold:
+    case MinHold:
+    {
+        bool max = m_mode == MaxHold;
+        for(int i = 0; i < n; i++)
+        {
+            qreal xRe = re[i * stride];
+            qreal xIm = im ? im[i * stride] : 0;
+            //complex traces compare |x|, scalar traces compare the signed value
+            qreal x = im ? xRe * xRe + xIm * xIm : xRe;
+            qreal a = im ? aRe[i] * aRe[i] + aIm[i] * aIm[i] : aRe[i];
+            if(max ? x > a : x < a)
+            {
+                aRe[i] = xRe;
+                aIm[i] = xIm;
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void TraceProcessor::resumBoxcar()
+{
+    const int n = m_points;
+    sumRe.fill(0);
+    sumIm.fill(0);
+    for(int s = 0; s < m_count; s++)
+    {
+        const qreal *rRe = ringRe.constData() + s * n;
+        const qreal *rIm = ringIm.constData() + s * n;
+        for(int i = 0; i < n; i++)
+        {
+            sumRe[i] += rRe[i];
+            sumIm[i] += rIm[i];
+        }
+    }
+}
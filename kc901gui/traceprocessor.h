@@ -0,0 +1,66 @@
+#ifndef TRACEPROCESSOR_H
+#define TRACEPROCESSOR_H
+
+#include <QVector>
+#include <QPointF>
+
+/// Sweep to sweep trace math
+/**
+Runs exponential / boxcar averaging and max / min hold over repeated
+sweeps. Every accumulator is updated in place, so a sweep costs O(points)
+and nothing is reallocated as long as the sweep grid stays the same.
+Complex (RI) traces are averaged on real and imaginary parts, holds keep
+the sample with the largest / smallest magnitude.
+*/
+class TraceProcessor
+{
+public:
+    enum Mode {
+        Off = 0,
+        ExpAverage,
+        BoxcarAverage,
+        MaxHold,
+        MinHold
+    };
+
+    TraceProcessor();
+
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+
+    /// Averaging factor, also the length of the boxcar window
+    void setCount(int count);
+    int count() const { return m_count; }
+
+    /// Number of sweeps in the accumulators
+    int sweeps() const { return m_sweeps; }
+
+    void reset();
+
+    const QVector<QPointF> &process(const QVector<qreal> &freq, const QVector<QPointF> &data);
+    const QVector<qreal> &process(const QVector<qreal> &freq, const QVector<qreal> &data);
+
+private:
+    void prepare(const QVector<qreal> &freq, bool complex);
+    void accumulate(const qreal *re, const qreal *im, int stride);
+    void resumBoxcar();
+
+    Mode m_mode;
+    int m_count;
+    int m_sweeps;
+    bool m_complex;
+
+    // grid the accumulators were sized for
+    int m_points;
+    qreal m_fstart, m_fstop;
+
+    QVector<qreal> accRe, accIm;
+    QVector<qreal> sumRe, sumIm;
+    QVector<qreal> ringRe, ringIm;
+    int ringHead;
+
+    QVector<QPointF> outComplex;
+    QVector<qreal> outScalar;
+};
+
+#endif // TRACEPROCESSOR_H
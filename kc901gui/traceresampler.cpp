@@ -0,0 +1,115 @@
+#include "traceresampler.h"
+#include <math.h>
+
+TraceResampler::TraceResampler() :
+    m_coverage(0)
+{
+}
+
+const TraceResampler::Table &TraceResampler::table(const QVector<qreal> &fromFreq, const QVector<qreal> &toFreq)
+{
+    int n = fromFreq.size(), m = toFreq.size();
+    qreal fromStart = n > 0 ? fromFreq.first() : 0, fromStop = n > 0 ? fromFreq.last() : 0;
+    qreal toStart = m > 0 ? toFreq.first() : 0, toStop = m > 0 ? toFreq.last() : 0;
+    for(int k = 0; k < tables.size(); k++)
+    {
+        const Table &t = tables[k];
+        if(t.fromPoints == n && t.fromStart == fromStart && t.fromStop == fromStop
+                && t.toPoints == m && t.toStart == toStart && t.toStop == toStop)
+        {
+            if(k > 0)
+            {
+                Table hit = tables[k];
+                tables.remove(k);
+                tables.prepend(hit);
+            }
+            return tables.first();
+        }
+    }
+
+    Table t;
+    t.fromPoints = n;
+    t.fromStart = fromStart;
+    t.fromStop = fromStop;
+    t.toPoints = m;
+    t.toStart = toStart;
+    t.toStop = toStop;
+    t.index.resize(m);
+    t.weight.resize(m);
+    int inside = 0;
+    int j = 0;
+    for(int i = 0; i < m; i++)
+    {
+        qreal f = toFreq[i];
+        //both grids ascend, the interval only moves forward
+        while(j < n - 2 && fromFreq[j + 1] < f) j++;
+        qreal w = 0;
+        if(n > 1)
+        {
+            qreal span = fromFreq[j + 1] - fromFreq[j];
+            w = span > 0 ? (f - fromFreq[j]) / span : 0;
+        }
+        if(n > 0 && f >= fromStart && f <= fromStop) inside++;
+        t.index[i] = j;
+        t.weight[i] = qBound<qreal>(0, w, 1);
+    }
+    t.coverage = m > 0 ? qreal(inside) / m : 0;
+
+    tables.prepend(t);
+    if(tables.size() > CachedTables)
+        tables.resize(CachedTables);
+    return tables.first();
+}
+
+QVector<QPointF> TraceResampler::resample(const QVector<qreal> &fromFreq, const QVector<QPointF> &from,
+                                          const QVector<qreal> &toFreq)
+{
+    QVector<QPointF> out;
+    if(from.isEmpty() || from.size() != fromFreq.size()) return out;
+    const Table &t = table(fromFreq, toFreq);
+    m_coverage = t.coverage;
+    int last = from.size() - 1;
+    out.resize(toFreq.size());
+    for(int i = 0; i < out.size(); i++)
+    {
+        const QPointF &a = from[t.index[i]];
+        const QPointF &b = from[qMin(t.index[i] + 1, last)];
+        qreal w = t.weight[i];
+        if(w == 0 || a == b)
+        {
+            out[i] = w < 1 ? a : b;
+            continue;
+        }
+        if(w == 1)
+        {
+            out[i] = b;
+            continue;
+        }
+        qreal ma = sqrt(a.x()*a.x() + a.y()*a.y());
+        qreal mb = sqrt(b.x()*b.x() + b.y()*b.y());
+        //turn of b against a, -pi .. pi
+        qreal turn = atan2(a.x()*b.y() - a.y()*b.x(), a.x()*b.x() + a.y()*b.y());
+        qreal phase = atan2(a.y(), a.x()) + w * turn;
+        qreal mag = ma + w * (mb - ma);
+        out[i] = QPointF(mag * cos(phase), mag * sin(phase));
+    }
+    return out;
+}
+
+QVector<qreal> TraceResampler::resample(const QVector<qreal> &fromFreq, const QVector<qreal> &from,
+                                        const QVector<qreal> &toFreq)
+{
+    QVector<qreal> out;
+    if(from.isEmpty() || from.size() != fromFreq.size()) return out;
+    const Table &t = table(fromFreq, toFreq);
+    m_coverage = t.coverage;
+    int last = from.size() - 1;
+    out.resize(toFreq.size());
+    for(int i = 0; i < out.size(); i++)
+    {
+        qreal a = from[t.index[i]];
+        qreal b = from[qMin(t.index[i] + 1, last)];
+        out[i] = a + t.weight[i] * (b - a);
+    }
+    return out;
+}
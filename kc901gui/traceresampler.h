@@ -0,0 +1,55 @@
+#ifndef TRACERESAMPLER_H
+#define TRACERESAMPLER_H
+
+#include <QVector>
+#include <QPointF>
+
+/// Maps a trace onto another frequency grid
+/**
+For every point of the target grid the table holds the source interval
+it falls into and the weight of the upper end, found with one merge walk
+over both sorted grids. Tables are cached per pair of grids, a grid is
+known by its point count and end frequencies as everywhere else here.
+The last few pairs are kept, switching between an auto refined span and
+the full one does not rebuild them.
+
+Complex traces are interpolated in polar form, magnitude linear and
+phase along the shorter arc. Linear re / im would pull the magnitude
+down where the phase turns quickly between two points, as it does
+behind a long cable. Targets outside the source span take the value at
+the nearest end, coverage() tells how much of the target was inside.
+*/
+class TraceResampler
+{
+public:
+    TraceResampler();
+
+    QVector<QPointF> resample(const QVector<qreal> &fromFreq, const QVector<QPointF> &from,
+                              const QVector<qreal> &toFreq);
+    QVector<qreal> resample(const QVector<qreal> &fromFreq, const QVector<qreal> &from,
+                            const QVector<qreal> &toFreq);
+
+    /// Fraction of the target points inside the source span, last call
+    qreal coverage() const { return m_coverage; }
+    void clear() { tables.clear(); }
+
+private:
+    struct Table {
+        int fromPoints;
+        qreal fromStart, fromStop;
+        int toPoints;
+        qreal toStart, toStop;
+        QVector<int> index;       // lower source point
+        QVector<qreal> weight;    // of the upper one, 0 .. 1
+        qreal coverage;
+    };
+
+    const Table &table(const QVector<qreal> &fromFreq, const QVector<qreal> &toFreq);
+
+    static const int CachedTables = 4;
+    // most recently used first
+    QVector<Table> tables;
+    qreal m_coverage;
+};
+
+#endif // TRACERESAMPLER_H
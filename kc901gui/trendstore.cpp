@@ -0,0 +1,330 @@
+#include "trendstore.h"
+#include <QFile>
+#include <QDir>
+#include <QDataStream>
+#include <qnumeric.h>
+#include <limits>
+
+static const char *FileNames[TrendStore::LevelCount] = { "raw.kpi", "minute.kpi", "hour.kpi", "day.kpi" };
+static const qreal NaN = std::numeric_limits<qreal>::quiet_NaN();
+
+// one decoded record, a raw sample is a bucket of one sweep
+struct Record {
+    qint64 time;
+    quint32 count;
+    QVector<qreal> min, max, mean;
+};
+
+static void readRecord(QDataStream &in, bool raw, int kpis, Record *r)
+{
+    r->min.resize(kpis);
+    r->max.resize(kpis);
+    r->mean.resize(kpis);
+    in >> r->time;
+    r->count = 1;
+    float v;
+    if(raw)
+    {
+        for(int k = 0; k < kpis; k++)
+        {
+            in >> v;
+            r->min[k] = r->max[k] = r->mean[k] = v;
+        }
+        return;
+    }
+    in >> r->count;
+    for(int k = 0; k < kpis; k++) { in >> v; r->min[k] = v; }
+    for(int k = 0; k < kpis; k++) { in >> v; r->max[k] = v; }
+    for(int k = 0; k < kpis; k++) { in >> v; r->mean[k] = v; }
+}
+
+TrendStore::TrendStore() :
+    m_last(0)
+{
+    for(int l = 0; l < LevelCount; l++)
+    {
+        files[l] = 0;
+        buckets[l].time = 0;
+        buckets[l].count = 0;
+    }
+}
+
+TrendStore::~TrendStore()
+{
+    close();
+}
+
+qint64 TrendStore::width(Level level)
+{
+    static const qint64 widths[LevelCount] = { 0, 60000, 3600000, 86400000 };
+    return widths[level];
+}
+
+int TrendStore::recordSize(Level level) const
+{
+    int kpis = m_names.size();
+    return level == Raw ? 8 + 4 * kpis : 8 + 4 + 12 * kpis;
+}
+
+qint64 TrendStore::records(Level level) const
+{
+    return files[level]->size() / recordSize(level);
+}
+
+bool TrendStore::open(const QString &dir, const QStringList &names, QString *error)
+{
+    close();
+    QDir store(dir);
+    if(names.isEmpty() || !store.mkpath("."))
+    {
+        if(error) *error = names.isEmpty() ? QString("no KPIs") : QString("cannot create %1").arg(dir);
+        return false;
+    }
+
+    //the record layout follows the KPI list, a store keeps the one it was created with
+    QFile namesFile(store.filePath("names.txt"));
+    if(namesFile.exists())
+    {
+        if(!namesFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            if(error) *error = namesFile.errorString();
+            return false;
+        }
+        QStringList stored = QString::fromUtf8(namesFile.readAll()).split('\n', QString::SkipEmptyParts);
+        if(stored != names)
+        {
+            if(error) *error = QString("the store holds other KPIs: %1").arg(stored.join(", "));
+            return false;
+        }
+    }
+    else
+    {
+        if(!namesFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            if(error) *error = namesFile.errorString();
+            return false;
+        }
+        namesFile.write(names.join("\n").toUtf8() + "\n");
+    }
+    namesFile.close();
+
+    m_dir = dir;
+    m_names = names;
+    for(int l = 0; l < LevelCount; l++)
+    {
+        files[l] = new QFile(store.filePath(FileNames[l]));
+        if(!files[l]->open(QIODevice::ReadWrite))
+        {
+            if(error) *error = files[l]->errorString();
+            close();
+            return false;
+        }
+        //a record cut short by a crash would shift every later one
+        qint64 whole = records(Level(l)) * recordSize(Level(l));
+        if(files[l]->size() != whole)
+            files[l]->resize(whole);
+    }
+
+    qint64 raw = records(Raw);
+    m_last = raw > 0 ? timeAt(files[Raw], Raw, raw - 1) : 0;
+    //coarse first, a bucket closed while resuming a finer level is folded upwards
+    resume(Day);
+    resume(Hour);
+    resume(Minute);
+    return true;
+}
+
+void TrendStore::close()
+//open buckets are not written, the next open rebuilds them from the finer level
+{
+    for(int l = 0; l < LevelCount; l++)
+    {
+        delete files[l];
+        files[l] = 0;
+        buckets[l].count = 0;
+    }
+    m_names.clear();
+    m_last = 0;
+}
+
+qint64 TrendStore::timeAt(QFile *file, Level level, qint64 record) const
+{
+    file->seek(record * recordSize(level));
+    QDataStream in(file);
+    qint64 time;
+    in >> time;
+    return time;
+}
+
+qint64 TrendStore::search(QFile *file, Level level, qint64 time) const
+//first record at or after time
+{
+    qint64 lo = 0, hi = records(level);
+    while(lo < hi)
+    {
+        qint64 mid = (lo + hi) / 2;
+        if(timeAt(file, level, mid) < time) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void TrendStore::resume(Level level)
+//fold the finer records after the last written bucket back into the open one
+{
+    Level finer = Level(level - 1);
+    qint64 written = records(level);
+    qint64 start = written > 0 ? timeAt(files[level], level, written - 1) + width(level) : 0;
+    qint64 first = search(files[finer], finer, start);
+    qint64 end = records(finer);
+    if(first >= end) return;
+
+    files[finer]->seek(first * recordSize(finer));
+    QDataStream in(files[finer]);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    Record r;
+    for(qint64 i = first; i < end; i++)
+    {
+        readRecord(in, finer == Raw, m_names.size(), &r);
+        fold(level, r.time, r.count, r.min.constData(), r.max.constData(), r.mean.constData());
+    }
+}
+
+void TrendStore::append(qint64 timestamp, const QVector<qreal> &values)
+{
+    if(!isOpen() || values.size() != m_names.size()) return;
+    //the files are searched by time, keep them sorted
+    timestamp = qMax(timestamp, m_last);
+    m_last = timestamp;
+
+    QFile *file = files[Raw];
+    file->seek(file->size());
+    QDataStream out(file);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << timestamp;
+    for(int k = 0; k < values.size(); k++)
+        out << float(values[k]);
+    file->flush();
+
+    fold(Minute, timestamp, 1, values.constData(), values.constData(), values.constData());
+}
+
+void TrendStore::fold(Level level, qint64 time, quint32 count, const qreal *min, const qreal *max, const qreal *mean)
+{
+    Bucket &b = buckets[level];
+    qint64 start = time - time % width(level);
+    if(b.count > 0 && b.time != start)
+        flush(level);
+    int kpis = m_names.size();
+    if(b.count == 0)
+    {
+        b.time = start;
+        b.min.resize(kpis);
+        b.max.resize(kpis);
+        b.sum.fill(0, kpis);
+        b.weight.fill(0, kpis);
+    }
+    b.count += count;
+    for(int k = 0; k < kpis; k++)
+    {
+        if(qIsNaN(mean[k])) continue;
+        if(b.weight[k] == 0)
+        {
+            b.min[k] = min[k];
+            b.max[k] = max[k];
+        }
+        else
+        {
+            b.min[k] = qMin(b.min[k], min[k]);
+            b.max[k] = qMax(b.max[k], max[k]);
+        }
+        b.sum[k] += mean[k] * count;
+        b.weight[k] += count;
+    }
+}
+
+void TrendStore::flush(Level level)
+//write the bucket and fold it into the next level
+{
+    Bucket &b = buckets[level];
+    if(b.count == 0) return;
+    int kpis = m_names.size();
+    QVector<qreal> min(kpis, NaN), max(kpis, NaN), mean(kpis, NaN);
+    for(int k = 0; k < kpis; k++)
+    {
+        if(b.weight[k] == 0) continue;
+        min[k] = b.min[k];
+        max[k] = b.max[k];
+        mean[k] = b.sum[k] / b.weight[k];
+    }
+
+    QFile *file = files[level];
+    file->seek(file->size());
+    QDataStream out(file);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << b.time << b.count;
+    for(int k = 0; k < kpis; k++) out << float(min[k]);
+    for(int k = 0; k < kpis; k++) out << float(max[k]);
+    for(int k = 0; k < kpis; k++) out << float(mean[k]);
+    file->flush();
+
+    quint32 count = b.count;
+    b.count = 0;
+    if(level + 1 < LevelCount)
+        fold(Level(level + 1), b.time, count, min.constData(), max.constData(), mean.constData());
+}
+
+QVector<TrendStore::Point> TrendStore::query(int kpi, qint64 from, qint64 to, int maxPoints, Level *level) const
+{
+    QVector<Point> points;
+    if(!isOpen() || kpi < 0 || kpi >= m_names.size()) return points;
+
+    //finest level that fits, buckets that overlap from included
+    Level chosen = Day;
+    qint64 first = 0, last = 0;
+    for(int l = Raw; l < LevelCount; l++)
+    {
+        first = search(files[l], Level(l), from - width(Level(l)));
+        last = search(files[l], Level(l), to + 1);
+        if(last - first <= maxPoints || l == Day)
+        {
+            chosen = Level(l);
+            break;
+        }
+    }
+    if(level) *level = chosen;
+
+    points.reserve(last - first + 1);
+    QFile *file = files[chosen];
+    file->seek(first * recordSize(chosen));
+    QDataStream in(file);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    Record r;
+    for(qint64 i = first; i < last; i++)
+    {
+        readRecord(in, chosen == Raw, m_names.size(), &r);
+        Point p = { r.time, r.count, r.min[kpi], r.max[kpi], r.mean[kpi] };
+        points.append(p);
+    }
+
+    //the bucket still being filled
+    const Bucket &b = buckets[chosen];
+    if(chosen != Raw && b.count > 0 && b.time <= to && b.time + width(chosen) > from)
+    {
+        Point p = { b.time, b.count, NaN, NaN, NaN };
+        if(b.weight[kpi] > 0)
+        {
+            p.min = b.min[kpi];
+            p.max = b.max[kpi];
+            p.mean = b.sum[kpi] / b.weight[kpi];
+        }
+        points.append(p);
+    }
+    return points;
+}
+
+qint64 TrendStore::firstTime() const
+{
+    if(!isOpen() || records(Raw) == 0) return 0;
+    return timeAt(files[Raw], Raw, 0);
+}
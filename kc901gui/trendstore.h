@@ -0,0 +1,93 @@
+#ifndef TRENDSTORE_H
+#define TRENDSTORE_H
+
+#include <QVector>
+#include <QStringList>
+
+class QFile;
+
+/// Append-only KPI time series with minute, hour and day rollups
+/**
+A store is a directory with the KPI names (names.txt, one per line) and
+one file per level of fixed size records, big endian:
+
+    raw.kpi      qint64 time (ms since the epoch), float value[kpis]
+    minute.kpi   qint64 bucket start, quint32 sweeps,
+    hour.kpi       float min[kpis], float max[kpis], float mean[kpis]
+    day.kpi
+
+Every sweep appends a raw record and is folded into the open minute
+bucket. A bucket is written when the first sample of the next one
+arrives and is folded into the level above, so each file only ever
+grows and stays sorted by time. Means are weighted by the sweep count,
+NaN values are skipped.
+
+Open buckets live in memory only. Opening a store rebuilds them from
+the tail of the finer level, so restarting the application continues
+the same buckets instead of writing a second partial record.
+
+A query reads the finest level that fits the requested number of
+points, found by a binary search on the fixed size records: years of
+history come from the day file, a few kilobytes.
+*/
+class TrendStore
+{
+public:
+    enum Level {
+        Raw = 0,
+        Minute,
+        Hour,
+        Day,
+        LevelCount
+    };
+
+    struct Point {
+        qint64 time;        // bucket start, ms since the epoch
+        quint32 count;      // sweeps in the bucket
+        qreal min, max, mean;
+    };
+
+    TrendStore();
+    ~TrendStore();
+
+    /// Opens or creates the store in dir, its KPIs have to be names
+    bool open(const QString &dir, const QStringList &names, QString *error = 0);
+    void close();
+    bool isOpen() const { return files[Raw] != 0; }
+    const QStringList &names() const { return m_names; }
+
+    /// Timestamps going backwards are clamped to the last one
+    void append(qint64 timestamp, const QVector<qreal> &values);
+
+    /// Buckets of one KPI in [from, to] from the finest level with at most maxPoints
+    QVector<Point> query(int kpi, qint64 from, qint64 to, int maxPoints, Level *level = 0) const;
+    qint64 firstTime() const;
+    qint64 lastTime() const { return m_last; }
+
+    /// Bucket width in ms, 0 for raw
+    static qint64 width(Level level);
+
+private:
+    struct Bucket {
+        qint64 time;
+        quint32 count;
+        QVector<qreal> min, max, sum;
+        QVector<quint32> weight;
+    };
+
+    int recordSize(Level level) const;
+    qint64 records(Level level) const;
+    qint64 timeAt(QFile *file, Level level, qint64 record) const;
+    qint64 search(QFile *file, Level level, qint64 time) const;
+    void fold(Level level, qint64 time, quint32 count, const qreal *min, const qreal *max, const qreal *mean);
+    void flush(Level level);
+    void resume(Level level);
+
+    QString m_dir;
+    QStringList m_names;
+    QFile *files[LevelCount];
+    Bucket buckets[LevelCount];
+    qint64 m_last;
+};
+
+#endif // TRENDSTORE_H
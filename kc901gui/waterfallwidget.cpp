@@ -0,0 +1,104 @@
+#include "waterfallwidget.h"
+#include <QPainter>
+
+WaterfallWidget::WaterfallWidget(QWidget *parent) :
+    QWidget(parent),
+    m_rows(500),
+    head(0),
+    filled(0),
+    m_min(-40),
+    m_max(0),
+    fstart(0),
+    fstop(0)
+{
+    //blue - cyan - green - yellow - red
+    for(int i = 0; i < 256; i++)
+    {
+        qreal t = i / 255.0 * 4;
+        int seg = qMin(int(t), 3);
+        int f = int((t - seg) * 255);
+        switch(seg)
+        {
+        case 0: lut[i] = qRgb(0, f, 255); break;
+        case 1: lut[i] = qRgb(0, 255, 255 - f); break;
+        case 2: lut[i] = qRgb(f, 255, 0); break;
+        default: lut[i] = qRgb(255, 255 - f, 0); break;
+        }
+    }
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void WaterfallWidget::setRows(int rows)
+{
+    m_rows = qMax(1, rows);
+    image = QImage();
+    clear();
+}
+
+void WaterfallWidget::setRange(qreal min, qreal max)
+{
+    m_min = min;
+    m_max = max > min ? max : min + 1;
+}
+
+void WaterfallWidget::clear()
+{
+    head = 0;
+    filled = 0;
+    update();
+}
+
+void WaterfallWidget::addSweep(const QVector<qreal> &freq, const QVector<qreal> &values)
+{
+    int n = qMin(freq.size(), values.size());
+    if(n == 0) return;
+    if(image.width() != n || image.height() != m_rows
+            || freq.first() != fstart || freq.last() != fstop)
+    {
+        image = QImage(n, m_rows, QImage::Format_RGB32);
+        fstart = freq.first();
+        fstop = freq.last();
+        head = 0;
+        filled = 0;
+    }
+
+    //rows run newest to oldest from head, so the ring is written backwards
+    head = (head + m_rows - 1) % m_rows;
+    QRgb *row = reinterpret_cast<QRgb *>(image.scanLine(head));
+    qreal scale = 255.0 / (m_max - m_min);
+    for(int i = 0; i < n; i++)
+    {
+        qreal v = (values[i] - m_min) * scale;
+        int index = v > 0 ? (v < 255 ? int(v) : 255) : 0;
+        row[i] = lut[index];
+    }
+    if(filled < m_rows) filled++;
+    update();
+}
+
+void WaterfallWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    if(filled == 0) return;
+
+    //newest row on top: [head, end of ring) then the wrapped part [0, ...)
+    qreal rowHeight = qreal(height()) / m_rows;
+    int first = qMin(filled, m_rows - head);
+    int second = filled - first;
+    QRectF target(0, 0, width(), first * rowHeight);
+    painter.drawImage(target, image, QRectF(0, head, image.width(), first));
+    if(second > 0)
+    {
+        target = QRectF(0, first * rowHeight, width(), second * rowHeight);
+        painter.drawImage(target, image, QRectF(0, 0, image.width(), second));
+    }
+
+    painter.setPen(Qt::white);
+    painter.drawText(rect().adjusted(4, 0, -4, -2), Qt::AlignLeft | Qt::AlignBottom,
+                     QString("%1 MHz").arg(fstart / 1e6, 0, 'f', 3));
+    painter.drawText(rect().adjusted(4, 0, -4, -2), Qt::AlignRight | Qt::AlignBottom,
+                     QString("%1 MHz").arg(fstop / 1e6, 0, 'f', 3));
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignRight | Qt::AlignTop,
+                     QString("%1 .. %2 dB").arg(m_min).arg(m_max));
+}
@@ -0,0 +1,46 @@
+#ifndef WATERFALLWIDGET_H
+#define WATERFALLWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QVector>
+
+/// Waterfall of dB traces, frequency on x and time on y
+/**
+Sweeps are kept as rows of a fixed size image used as a ring: a new
+sweep is one row written through a 256 entry colour table, and the
+newest row is found by an offset instead of scrolling the history.
+Painting is two blits, one on each side of the ring head.
+*/
+class WaterfallWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit WaterfallWidget(QWidget *parent = 0);
+
+    void setRows(int rows);
+    int rows() const { return m_rows; }
+
+    /// Colour scale limits, in dB
+    void setRange(qreal min, qreal max);
+
+    /// Adds a sweep, a new frequency grid restarts the history
+    void addSweep(const QVector<qreal> &freq, const QVector<qreal> &values);
+
+public slots:
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    QImage image;
+    QRgb lut[256];
+    int m_rows;
+    int head;
+    int filled;
+    qreal m_min, m_max;
+    qreal fstart, fstop;
+};
+
+#endif // WATERFALLWIDGET_H
@@ -0,0 +1,163 @@
+#include "wirecapture.h"
+#include <QFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QTimer>
+#include <string.h>
+
+static const char Magic[8] = "KCWIRE1";
+
+WireCapture::WireCapture() :
+    file(0),
+    out(0),
+    m_records(0)
+{
+}
+
+WireCapture::~WireCapture()
+{
+    stop();
+}
+
+bool WireCapture::start(const QString &fileName, QString *error)
+{
+    stop();
+    file = new QFile(fileName);
+    if(!file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if(error) *error = file->errorString();
+        delete file;
+        file = 0;
+        return false;
+    }
+    out = new QDataStream(file);
+    out->writeRawData(Magic, sizeof(Magic));
+    *out << QDateTime::currentMSecsSinceEpoch();
+    clock.start();
+    m_records = 0;
+    return true;
+}
+
+void WireCapture::stop()
+{
+    if(!file) return;
+    delete out;
+    out = 0;
+    file->close();
+    delete file;
+    file = 0;
+}
+
+void WireCapture::record(Direction direction, const char *data, qint64 size)
+{
+    if(!file || size <= 0) return;
+    *out << quint8(direction) << quint64(clock.nsecsElapsed() / 1000) << quint32(size);
+    out->writeRawData(data, size);
+    m_records++;
+}
+
+WireReplay::WireReplay(QObject *parent) :
+    QObject(parent),
+    m_speed(1),
+    m_running(false),
+    m_next(0),
+    m_emitted(0)
+{
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+bool WireReplay::load(const QString &fileName, QString *error)
+{
+    stop();
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        if(error) *error = file.errorString();
+        return false;
+    }
+    QDataStream in(&file);
+    char magic[sizeof(Magic)];
+    qint64 started;
+    if(in.readRawData(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, Magic, sizeof(Magic)) != 0)
+    {
+        if(error) *error = "not a capture file";
+        return false;
+    }
+    in >> started;
+
+    QVector<Record> loaded;
+    while(!in.atEnd())
+    {
+        Record r;
+        quint32 size;
+        in >> r.direction >> r.time >> size;
+        if(in.status() != QDataStream::Ok) break;
+        //a size beyond the end of the file is a corrupt record, not an allocation
+        if(size > file.size() - file.pos())
+        {
+            if(error) *error = QString("corrupt record %1, %2 bytes").arg(loaded.size() + 1).arg(size);
+            return false;
+        }
+        r.data.resize(size);
+        if(in.readRawData(r.data.data(), size) != int(size)) break;
+        loaded.append(r);
+    }
+    if(in.status() != QDataStream::Ok || !in.atEnd())
+    {
+        if(error) *error = QString("truncated after %1 records").arg(loaded.size());
+        return false;
+    }
+    records = loaded;
+    return true;
+}
+
+void WireReplay::start(qreal speed)
+{
+    stop();
+    m_speed = speed;
+    m_next = 0;
+    m_emitted = 0;
+    m_running = true;
+    clock.start();
+    timer->start(0);
+}
+
+void WireReplay::stop()
+{
+    timer->stop();
+    m_running = false;
+}
+
+void WireReplay::tick()
+//emit every chunk that is due, then sleep until the next one
+{
+    quint64 base = records.isEmpty() ? 0 : records.first().time;
+    while(m_next < records.size())
+    {
+        const Record &r = records[m_next];
+        if(m_speed > 0)
+        {
+            qint64 due = qint64((r.time - base) / m_speed / 1000);
+            qint64 wait = due - clock.elapsed();
+            if(wait > 0)
+            {
+                timer->start(int(wait));
+                return;
+            }
+        }
+        m_next++;
+        if(r.direction != WireCapture::Received) continue;
+        m_emitted++;
+        emit received(r.data);
+        //back to the event loop between chunks, like the socket would
+        if(m_speed <= 0)
+        {
+            timer->start(0);
+            return;
+        }
+    }
+    m_running = false;
+    emit finished(m_emitted, clock.elapsed());
+}
@@ -0,0 +1,97 @@
+#ifndef WIRECAPTURE_H
+#define WIRECAPTURE_H
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+class QFile;
+class QDataStream;
+class QTimer;
+
+/// Records the instrument connection byte for byte
+/**
+Every chunk read from the socket and every command written is stored
+with its direction and a microsecond timestamp, one record per chunk so
+the fragmentation of the replies is kept:
+
+    "KCWIRE1\0", qint64 capture start (ms since the epoch)
+    records: quint8 direction, quint64 us since start, quint32 size, bytes
+
+Integers in QDataStream (big endian) order.
+*/
+class WireCapture
+{
+public:
+    enum Direction {
+        Received = 0,
+        Sent
+    };
+
+    WireCapture();
+    ~WireCapture();
+
+    bool start(const QString &fileName, QString *error = 0);
+    void stop();
+    bool isActive() const { return file != 0; }
+
+    void record(Direction direction, const char *data, qint64 size);
+    void record(Direction direction, const QByteArray &data) { record(direction, data.constData(), data.size()); }
+
+    int records() const { return m_records; }
+
+private:
+    QFile *file;
+    QDataStream *out;
+    QElapsedTimer clock;
+    int m_records;
+};
+
+/// Plays a capture back into the receive path
+/**
+Received chunks are emitted with their original boundaries, at the
+recorded pace divided by speed, or back to back with speed 0. Sent
+records only move the clock. finished() reports the wall time, which
+makes a capture a repeatable load for benchmarking the parser and the
+display.
+*/
+class WireReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WireReplay(QObject *parent = 0);
+
+    bool load(const QString &fileName, QString *error = 0);
+    int chunks() const { return records.size(); }
+
+    /// 1 plays at the recorded pace, 0 as fast as possible
+    void start(qreal speed);
+    void stop();
+    bool isRunning() const { return m_running; }
+
+signals:
+    void received(const QByteArray &chunk);
+    void finished(int chunks, qint64 elapsedMs);
+
+private slots:
+    void tick();
+
+private:
+    struct Record {
+        quint8 direction;
+        quint64 time;
+        QByteArray data;
+    };
+
+    QVector<Record> records;
+    QTimer *timer;
+    QElapsedTimer clock;
+    qreal m_speed;
+    bool m_running;
+    int m_next;
+    int m_emitted;
+};
+
+#endif // WIRECAPTURE_H